@@ -6,6 +6,7 @@
 #include "contiki-lib.h"
 #include "contiki-net.h"
 #include "net/ipv6/multicast/uip-mcast6.h"
+#include "net/ipv6/multicast/uip-mcast6-telemetry.h"
 
 #include <string.h>
 
@@ -57,6 +58,9 @@ static void handle_received_data(void)
                    (unsigned long)duplicate_count,
                    efficiency);
             exit_process = 1;  // Đánh dấu để thoát
+#if UIP_MCAST6_TELEMETRY
+            uip_mcast6_telemetry_send();
+#endif
         }
     }
 }
@@ -91,6 +95,10 @@ PROCESS_THREAD(mcast_sink_process, ev, data)
 {
     PROCESS_BEGIN();
 
+#if UIP_MCAST6_TELEMETRY
+    process_start(&uip_mcast6_telemetry_process, NULL);
+#endif
+
     // Tham gia nhóm multicast, kiểm tra nếu thất bại
     if (join_multicast_group() == NULL) {
         PRINTF("Failed to join multicast group\n");
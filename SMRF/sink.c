@@ -2,6 +2,7 @@
 #include "contiki-lib.h"
 #include "contiki-net.h"
 #include "net/ipv6/multicast/uip-mcast6.h"
+#include "net/ipv6/multicast/uip-mcast6-telemetry.h"
 
 #include <string.h>
 #include <stdio.h>
@@ -61,6 +62,9 @@ tcpip_handler(void)
       // Tính thời gian truyền tín hiệu
       uint32_t total_tx_time = (tx_end_time - tx_start_time) * 1000 / CLOCK_SECOND;
       PRINTF("Total TX Time: %lu ms\n", total_tx_time);
+#if UIP_MCAST6_TELEMETRY
+      uip_mcast6_telemetry_send();
+#endif
      
 
     } else {
@@ -111,6 +115,10 @@ PROCESS_THREAD(mcast_sink_process, ev, data)
 
   PRINTF("Multicast Engine: '%s'\n", UIP_MCAST6.name);
 
+#if UIP_MCAST6_TELEMETRY
+  process_start(&uip_mcast6_telemetry_process, NULL);
+#endif
+
   if(join_mcast_group() == NULL) {
     PRINTF("Failed to join multicast group\n");
     PROCESS_EXIT();
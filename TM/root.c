@@ -11,6 +11,7 @@
 #include "net/rpl/rpl.h"
 
 #define MAX_PAYLOAD_LEN 120
+#define UIP_IP_BUF ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
 #define MCAST_SINK_UDP_PORT 3001 
 #define Imin (CLOCK_SECOND * 64) 
 #define Imax (CLOCK_SECOND * 132) 
@@ -30,6 +31,47 @@ static uint32_t last_id = -1;
 PROCESS(rpl_root_process, "TM root");
 AUTOSTART_PROCESSES(&rpl_root_process);
 /*---------------------------------------------------------------------------*/
+#if UIP_MCAST6_ENGINE == UIP_MCAST6_ENGINE_ROLL_TM
+/*
+ * Build the datagram in uip_buf ourselves, leaving room for the ROLL TM
+ * option after the IPv6 header, so the engine needn't slide the payload
+ */
+static void
+udp_send_reserved(const void *data, uint16_t len)
+{
+	struct uip_udp_hdr *udp;
+
+	UIP_IP_BUF->vtc = 0x60;
+	UIP_IP_BUF->tcflow = 0;
+	UIP_IP_BUF->flow = 0;
+	UIP_IP_BUF->ttl = mcast_conn->ttl;
+	uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, &mcast_conn->ripaddr);
+	uip_ds6_select_src(&UIP_IP_BUF->srcipaddr, &UIP_IP_BUF->destipaddr);
+
+	roll_tm_hbho_reserve(UIP_PROTO_UDP);
+
+	udp = (struct uip_udp_hdr *)&uip_buf[UIP_LLH_LEN + UIP_IPH_LEN +
+	                                     uip_ext_len];
+	udp->srcport = mcast_conn->lport;
+	udp->destport = mcast_conn->rport;
+	udp->udplen = uip_htons(UIP_UDPH_LEN + len);
+	memcpy((uint8_t *)udp + UIP_UDPH_LEN, data, len);
+	uip_len += UIP_UDPH_LEN + len;
+
+	/* The checksum skips uip_ext_len bytes of extension headers */
+	UIP_IP_BUF->len[0] = (uip_len - UIP_IPH_LEN) >> 8;
+	UIP_IP_BUF->len[1] = (uip_len - UIP_IPH_LEN) & 0xff;
+	udp->udpchksum = 0;
+	udp->udpchksum = ~(uip_udpchksum());
+	if(udp->udpchksum == 0) {
+		udp->udpchksum = 0xffff;
+	}
+
+	/* Writes the option over our headroom and sends it */
+	UIP_MCAST6.out();
+}
+#endif
+/*---------------------------------------------------------------------------*/
 static void
 multicast_send(void)
 {
@@ -55,7 +97,11 @@ multicast_send(void)
 	PRINTF(" (msg=0x%08lx)", (unsigned long)uip_ntohl(*((uint32_t *)buf)));
 	PRINTF(" %lu bytes\n", (unsigned long)sizeof(id));
 
+#if UIP_MCAST6_ENGINE == UIP_MCAST6_ENGINE_ROLL_TM
+  	udp_send_reserved(buf, sizeof(id));
+#else
   	uip_udp_packet_send(mcast_conn, buf, sizeof(id));
+#endif
 }
 /*---------------------------------------------------------------------------*/
 static void
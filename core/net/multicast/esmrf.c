@@ -44,6 +44,10 @@
 #include "contiki-net.h"
 #include "net/ipv6/multicast/uip-mcast6.h"
 #include "net/ipv6/multicast/uip-mcast6-route.h"
+#include "net/ipv6/multicast/uip-mcast6-dup.h"
+#include "net/ipv6/multicast/uip-mcast6-adapt.h"
+#include "net/ipv6/multicast/uip-mcast6-fwd.h"
+#include "net/ipv6/multicast/uip-mcast6-parent.h"
 #include "net/ipv6/multicast/uip-mcast6-stats.h"
 #include "net/ipv6/multicast/esmrf.h"
 #include "net/rpl/rpl.h"
@@ -71,11 +75,35 @@ extern uint16_t uip_slen;
 #if UIP_MCAST6_STATS
 static struct esmrf_stats stats;
 
+static const struct uip_mcast6_stats_desc stats_desc[] = {
+  UIP_MCAST6_STATS_DESC(esmrf_stats, icmp_out, 0),
+  UIP_MCAST6_STATS_DESC(esmrf_stats, icmp_in, 0),
+  UIP_MCAST6_STATS_DESC(esmrf_stats, icmp_bad, 0),
+  UIP_MCAST6_STATS_DESC(esmrf_stats, fwd_queue_full, 0),
+  UIP_MCAST6_STATS_DESC(esmrf_stats, fwd_queue_max, UIP_MCAST6_STATS_T_MAX),
+  UIP_MCAST6_STATS_DESC(esmrf_stats, reinject, 0),
+  UIP_MCAST6_STATS_DESC(esmrf_stats, reinject_ticks, 0),
+  UIP_MCAST6_STATS_DESC(esmrf_stats, batch_out, 0),
+  UIP_MCAST6_STATS_DESC(esmrf_stats, batch_in, 0),
+  UIP_MCAST6_STATS_DESC(esmrf_stats, parent_refresh, 0),
+  UIP_MCAST6_STATS_DESC(esmrf_stats, adapt_backoff, 0),
+};
+
 #define ESMRF_STATS_ADD(x) stats.x++
+#define ESMRF_STATS_MAX(x, v) do { \
+  if((v) > stats.x) { \
+    stats.x = (v); \
+  } \
+} while(0)
+#define ESMRF_STATS_TICKS(x, t) stats.x += (t)
 #define ESMRF_STATS_INIT() do { memset(&stats, 0, sizeof(stats)); } while(0)
+#define ESMRF_STATS_REF(x) (&stats.x)
 #else /* UIP_MCAST6_STATS */
 #define ESMRF_STATS_ADD(x)
+#define ESMRF_STATS_MAX(x, v)
+#define ESMRF_STATS_TICKS(x, t)
 #define ESMRF_STATS_INIT()
+#define ESMRF_STATS_REF(x) NULL
 #endif
 /*---------------------------------------------------------------------------*/
 /* Macros */
@@ -87,15 +115,34 @@ static struct esmrf_stats stats;
 /*---------------------------------------------------------------------------*/
 /* Internal Data */
 /*---------------------------------------------------------------------------*/
-static struct ctimer mcast_periodic;
-static uint8_t mcast_len;
-static uip_buf_t mcast_buf;
 static uint8_t fwd_delay;
 static uint8_t fwd_spread;
+
+/* Our preferred parent in each RPL instance */
+static struct uip_mcast6_parents parents;
 static struct uip_udp_conn *c;
+#if ESMRF_REINJECT_COPY
 static uip_ipaddr_t src_ip;
+#endif
 static uip_ipaddr_t des_ip;
 /*---------------------------------------------------------------------------*/
+/* Forwarding delay floor and spread bound: Fixed or tuned at runtime */
+#if ESMRF_ADAPTIVE
+static struct uip_mcast6_adapt adapt;
+
+#define ESMRF_FWD_MIN()         uip_mcast6_adapt_min_delay(&adapt)
+#define ESMRF_FWD_MAX_SPREAD()  uip_mcast6_adapt_spread(&adapt)
+#define ESMRF_ADAPT_UPDATE(bad) do { \
+  if(uip_mcast6_adapt_update(&adapt, (bad))) { \
+    ESMRF_STATS_ADD(adapt_backoff); \
+  } \
+} while(0)
+#else
+#define ESMRF_FWD_MIN()         ESMRF_MIN_FWD_DELAY
+#define ESMRF_FWD_MAX_SPREAD()  ESMRF_MAX_SPREAD
+#define ESMRF_ADAPT_UPDATE(bad) do { (void)(bad); } while(0)
+#endif
+/*---------------------------------------------------------------------------*/
 /* uIPv6 Pointers */
 /*---------------------------------------------------------------------------*/
 #define UIP_IP_BUF        ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
@@ -107,7 +154,6 @@ static uip_ipaddr_t des_ip;
 /*---------------------------------------------------------------------------*/
 static void icmp_input(void);
 static void icmp_output(void);
-static void mcast_fwd(void *p);
 int remove_ext_hdr(void);
 /*---------------------------------------------------------------------------*/
 /* Internal Data Structures */
@@ -115,14 +161,81 @@ int remove_ext_hdr(void);
 struct multicast_on_behalf{   /*  ICMP message of multicast_on_behalf */
   uint16_t mcast_port;
   uip_ipaddr_t mcast_ip;
-  uint8_t mcast_payload[UIP_BUFSIZE - UIP_LLH_LEN - UIP_IPUDPH_LEN];
+  uint8_t mcast_payload[];      /* Up to the end of the message */
 };
 #define UIP_ICMP_MOB 18 /* Size of multicast_on_behalf ICMP header */
+
+/*
+ * Compact on-behalf header, sent with ESMRF_ICMP_CODE_COMPACT
+ *
+ *  0                   1                   2
+ *  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-
+ * |  G  |  Index  |          Port                 | Group...
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-
+ *
+ * G tells us how many bytes of the group are inline. The first four values
+ * follow IPHC's DAM for multicast destinations (M=1, DAC=0). With
+ * MOB_GROUP_CONTEXT, the group is group_contexts[Index]
+ */
+#define MOB_GROUP_FULL       0  /* Inline: All 128 bits */
+#define MOB_GROUP_48         1  /* ffXX::00XX:XXXX:XXXX. Inline: 48 bits */
+#define MOB_GROUP_32         2  /* ffXX::00XX:XXXX. Inline: 32 bits */
+#define MOB_GROUP_8          3  /* ff02::00XX. Inline: 8 bits */
+#define MOB_GROUP_CONTEXT    4  /* Nothing inline */
+#define MOB_COMPACT_HDR_LEN  3
+
+#define MOB_GET_G(f)         ((f) >> 5)
+#define MOB_GET_INDEX(f)     ((f) & 0x1F)
+
+/* Senders need the compact encoder for either format */
+#define MOB_COMPRESS         (ESMRF_COMPACT_MOB || ESMRF_BATCH)
+
+/* Number of inline group bytes, indexed by G */
+static const uint8_t mob_inline_len[] = { 16, 6, 4, 1, 0 };
+
+#if ESMRF_GROUP_CONTEXTS
+static uip_ipaddr_t group_contexts[ESMRF_GROUP_CONTEXTS];
+
+#define GROUP_CONTEXT_SET(i, ...) uip_ip6addr(&group_contexts[i], __VA_ARGS__)
+#endif
+
+#if ESMRF_BATCH
+/*
+ * A batch (ESMRF_ICMP_CODE_BATCH) is a sequence of records, each one:
+ * | Payload length (1 byte) | Compact on-behalf header | Payload |
+ *
+ * Senders build the batch in batch_buf. The root copies received batches
+ * there before unpacking them, since every re-injection trashes uip_buf
+ */
+#define BATCH_REC_HDR_LEN    1
+#define BATCH_REC_MAX_PAYLOAD 0xFF
+
+#if ESMRF_BATCH_BUDGET > UIP_BUFSIZE - UIP_LLH_LEN - UIP_IPH_LEN - UIP_ICMPH_LEN
+#error "ESMRF_CONF_BATCH_BUDGET does not fit in uip_buf"
+#endif
+
+static struct ctimer batch_timer;
+static uint8_t batch_buf[ESMRF_BATCH_BUDGET];
+static uint16_t batch_len;
+static uip_ipaddr_t batch_src;
+#endif
+
+/* Datagrams pending transmission, tagged with where they came from */
+UIP_MCAST6_FWD(fwd_queue, ESMRF_FWD_QUEUE);
+
+#define FWD_SLOT_RELAYED     0  /* From our parent, on its way down the DODAG */
+#define FWD_SLOT_ON_BEHALF   1  /* Root only: Re-injected for another node */
 /*---------------------------------------------------------------------------*/
 /* Temporary Stores */
 /*---------------------------------------------------------------------------*/
 static struct multicast_on_behalf *locmobptr;
 static int loclen;
+
+/* The on-behalf header of the message in uip_buf, as parsed by mob_parse() */
+static uip_ipaddr_t mob_group;
+static uint16_t mob_port;       /* Network byte order */
+static uint8_t *mob_payload;
 /*---------------------------------------------------------------------------*/
 /* ESMRF ICMPv6 handler declaration */
 UIP_ICMP6_HANDLER(esmrf_icmp_handler, ICMP6_ESMRF,
@@ -133,16 +246,176 @@ void uip_clear_buf(void) {
   memset(uip_buf, 0, UIP_BUFSIZE);  // Xóa toàn bộ bộ đệm
   uip_len = 0;                     // Đặt chiều dài gói dữ liệu về 0
 }
+/*---------------------------------------------------------------------------*/
+#if MOB_COMPRESS
+/* Are bytes [from, to] of address a all zero? */
+static uint8_t
+addr_zero(const uip_ipaddr_t *a, uint8_t from, uint8_t to)
+{
+  for(; from <= to; from++) {
+    if(a->u8[from]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Pick the most compact representation of group g. Returns the flags byte */
+static uint8_t
+mob_compress_flags(const uip_ipaddr_t *g)
+{
+#if ESMRF_GROUP_CONTEXTS
+  uint8_t i;
 
+  for(i = 0; i < ESMRF_GROUP_CONTEXTS; i++) {
+    if(uip_ipaddr_cmp(g, &group_contexts[i])) {
+      return (MOB_GROUP_CONTEXT << 5) | i;
+    }
+  }
+#endif
+
+  if(g->u8[1] == 0x02 && addr_zero(g, 2, 14)) {
+    return MOB_GROUP_8 << 5;
+  } else if(addr_zero(g, 2, 12)) {
+    return MOB_GROUP_32 << 5;
+  } else if(addr_zero(g, 2, 10)) {
+    return MOB_GROUP_48 << 5;
+  }
+  return MOB_GROUP_FULL << 5;
+}
+/*---------------------------------------------------------------------------*/
+/* Write a compact on-behalf header at buf */
 static void
-icmp_output()
+mob_compress(uint8_t *buf, uint8_t flags, const uip_ipaddr_t *g,
+             uint16_t port)
 {
-  uint16_t payload_len=0;
-  rpl_dag_t *dag_t;
+  buf[0] = flags;
+  memcpy(&buf[1], &port, sizeof(port));
+  buf += MOB_COMPACT_HDR_LEN;
 
-  struct multicast_on_behalf *mob;
-  mob = (struct multicast_on_behalf *)UIP_ICMP_PAYLOAD;
-  memcpy(&mob->mcast_payload, &uip_buf[UIP_LLH_LEN + UIP_IPUDPH_LEN], uip_slen);
+  switch(MOB_GET_G(flags)) {
+  case MOB_GROUP_FULL:
+    memcpy(buf, g, sizeof(uip_ipaddr_t));
+    break;
+  case MOB_GROUP_48:
+    buf[0] = g->u8[1];
+    memcpy(&buf[1], &g->u8[11], 5);
+    break;
+  case MOB_GROUP_32:
+    buf[0] = g->u8[1];
+    memcpy(&buf[1], &g->u8[13], 3);
+    break;
+  case MOB_GROUP_8:
+    buf[0] = g->u8[15];
+    break;
+  }
+}
+#endif /* MOB_COMPRESS */
+/*---------------------------------------------------------------------------*/
+/*
+ * Parse the compact on-behalf header at hdr, followed by len - header bytes
+ * of payload, into mob_group, mob_port, mob_payload and loclen. Returns 0 if
+ * it's malformed
+ */
+static uint8_t
+mob_parse_compact(uint8_t *hdr, int len)
+{
+  uint8_t g;
+
+  if(len < MOB_COMPACT_HDR_LEN) {
+    return 0;
+  }
+  g = MOB_GET_G(hdr[0]);
+  if(g > MOB_GROUP_CONTEXT ||
+     len < MOB_COMPACT_HDR_LEN + mob_inline_len[g]) {
+    return 0;
+  }
+
+  memcpy(&mob_port, &hdr[1], sizeof(mob_port));
+  mob_payload = hdr + MOB_COMPACT_HDR_LEN;
+  loclen = len - MOB_COMPACT_HDR_LEN - mob_inline_len[g];
+
+  memset(&mob_group, 0, sizeof(mob_group));
+  mob_group.u8[0] = 0xFF;
+
+  switch(g) {
+  case MOB_GROUP_FULL:
+    memcpy(&mob_group, mob_payload, sizeof(mob_group));
+    break;
+  case MOB_GROUP_48:
+    mob_group.u8[1] = mob_payload[0];
+    memcpy(&mob_group.u8[11], &mob_payload[1], 5);
+    break;
+  case MOB_GROUP_32:
+    mob_group.u8[1] = mob_payload[0];
+    memcpy(&mob_group.u8[13], &mob_payload[1], 3);
+    break;
+  case MOB_GROUP_8:
+    mob_group.u8[1] = 0x02;
+    mob_group.u8[15] = mob_payload[0];
+    break;
+  case MOB_GROUP_CONTEXT:
+#if ESMRF_GROUP_CONTEXTS
+    if(MOB_GET_INDEX(hdr[0]) < ESMRF_GROUP_CONTEXTS) {
+      uip_ipaddr_copy(&mob_group, &group_contexts[MOB_GET_INDEX(hdr[0])]);
+      break;
+    }
+#endif
+    PRINTF("ESMRF: Unknown group context %u\n", MOB_GET_INDEX(hdr[0]));
+    return 0;
+  }
+  mob_payload += mob_inline_len[g];
+
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Parse the on-behalf header in uip_buf into mob_group, mob_port, mob_payload
+ * and loclen. Returns 0 if the message is malformed
+ */
+static uint8_t
+mob_parse(void)
+{
+  uint8_t *hdr;
+  int len;
+
+  hdr = UIP_ICMP_PAYLOAD;
+  len = uip_len - uip_l2_l3_icmp_hdr_len;
+
+  if(UIP_ICMP_BUF->icode == ESMRF_ICMP_CODE_COMPACT) {
+    if(!mob_parse_compact(hdr, len)) {
+      return 0;
+    }
+  } else {
+    if(len < UIP_ICMP_MOB) {
+      return 0;
+    }
+    locmobptr = (struct multicast_on_behalf *)hdr;
+    mob_port = locmobptr->mcast_port;
+    uip_ipaddr_copy(&mob_group, &locmobptr->mcast_ip);
+    mob_payload = locmobptr->mcast_payload;
+    loclen = len - UIP_ICMP_MOB;
+  }
+
+  /*
+   * ICMPv6 and a compact header with a group context take up less room than
+   * the UDP header the root rebuilds, so the payload must still fit after it
+   */
+  if(UIP_IPUDPH_LEN + loclen > UIP_BUFSIZE - UIP_LLH_LEN) {
+    PRINTF("ESMRF: %d payload bytes don't fit in a datagram\n", loclen);
+    return 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Add IPv6 and ICMPv6 headers to the ESMRF message body already at
+ * UIP_ICMP_PAYLOAD and send it to the DODAG root
+ */
+static void
+icmp_send(uint8_t code, uint16_t payload_len)
+{
+  rpl_dag_t *dag_t;
 
   UIP_IP_BUF->vtc = 0x60;
   UIP_IP_BUF->tcflow = 0;
@@ -150,16 +423,12 @@ icmp_output()
   UIP_IP_BUF->proto = UIP_PROTO_ICMP6;
   UIP_IP_BUF->ttl = ESMRF_IP_HOP_LIMIT;
 
-  mob->mcast_port = (uint16_t) uip_udp_conn->rport;
-  uip_ipaddr_copy(&mob->mcast_ip, &UIP_IP_BUF->destipaddr);
-
-  payload_len = UIP_ICMP_MOB + uip_slen;
-
   dag_t = rpl_get_any_dag();
   uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, &dag_t->dag_id);
   uip_ds6_select_src(&UIP_IP_BUF->srcipaddr, &UIP_IP_BUF->destipaddr);
 
-  VERBOSE_PRINTF("ESMRF: ICMPv6 Out - Hdr @ %p, payload @ %p to: ", UIP_ICMP_BUF, mob);
+  VERBOSE_PRINTF("ESMRF: ICMPv6 Out - Hdr @ %p, payload @ %p to: ",
+                 UIP_ICMP_BUF, UIP_ICMP_PAYLOAD);
   PRINT6ADDR(&UIP_IP_BUF->destipaddr);
   PRINTF("\n");
 
@@ -167,7 +436,7 @@ icmp_output()
   UIP_IP_BUF->len[1] = (UIP_ICMPH_LEN + payload_len) & 0xff;
 
   UIP_ICMP_BUF->type = ICMP6_ESMRF;
-  UIP_ICMP_BUF->icode = ESMRF_ICMP_CODE;
+  UIP_ICMP_BUF->icode = code;
 
   UIP_ICMP_BUF->icmpchksum = 0;
   UIP_ICMP_BUF->icmpchksum = ~uip_icmp6chksum();
@@ -179,129 +448,450 @@ icmp_output()
 
   tcpip_ipv6_output();
   ESMRF_STATS_ADD(icmp_out);
-  return;
 }
 /*---------------------------------------------------------------------------*/
 static void
-icmp_input()
+icmp_output()
 {
-#if UIP_CONF_IPV6_CHECKS
-  if(UIP_ICMP_BUF->icode != ESMRF_ICMP_CODE) {
-    PRINTF("ESMRF: ICMPv6 In, bad ICMP code\n");
-    ESMRF_STATS_ADD(icmp_bad);
+  uint8_t hdr_len;
+
+#if ESMRF_COMPACT_MOB
+  uint8_t flags;
+
+  flags = mob_compress_flags(&UIP_IP_BUF->destipaddr);
+  hdr_len = MOB_COMPACT_HDR_LEN + mob_inline_len[MOB_GET_G(flags)];
+#else
+  hdr_len = UIP_ICMP_MOB;
+#endif
+
+  /* The payload is already in uip_buf. Old and new locations may overlap */
+  memmove(UIP_ICMP_PAYLOAD + hdr_len, &uip_buf[UIP_LLH_LEN + UIP_IPUDPH_LEN],
+          uip_slen);
+
+#if ESMRF_COMPACT_MOB
+  mob_compress(UIP_ICMP_PAYLOAD, flags, &UIP_IP_BUF->destipaddr,
+               uip_udp_conn->rport);
+#else
+  struct multicast_on_behalf *mob;
+  mob = (struct multicast_on_behalf *)UIP_ICMP_PAYLOAD;
+
+  mob->mcast_port = (uint16_t) uip_udp_conn->rport;
+  uip_ipaddr_copy(&mob->mcast_ip, &UIP_IP_BUF->destipaddr);
+#endif
+
+#if ESMRF_COMPACT_MOB
+  icmp_send(ESMRF_ICMP_CODE_COMPACT, hdr_len + uip_slen);
+#else
+  icmp_send(ESMRF_ICMP_CODE, hdr_len + uip_slen);
+#endif
+}
+/*---------------------------------------------------------------------------*/
+#if ESMRF_BATCH
+/* Send the batch, already copied to the ICMPv6 payload in uip_buf */
+static void
+batch_send(void)
+{
+  PRINTF("ESMRF: Batch out, %u bytes\n", batch_len);
+
+  icmp_send(ESMRF_ICMP_CODE_BATCH, batch_len);
+  ESMRF_STATS_ADD(batch_out);
+  batch_len = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Send everything held in batch_buf as a single on-behalf message */
+static void
+batch_flush(void *p)
+{
+  if(batch_len == 0) {
     return;
   }
-  if(UIP_IP_BUF->ttl <= 1) {
-    PRINTF("ESMRF: ICMPv6 In, bad TTL\n");
-    ESMRF_STATS_ADD(icmp_bad);
+
+  if(rpl_get_any_dag() == NULL) {
+    PRINTF("ESMRF: No DODAG, %u batched bytes dropped\n", batch_len);
+    UIP_MCAST6_STATS_ADD(mcast_dropped);
+    batch_len = 0;
     return;
   }
-#endif
 
-  remove_ext_hdr();
+  uip_ext_len = 0;
+  memcpy(UIP_ICMP_PAYLOAD, batch_buf, batch_len);
+  batch_send();
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * The datagram in uip_buf doesn't fit in what's left of the budget. Send the
+ * pending batch ahead of it, so that the root re-injects datagrams in the
+ * order we sent them. The batch needs uip_buf, so meanwhile the datagram's
+ * payload waits in batch_buf, trading places with the batch, or in a free
+ * forwarding slot if it's larger than the budget. Returns 0 if there was
+ * nowhere to keep it, in which case nothing was sent
+ */
+static uint8_t
+batch_flush_ahead(void)
+{
+  uip_ipaddr_t group;
+  struct uip_mcast6_fwd_slot *slot;
+  uint8_t *payload;
+  uint8_t *park;
+  uint16_t i;
+  uint16_t n;
+  uint8_t t;
 
-  PRINTF("ESMRF: ICMPv6 In from ");
-  PRINT6ADDR(&UIP_IP_BUF->srcipaddr);
-  PRINTF(" len %u, ext %u\n", uip_len, uip_ext_len);
+  payload = &uip_buf[UIP_LLH_LEN + UIP_IPUDPH_LEN];
+  uip_ext_len = 0;
 
-  ESMRF_STATS_ADD(icmp_in);
+  if(uip_slen <= ESMRF_BATCH_BUDGET) {
+    memmove(UIP_ICMP_PAYLOAD, payload, uip_slen);
+    n = batch_len > uip_slen ? batch_len : uip_slen;
+    for(i = 0; i < n; i++) {
+      t = batch_buf[i];
+      batch_buf[i] = UIP_ICMP_PAYLOAD[i];
+      UIP_ICMP_PAYLOAD[i] = t;
+    }
+    park = batch_buf;
+  } else {
+    slot = uip_mcast6_fwd_alloc(&fwd_queue);
+    if(slot == NULL) {
+      return 0;
+    }
+    park = slot->buf.u8;
+    memcpy(park, payload, uip_slen);
+    memcpy(UIP_ICMP_PAYLOAD, batch_buf, batch_len);
+  }
 
-  VERBOSE_PRINTF("ESMRF: ICMPv6 In, parse from %p to %p\n",
-                 UIP_ICMP_PAYLOAD,
-                 (uint8_t *)UIP_ICMP_PAYLOAD + uip_len -
-                 uip_l2_l3_icmp_hdr_len);
+  /* icmp_send() rewrites the IPv6 header, so hold on to the group */
+  uip_ipaddr_copy(&group, &UIP_IP_BUF->destipaddr);
+  ctimer_stop(&batch_timer);
+  batch_send();
 
+  memcpy(payload, park, uip_slen);
+  uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, &group);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Append the datagram in uip_buf to the pending batch. Returns 0 if it does
+ * not fit in what's left of the budget, in which case nothing is appended
+ */
+static uint8_t
+batch_add(void)
+{
+  uint8_t flags;
+  uint16_t rec_len;
+  uint8_t *rec;
 
-  locmobptr = (struct multicast_on_behalf *) UIP_ICMP_PAYLOAD;
-  loclen = uip_len - (uip_l2_l3_icmp_hdr_len + UIP_ICMP_MOB);
+  if(uip_slen > BATCH_REC_MAX_PAYLOAD) {
+    return 0;
+  }
+
+  flags = mob_compress_flags(&UIP_IP_BUF->destipaddr);
+  rec_len = BATCH_REC_HDR_LEN + MOB_COMPACT_HDR_LEN +
+    mob_inline_len[MOB_GET_G(flags)] + uip_slen;
+  if(batch_len + rec_len > ESMRF_BATCH_BUDGET) {
+    return 0;
+  }
+
+  rec = &batch_buf[batch_len];
+  rec[0] = uip_slen;
+  mob_compress(&rec[BATCH_REC_HDR_LEN], flags, &UIP_IP_BUF->destipaddr,
+               uip_udp_conn->rport);
+  memcpy(&rec[rec_len - uip_slen], &uip_buf[UIP_LLH_LEN + UIP_IPUDPH_LEN],
+         uip_slen);
+
+  /* The first record starts the hold time */
+  if(batch_len == 0) {
+    ctimer_set(&batch_timer, ESMRF_BATCH_HOLD, batch_flush, NULL);
+  }
+  batch_len += rec_len;
+
+  PRINTF("ESMRF: Batched %u bytes, %u/%u\n", uip_slen, batch_len,
+         ESMRF_BATCH_BUDGET);
+  return 1;
+}
+#endif /* ESMRF_BATCH */
+/*---------------------------------------------------------------------------*/
+/* Fill in the UDP checksum of the datagram in uip_buf */
+static void
+udp_chksum_set(void)
+{
+  UIP_UDP_BUF->udpchksum = 0;
+#if UIP_UDP_CHECKSUMS
+  UIP_UDP_BUF->udpchksum = ~(uip_udpchksum());
+  if(UIP_UDP_BUF->udpchksum == 0) {
+    UIP_UDP_BUF->udpchksum = 0xffff;
+  }
+#endif
+}
+/*---------------------------------------------------------------------------*/
+#if ESMRF_REINJECT_COPY
+/*
+ * Legacy re-injection: Let uip_process() build the UDP datagram, deliver a
+ * copy of it locally and then queue it for forwarding
+ */
+static void
+reinject(void)
+{
+  struct uip_mcast6_fwd_slot *slot;
+  uip_mcast6_route_t *rt;
+
+  /*
+   * We need a slot of our own to hold the datagram while it's delivered
+   * locally. Datagrams already queued must not be touched
+   */
+  slot = uip_mcast6_fwd_alloc(&fwd_queue);
+  if(slot == NULL) {
+    PRINTF("ESMRF: Forwarding queue full\n");
+    ESMRF_STATS_ADD(fwd_queue_full);
+    UIP_MCAST6_STATS_ADD(mcast_dropped);
+    uip_clear_buf();
+    return;
+  }
 
   uip_ipaddr_copy(&src_ip, &UIP_IP_BUF->srcipaddr);
   uip_ipaddr_copy(&des_ip, &UIP_IP_BUF->destipaddr);
 
   /* Extract the original multicast message */
-  uip_ipaddr_copy(&c->ripaddr, &locmobptr->mcast_ip);
-  c->rport = locmobptr->mcast_port;
+  uip_ipaddr_copy(&c->ripaddr, &mob_group);
+  c->rport = mob_port;
   uip_slen = loclen;
   uip_udp_conn=c;
-  memcpy(&uip_buf[UIP_LLH_LEN + UIP_IPUDPH_LEN], locmobptr->mcast_payload,
-         loclen > UIP_BUFSIZE - UIP_LLH_LEN - UIP_IPUDPH_LEN?
-         UIP_BUFSIZE - UIP_LLH_LEN - UIP_IPUDPH_LEN: loclen);
+  memmove(&uip_buf[UIP_LLH_LEN + UIP_IPUDPH_LEN], mob_payload,
+          loclen > UIP_BUFSIZE - UIP_LLH_LEN - UIP_IPUDPH_LEN?
+          UIP_BUFSIZE - UIP_LLH_LEN - UIP_IPUDPH_LEN: loclen);
 
   uip_process(UIP_UDP_SEND_CONN);
 
-  memcpy(&mcast_buf, uip_buf, uip_len);
-  mcast_len = uip_len;
+  /*
+   * Return the IP of the original Multicast sender. Downstream duplicate
+   * suppression relies on the checksum, so it must match
+   */
+  uip_ipaddr_copy(&UIP_IP_BUF->srcipaddr, &src_ip);
+  udp_chksum_set();
+
+  memcpy(&slot->buf, uip_buf, uip_len);
+  slot->len = uip_len;
+  slot->origin = FWD_SLOT_ON_BEHALF;
   /* pass the packet to our uip_process to check if it is allowed to 
    * accept this packet or not */
-  uip_ipaddr_copy(&UIP_IP_BUF->srcipaddr, &src_ip);
   uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, &des_ip);
   UIP_UDP_BUF->udpchksum = 0;
   
   uip_process(UIP_DATA);
 
-  memcpy(uip_buf, &mcast_buf, mcast_len);
-  uip_len = mcast_len;
-  /* Return the IP of the original Multicast sender */
-  uip_ipaddr_copy(&UIP_IP_BUF->srcipaddr, &src_ip);
-  UIP_UDP_BUF->udpchksum = 0;
   /* If we have an entry in the multicast routing table, something with
    * a higher RPL rank (somewhere down the tree) is a group member */
-  if(uip_mcast6_route_lookup(&UIP_IP_BUF->destipaddr)) {
+  rt = uip_mcast6_route_lookup(&UIP_MCAST6_FWD_IP_BUF(slot)->destipaddr);
+  if(rt) {
     PRINTF("ESMRF: Forward this packet\n");
-    /* If we enter here, we will definitely forward */
-    tcpip_ipv6_output();
+    UIP_MCAST6_ROUTE_STATS_ADD(rt, fwd);
+    /* If we enter here, we will definitely forward, as soon as possible */
+    uip_mcast6_fwd_schedule(&fwd_queue, slot, 0);
+    ESMRF_STATS_MAX(fwd_queue_max, uip_mcast6_fwd_used(&fwd_queue));
+  } else {
+    slot->len = 0;
   }
   uip_clear_buf();
 }
+#else /* ESMRF_REINJECT_COPY */
+/*
+ * Turn the on-behalf message in uip_buf into the multicast UDP datagram it
+ * carries, in place. The source address is already the original sender's.
+ * We send it down the DODAG and then hand the very same buffer to our own
+ * stack, so the only copy is the payload sliding over the ICMPv6 headers
+ */
+static void
+reinject(void)
+{
+  uip_mcast6_route_t *rt;
+
+  uip_ipaddr_copy(&des_ip, &UIP_IP_BUF->destipaddr);
+  uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, &mob_group);
+
+  memmove(&uip_buf[UIP_LLH_LEN + UIP_IPUDPH_LEN], mob_payload, loclen);
+
+  uip_ext_len = 0;
+  uip_len = UIP_IPUDPH_LEN + loclen;
+
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->tcflow = 0;
+  UIP_IP_BUF->flow = 0;
+  UIP_IP_BUF->proto = UIP_PROTO_UDP;
+  UIP_IP_BUF->ttl = c->ttl;
+  UIP_IP_BUF->len[0] = ((uip_len - UIP_IPH_LEN) >> 8);
+  UIP_IP_BUF->len[1] = ((uip_len - UIP_IPH_LEN) & 0xff);
+
+  UIP_UDP_BUF->srcport = c->lport;
+  UIP_UDP_BUF->destport = mob_port;
+  UIP_UDP_BUF->udplen = UIP_HTONS(uip_len - UIP_IPH_LEN);
+  udp_chksum_set();
+
+  /* If we have an entry in the multicast routing table, something with
+   * a higher RPL rank (somewhere down the tree) is a group member */
+  rt = uip_mcast6_route_lookup(&UIP_IP_BUF->destipaddr);
+  if(rt) {
+    PRINTF("ESMRF: Forward this packet\n");
+    UIP_MCAST6_ROUTE_STATS_ADD(rt, fwd);
+    /* We only just got the on-behalf message */
+    UIP_MCAST6_STATS_LATENCY_ADD(UIP_MCAST6_LATENCY_ON_BEHALF, 0);
+    tcpip_output(NULL);
+  }
+
+  /*
+   * Deliver locally. Address it to us, otherwise the core would pass it to
+   * in(), which drops anything that didn't come from our preferred parent
+   */
+  uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, &des_ip);
+  UIP_UDP_BUF->udpchksum = 0;
+
+  uip_process(UIP_DATA);
+
+  /* Anything the application may have left in uip_buf is not for us to send */
+  uip_len = 0;
+  uip_ext_len = 0;
+}
+#endif /* ESMRF_REINJECT_COPY */
 /*---------------------------------------------------------------------------*/
+#if ESMRF_BATCH
+/* Root: Re-inject every record of the batch in uip_buf */
 static void
-mcast_fwd(void *p)
+batch_input(void)
 {
-  memcpy(uip_buf, &mcast_buf, mcast_len);
-  uip_len = mcast_len;
-  UIP_IP_BUF->ttl--;
-  tcpip_output(NULL);
-  uip_clear_buf();
+  uint16_t pos;
+  uint8_t *rec;
+
+  batch_len = uip_len - uip_l2_l3_icmp_hdr_len;
+  if(batch_len > ESMRF_BATCH_BUDGET) {
+    PRINTF("ESMRF: Batch of %u bytes exceeds our budget\n", batch_len);
+    ESMRF_STATS_ADD(icmp_bad);
+    batch_len = 0;
+    uip_len = 0;
+    return;
+  }
+
+  memcpy(batch_buf, UIP_ICMP_PAYLOAD, batch_len);
+  uip_ipaddr_copy(&batch_src, &UIP_IP_BUF->srcipaddr);
+  uip_ipaddr_copy(&des_ip, &UIP_IP_BUF->destipaddr);
+  ESMRF_STATS_ADD(batch_in);
+
+  for(pos = 0; pos < batch_len; pos += mob_payload - rec + loclen) {
+    rec = &batch_buf[pos];
+    if(!mob_parse_compact(&rec[BATCH_REC_HDR_LEN],
+                          batch_len - pos - BATCH_REC_HDR_LEN) ||
+       loclen < rec[0]) {
+      PRINTF("ESMRF: Bad batch record @ %u\n", pos);
+      ESMRF_STATS_ADD(icmp_bad);
+      break;
+    }
+    loclen = rec[0];
+
+    /* The previous record's delivery may have left anything in uip_buf */
+    uip_ext_len = 0;
+    uip_ipaddr_copy(&UIP_IP_BUF->srcipaddr, &batch_src);
+    uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, &des_ip);
+
+    reinject();
+    ESMRF_STATS_ADD(reinject);
+  }
+
+  batch_len = 0;
+  uip_len = 0;
 }
+#endif /* ESMRF_BATCH */
 /*---------------------------------------------------------------------------*/
-static uint8_t
-in()
+static void
+icmp_input()
 {
-  rpl_dag_t *d;                 /* Our DODAG */
-  uip_ipaddr_t *parent_ipaddr;  /* Our pref. parent's IPv6 address */
-  const uip_lladdr_t *parent_lladdr;  /* Our pref. parent's LL address */
+#if UIP_MCAST6_STATS
+  rtimer_clock_t start = RTIMER_NOW();
+#endif
 
-  /*
-   * Fetch a pointer to the LL address of our preferred parent
-   *
-   * ToDo: This rpl_get_any_dag() call is a dirty replacement of the previous
-   *   rpl_get_dag(RPL_DEFAULT_INSTANCE);
-   * so that things can compile with the new RPL code. This needs updated to
-   * read instance ID from the RPL HBHO and use the correct parent accordingly
-   */
-  d = rpl_get_any_dag();
-  if(!d) {
-    PRINTF("ESMRF: No DODAG\n");
-    UIP_MCAST6_STATS_ADD(mcast_dropped);
-    return UIP_MCAST6_DROP;
+#if UIP_CONF_IPV6_CHECKS
+  if(UIP_ICMP_BUF->icode != ESMRF_ICMP_CODE &&
+     UIP_ICMP_BUF->icode != ESMRF_ICMP_CODE_COMPACT
+#if ESMRF_BATCH
+     && UIP_ICMP_BUF->icode != ESMRF_ICMP_CODE_BATCH
+#endif
+     ) {
+    PRINTF("ESMRF: ICMPv6 In, bad ICMP code\n");
+    ESMRF_STATS_ADD(icmp_bad);
+    return;
+  }
+  if(UIP_IP_BUF->ttl <= 1) {
+    PRINTF("ESMRF: ICMPv6 In, bad TTL\n");
+    ESMRF_STATS_ADD(icmp_bad);
+    return;
   }
+#endif
 
-  /* Retrieve our preferred parent's LL address */
-  parent_ipaddr = rpl_get_parent_ipaddr(d->preferred_parent);
-  parent_lladdr = uip_ds6_nbr_lladdr_from_ipaddr(parent_ipaddr);
+  remove_ext_hdr();
 
-  if(parent_lladdr == NULL) {
-    PRINTF("ESMRF: NO Parent exist \n");
-    UIP_MCAST6_STATS_ADD(mcast_dropped);
-    return UIP_MCAST6_DROP;
+  PRINTF("ESMRF: ICMPv6 In from ");
+  PRINT6ADDR(&UIP_IP_BUF->srcipaddr);
+  PRINTF(" len %u, ext %u\n", uip_len, uip_ext_len);
+
+#if ESMRF_BATCH
+  if(UIP_ICMP_BUF->icode == ESMRF_ICMP_CODE_BATCH) {
+    ESMRF_STATS_ADD(icmp_in);
+    batch_input();
+    ESMRF_STATS_TICKS(reinject_ticks, RTIMER_NOW() - start);
+    return;
   }
+#endif
+
+  if(!mob_parse()) {
+    PRINTF("ESMRF: ICMPv6 In, bad on-behalf header\n");
+    ESMRF_STATS_ADD(icmp_bad);
+    uip_len = 0;
+    return;
+  }
+
+  ESMRF_STATS_ADD(icmp_in);
+
+  VERBOSE_PRINTF("ESMRF: ICMPv6 In, parse from %p to %p\n",
+                 UIP_ICMP_PAYLOAD,
+                 (uint8_t *)UIP_ICMP_PAYLOAD + uip_len -
+                 uip_l2_l3_icmp_hdr_len);
+
+  reinject();
+
+  ESMRF_STATS_ADD(reinject);
+  ESMRF_STATS_TICKS(reinject_ticks, RTIMER_NOW() - start);
+}
+/*---------------------------------------------------------------------------*/
+/* A queued datagram's delay expired. On-behalf ones already have their TTL */
+static void
+fwd_send(struct uip_mcast6_fwd_slot *slot, clock_time_t waited)
+{
+  if(slot->origin == FWD_SLOT_ON_BEHALF) {
+    UIP_MCAST6_STATS_LATENCY_ADD(UIP_MCAST6_LATENCY_ON_BEHALF, waited);
+    tcpip_ipv6_output();
+  } else {
+    uip_mcast6_fwd_relay(slot, waited);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+esmrf_parent_switch(struct rpl_parent *old, struct rpl_parent *new)
+{
+  PRINTF("ESMRF: Parent switch\n");
+  /* Rare enough not to bother working out which instance it was */
+  uip_mcast6_parent_flush(&parents);
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+in()
+{
+  struct uip_mcast6_fwd_slot *slot;
+  struct uip_mcast6_parent *pc; /* Our pref. parent, datagram's instance */
+  uip_mcast6_route_t *rt;       /* Route for the datagram's group, if any */
+  uint8_t bad;                  /* Feedback for the adaptive forwarding delay */
 
   /*
    * We accept a datagram if it arrived from our preferred parent, discard
    * otherwise.
    */
-  if(memcmp(parent_lladdr, packetbuf_addr(PACKETBUF_ADDR_SENDER),
-            UIP_LLADDR_LEN)) {
+  pc = uip_mcast6_parent_in(&parents);
+  if(pc == NULL) {
     PRINTF("ESMRF: Routable in but ESMRF ignored it\n");
     UIP_MCAST6_STATS_ADD(mcast_dropped);
     return UIP_MCAST6_DROP;
@@ -313,14 +903,26 @@ in()
   }
 
   UIP_MCAST6_STATS_ADD(mcast_in_all);
+
+  /* MAC-layer retransmissions, or a parent switch mid-flood */
+  if(uip_mcast6_dup_check()) {
+    PRINTF("ESMRF: Duplicate, dropped\n");
+    UIP_MCAST6_STATS_ADD(mcast_dropped);
+    UIP_MCAST6_ROUTE_STATS_ADD(
+      uip_mcast6_route_lookup(&UIP_IP_BUF->destipaddr), dropped);
+    ESMRF_ADAPT_UPDATE(1);
+    return UIP_MCAST6_DROP;
+  }
+
   UIP_MCAST6_STATS_ADD(mcast_in_unique);
+  bad = 0;
 
   /* If we have an entry in the mcast routing table, something with
    * a higher RPL rank (somewhere down the tree) is a group member */
-  if(uip_mcast6_route_lookup(&UIP_IP_BUF->destipaddr)) {
-    /* If we enter here, we will definitely forward */
-    UIP_MCAST6_STATS_ADD(mcast_fwd);
-
+  rt = uip_mcast6_route_lookup(&UIP_IP_BUF->destipaddr);
+  UIP_MCAST6_ROUTE_STATS_ADD(rt, in);
+  UIP_MCAST6_ROUTE_STATS_ADD_N(rt, bytes, uip_len);
+  if(rt) {
     /*
      * Add a delay (D) of at least ESMRF_FWD_DELAY() to compensate for how
      * contikimac handles broadcasts. We can't start our TX before the sender
@@ -328,35 +930,53 @@ in()
      */
     fwd_delay = ESMRF_FWD_DELAY();
 
-    /* Finalise D: D = min(ESMRF_FWD_DELAY(), ESMRF_MIN_FWD_DELAY) */
-#if ESMRF_MIN_FWD_DELAY
-    if(fwd_delay < ESMRF_MIN_FWD_DELAY) {
-      fwd_delay = ESMRF_MIN_FWD_DELAY;
+    /* Finalise D: D = min(ESMRF_FWD_DELAY(), ESMRF_FWD_MIN()) */
+#if ESMRF_ADAPTIVE || ESMRF_MIN_FWD_DELAY
+    if(fwd_delay < ESMRF_FWD_MIN()) {
+      fwd_delay = ESMRF_FWD_MIN();
     }
 #endif
 
     if(fwd_delay == 0) {
       /* No delay required, send it, do it now, why wait? */
+      UIP_MCAST6_STATS_ADD(mcast_fwd);
+      UIP_MCAST6_ROUTE_STATS_ADD(rt, fwd);
+      UIP_MCAST6_STATS_LATENCY_ADD(UIP_MCAST6_LATENCY_FWD, 0);
       UIP_IP_BUF->ttl--;
       tcpip_output(NULL);
       UIP_IP_BUF->ttl++;        /* Restore before potential upstack delivery */
     } else {
       /* Randomise final delay in [D , D*Spread], step D */
       fwd_spread = ESMRF_INTERVAL_COUNT;
-      if(fwd_spread > ESMRF_MAX_SPREAD) {
-        fwd_spread = ESMRF_MAX_SPREAD;
+      if(fwd_spread > ESMRF_FWD_MAX_SPREAD()) {
+        fwd_spread = ESMRF_FWD_MAX_SPREAD();
       }
       if(fwd_spread) {
         fwd_delay = fwd_delay * (1 + ((random_rand() >> 11) % fwd_spread));
       }
 
-      memcpy(&mcast_buf, uip_buf, uip_len);
-      mcast_len = uip_len;
-      ctimer_set(&mcast_periodic, fwd_delay, mcast_fwd, NULL);
+      /* Queue it. Datagrams already waiting keep their own deadline */
+      slot = uip_mcast6_fwd_alloc(&fwd_queue);
+      if(slot == NULL) {
+        PRINTF("ESMRF: Forwarding queue full\n");
+        ESMRF_STATS_ADD(fwd_queue_full);
+        UIP_MCAST6_STATS_ADD(mcast_dropped);
+        UIP_MCAST6_ROUTE_STATS_ADD(rt, dropped);
+        bad = 1;
+      } else {
+        UIP_MCAST6_STATS_ADD(mcast_fwd);
+        UIP_MCAST6_ROUTE_STATS_ADD(rt, fwd);
+        memcpy(&slot->buf, uip_buf, uip_len);
+        slot->len = uip_len;
+        slot->origin = FWD_SLOT_RELAYED;
+        uip_mcast6_fwd_schedule(&fwd_queue, slot, fwd_delay);
+        ESMRF_STATS_MAX(fwd_queue_max, uip_mcast6_fwd_used(&fwd_queue));
+      }
     }
     PRINTF("ESMRF: %u bytes: fwd in %u [%u]\n",
            uip_len, fwd_delay, fwd_spread);
   }
+  ESMRF_ADAPT_UPDATE(bad);
 
   /* Done with this packet unless we are a member of the mcast group */
   if(!uip_ds6_is_my_maddr(&UIP_IP_BUF->destipaddr)) {
@@ -372,8 +992,30 @@ in()
 static void
 init()
 {
-  UIP_MCAST6_STATS_INIT(NULL);
+  ESMRF_STATS_INIT();
+  UIP_MCAST6_STATS_INIT(&stats);
+#if ESMRF_GROUP_CONTEXTS > 0 && defined(ESMRF_CONF_GROUP_CONTEXT_0)
+  GROUP_CONTEXT_SET(0, ESMRF_CONF_GROUP_CONTEXT_0);
+#endif
+#if ESMRF_GROUP_CONTEXTS > 1 && defined(ESMRF_CONF_GROUP_CONTEXT_1)
+  GROUP_CONTEXT_SET(1, ESMRF_CONF_GROUP_CONTEXT_1);
+#endif
+#if ESMRF_GROUP_CONTEXTS > 2 && defined(ESMRF_CONF_GROUP_CONTEXT_2)
+  GROUP_CONTEXT_SET(2, ESMRF_CONF_GROUP_CONTEXT_2);
+#endif
+#if ESMRF_GROUP_CONTEXTS > 3 && defined(ESMRF_CONF_GROUP_CONTEXT_3)
+  GROUP_CONTEXT_SET(3, ESMRF_CONF_GROUP_CONTEXT_3);
+#endif
+  uip_mcast6_fwd_init(&fwd_queue, fwd_send);
+#if ESMRF_BATCH
+  batch_len = 0;
+#endif
   uip_mcast6_route_init();
+  uip_mcast6_dup_init();
+#if ESMRF_ADAPTIVE
+  uip_mcast6_adapt_init(&adapt, ESMRF_MIN_FWD_DELAY, ESMRF_MAX_SPREAD);
+#endif
+  uip_mcast6_parent_init(&parents, ESMRF_STATS_REF(parent_refresh));
   /* Register the ICMPv6 input handler */
   uip_icmp6_register_input_handler(&esmrf_icmp_handler);
   c = udp_new(NULL, 0, NULL);
@@ -397,16 +1039,39 @@ out(void)
 	PRINTF("Send multicast-on-befalf message (ICMPv6) instead to  ");
     PRINT6ADDR(&dag_t->dag_id);
     PRINTF("\n");
+#if ESMRF_BATCH
+    /* If it doesn't fit, what's waiting goes first and we start over */
+    if(batch_add() ||
+       (batch_len > 0 && batch_flush_ahead() && batch_add())) {
+      uip_slen = 0;
+      uip_len = 0;
+      return;
+    }
+    /* Too large for a batch, or nowhere to keep it. Send it on its own */
+#endif
     icmp_output();
     uip_slen=0;
     return;
   }
 }
 /*---------------------------------------------------------------------------*/
+static const struct uip_mcast6_stats_desc *
+describe_stats(uint8_t *n)
+{
+#if UIP_MCAST6_STATS
+  *n = sizeof(stats_desc) / sizeof(stats_desc[0]);
+  return stats_desc;
+#else
+  *n = 0;
+  return NULL;
+#endif
+}
+/*---------------------------------------------------------------------------*/
 const struct uip_mcast6_driver esmrf_driver = {
   "ESMRF",
   init,
   out,
   in,
+  describe_stats,
 };
 /*---------------------------------------------------------------------------*/
@@ -41,12 +41,15 @@
 #define ESMRF_H_
 
 #include "contiki-conf.h"
+#include "net/ipv6/multicast/uip-mcast6-stats.h"
 
 #include <stdint.h>
 /*---------------------------------------------------------------------------*/
 /* Protocol Constants */
 /*---------------------------------------------------------------------------*/
 #define ESMRF_ICMP_CODE              0   /* ICMPv6 code field */
+#define ESMRF_ICMP_CODE_COMPACT      1   /* Code for the compact header */
+#define ESMRF_ICMP_CODE_BATCH        2   /* Code for batched datagrams */
 #define ESMRF_IP_HOP_LIMIT        0xFF   /* Hop limit for ICMP messages */
 /*---------------------------------------------------------------------------*/
 /* Configuration */
@@ -64,20 +67,135 @@
 #else
 #define ESMRF_MAX_SPREAD 8
 #endif
+
+/*
+ * Number of datagrams which can be pending transmission at the same time.
+ * Each slot costs a uip_buf_t worth of RAM. Slots hold datagrams waiting for
+ * their forwarding delay to expire. The root re-injects on-behalf datagrams
+ * in place, without a slot, unless ESMRF_REINJECT_COPY is set. Raise this on
+ * busy nodes; when all slots are busy, new datagrams are delivered locally
+ * but not forwarded
+ */
+#ifdef ESMRF_CONF_FWD_QUEUE
+#define ESMRF_FWD_QUEUE ESMRF_CONF_FWD_QUEUE
+#else
+#define ESMRF_FWD_QUEUE 1
+#endif
+
+/*
+ * Tune the forwarding delay at runtime. ESMRF_MIN_FWD_DELAY and
+ * ESMRF_MAX_SPREAD become the starting floor and the upper bound for the
+ * spread. See uip-mcast6-adapt.h
+ */
+#ifdef ESMRF_CONF_ADAPTIVE
+#define ESMRF_ADAPTIVE ESMRF_CONF_ADAPTIVE
+#else
+#define ESMRF_ADAPTIVE 0
+#endif
+
+/*
+ * Send on-behalf messages with the compact header (ICMPv6 code
+ * ESMRF_ICMP_CODE_COMPACT). The group address gets compressed the way IPHC
+ * compresses multicast destinations, or replaced by an index if it is one of
+ * the group contexts below. The root accepts both formats regardless, so
+ * this only needs enabled on senders once the root runs a version that
+ * understands it
+ */
+#ifdef ESMRF_CONF_COMPACT_MOB
+#define ESMRF_COMPACT_MOB ESMRF_CONF_COMPACT_MOB
+#else
+#define ESMRF_COMPACT_MOB 0
+#endif
+
+/*
+ * Multicast group contexts (max 4). All nodes must agree on them, much like
+ * 6LoWPAN address contexts. Define ESMRF_CONF_GROUP_CONTEXT_n as the 8
+ * 16-bit words of the group address, e.g:
+ * #define ESMRF_CONF_GROUP_CONTEXT_0 0xFF1E, 0, 0, 0, 0, 0, 0x89, 0xABCD
+ */
+#ifdef ESMRF_CONF_GROUP_CONTEXTS
+#define ESMRF_GROUP_CONTEXTS ESMRF_CONF_GROUP_CONTEXTS
+#else
+#define ESMRF_GROUP_CONTEXTS 0
+#endif
+
+#if ESMRF_GROUP_CONTEXTS > 4
+#error "ESMRF supports up to 4 group contexts"
+#endif
+
+/*
+ * Batch on-behalf datagrams. Instead of sending one ICMPv6 message per
+ * datagram, non-root nodes hold datagrams for up to ESMRF_BATCH_HOLD clock
+ * ticks and send them to the root together (ICMPv6 code
+ * ESMRF_ICMP_CODE_BATCH), as long as they fit in ESMRF_BATCH_BUDGET bytes.
+ * Datagrams which don't fit are sent on their own straight away.
+ *
+ * The root needs this enabled to unpack batches, with a budget no smaller
+ * than that of any sender
+ */
+#ifdef ESMRF_CONF_BATCH
+#define ESMRF_BATCH ESMRF_CONF_BATCH
+#else
+#define ESMRF_BATCH 0
+#endif
+
+#ifdef ESMRF_CONF_BATCH_HOLD
+#define ESMRF_BATCH_HOLD ESMRF_CONF_BATCH_HOLD
+#else
+#define ESMRF_BATCH_HOLD (CLOCK_SECOND >> 3)
+#endif
+
+#ifdef ESMRF_CONF_BATCH_BUDGET
+#define ESMRF_BATCH_BUDGET ESMRF_CONF_BATCH_BUDGET
+#else
+#define ESMRF_BATCH_BUDGET 64
+#endif
+
+/*
+ * How the root turns an on-behalf ICMPv6 message back into a multicast
+ * datagram. 0 (default): Rewrite the message in place and send/deliver it
+ * from uip_buf. 1: Legacy path, which goes through uip_process() twice and
+ * keeps a copy of the datagram in a forwarding queue slot. Kept around for
+ * comparisons, see the reinject_ticks stats counter and `make bench` in
+ * tests/multicast
+ */
+#ifdef ESMRF_CONF_REINJECT_COPY
+#define ESMRF_REINJECT_COPY ESMRF_CONF_REINJECT_COPY
+#else
+#define ESMRF_REINJECT_COPY 0
+#endif
 /*---------------------------------------------------------------------------*/
 /* Stats datatype */
 /*---------------------------------------------------------------------------*/
+/* Counters are UIP_MCAST6_STATS_DATATYPE wide, like the core's */
 struct esmrf_stats {
-  uint16_t mcast_in_unique;
-  uint16_t mcast_in_all;        /* At layer 3 */
-  uint16_t mcast_in_ours;       /* Unique and we are a group member */
-  uint16_t mcast_fwd;           /* Forwarded by us but we are not the seed */
-  uint16_t mcast_out;           /* We are the seed */
-  uint16_t mcast_bad;
-  uint16_t mcast_dropped;
-  uint16_t icmp_out;
-  uint16_t icmp_in;
-  uint16_t icmp_bad;
+  UIP_MCAST6_STATS_DATATYPE icmp_out;
+  UIP_MCAST6_STATS_DATATYPE icmp_in;
+  UIP_MCAST6_STATS_DATATYPE icmp_bad;
+  /* Not sent because all slots were busy */
+  UIP_MCAST6_STATS_DATATYPE fwd_queue_full;
+  /* Largest number of slots used at once */
+  UIP_MCAST6_STATS_DATATYPE fwd_queue_max;
+  /* Root: On-behalf datagrams re-injected */
+  UIP_MCAST6_STATS_DATATYPE reinject;
+  uint32_t reinject_ticks;      /* Root: Total time spent on those (rtimer) */
+  /* Batches sent (also counted in icmp_out) */
+  UIP_MCAST6_STATS_DATATYPE batch_out;
+  UIP_MCAST6_STATS_DATATYPE batch_in;         /* Root: Batches unpacked */
+  /* Pref. parent LL address lookups */
+  UIP_MCAST6_STATS_DATATYPE parent_refresh;
+  /* Adaptive fwd delay floor increases */
+  UIP_MCAST6_STATS_DATATYPE adapt_backoff;
 };
+/*---------------------------------------------------------------------------*/
+struct rpl_parent;
+
+/*
+ * Notify ESMRF that RPL switched preferred parents. Hooked into RPL as
+ * RPL_CALLBACK_PARENT_SWITCH by uip-mcast6.h. If your project already uses
+ * that callback, call this from it. Otherwise ESMRF only notices the switch
+ * when a datagram arrives from a neighbour other than the parent it knows of
+ */
+void esmrf_parent_switch(struct rpl_parent *old, struct rpl_parent *new);
 
 #endif /* ESMRF_H_ */
@@ -0,0 +1,1057 @@
+/*
+ * Copyright (c) 2026, The Contiki Project
+ * Portions copyright (c) 2010, Loughborough University - Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup mpl-multicast
+ * @{
+ */
+/**
+ * \file
+ *    Implementation of the MPL multicast engine (RFC 7731)
+ *
+ * \author
+ *    The Contiki Project
+ */
+
+#include "contiki.h"
+#include "contiki-lib.h"
+#include "contiki-net.h"
+#include "net/ipv6/uip-icmp6.h"
+#include "net/ipv6/multicast/uip-mcast6.h"
+#include "net/ipv6/multicast/mpl.h"
+#include "net/ipv6/multicast/uip-mcast6-trickle.h"
+#include "dev/watchdog.h"
+#include <string.h>
+
+#define DEBUG DEBUG_NONE
+#include "net/ip/uip-debug.h"
+
+#define TRICKLE_VERBOSE 0
+
+#if DEBUG && TRICKLE_VERBOSE
+#define VERBOSE_PRINTF(...) PRINTF(__VA_ARGS__)
+#else
+#define VERBOSE_PRINTF(...)
+#endif
+/*---------------------------------------------------------------------------*/
+/* Data Representation */
+/*---------------------------------------------------------------------------*/
+/*
+ * Seed IDs can be 16, 64 or 128 bits long. Two IDs are only the same seed if
+ * both length and value match. An elided Seed ID (S=0) is the seed's IPv6
+ * address and is the same seed as S=3 with that address
+ */
+typedef struct seed_id_s {
+  uint8_t len;                  /* Bytes: 2, 8 or 16 */
+  uint8_t id[16];
+} seed_id_t;
+
+#define seed_id_cmp(a, b) \
+  ((a)->len == (b)->len && memcmp((a)->id, (b)->id, (a)->len) == 0)
+#define seed_id_cpy(a, b) (memcpy((a), (b), sizeof(seed_id_t)))
+#define PRINT_SEED(s) do { \
+  uint8_t i_; \
+  for(i_ = 0; i_ < (s)->len; i_++) { \
+    PRINTF("%02x", (s)->id[i_]); \
+  } \
+} while(0)
+
+/* Seed ID length in bytes, indexed by the S field. S=0 means 128 bits */
+static const uint8_t seed_id_len[4] = { 16, 2, 8, 16 };
+
+/* The S value we use to advertise a Seed ID of length l in Seed Info */
+#define SEED_ID_S(l) ((l) == 2 ? 1 : ((l) == 8 ? 2 : 3))
+/*---------------------------------------------------------------------------*/
+/* Trickle Timers */
+/**
+ * \brief Check if suppression is enabled for trickle timer t
+ * t is a pointer to the timer
+ */
+#define SUPPRESSION_ENABLED(t) ((t)->k != MPL_INFINITE_REDUNDANCY)
+
+/**
+ * \brief Init trickle timer t with the MPL parameters for x (DATA_MESSAGE
+ * or CONTROL_MESSAGE)
+ */
+#define TIMER_CONFIGURE(t, x) do { \
+  (t)->i_min = MPL_##x##_IMIN; \
+  (t)->i_max = MPL_##x##_IMAX; \
+  (t)->k = MPL_##x##_K; \
+} while(0)
+/*---------------------------------------------------------------------------*/
+/* Sequence Values and Serial Number Arithmetic
+ *
+ * Our 'SERIAL_BITS' value is 8 here. As with ROLL TM, pairs at a distance of
+ * exactly 128 have no defined ordering
+ */
+#define SEQ_VAL_IS_EQ(i1, i2) UIP_MCAST6_SEQ_IS_EQ(i1, i2)
+#define SEQ_VAL_IS_LT(i1, i2) UIP_MCAST6_SEQ_IS_LT(i1, i2, 8)
+#define SEQ_VAL_IS_GT(i1, i2) UIP_MCAST6_SEQ_IS_GT(i1, i2, 8)
+/*---------------------------------------------------------------------------*/
+/* Seed Set */
+struct mpl_msg;
+
+struct seed_set_entry {
+  struct uip_mcast6_trickle t;  /* Data Message timer. Must be first */
+  struct mpl_msg *head;         /* Our buffered messages, in sequence order */
+  unsigned long expires;        /* clock_seconds() */
+  seed_id_t seed_id;
+  uint8_t min_seqno;            /* Lower bound, we drop anything older */
+  uint8_t count;                /* Number of buffered messages */
+  uint8_t flags;                /* Is Used, Is Listed */
+};
+
+#define SEED_U_BIT 0x80         /* Is Used */
+#define SEED_L_BIT 0x40         /* Is listed in a Control Message */
+
+#define SEED_IS_USED(s)      ((s)->flags & SEED_U_BIT)
+#define SEED_USED_SET(s)     ((s)->flags |= SEED_U_BIT)
+#define SEED_IS_LISTED(s)    ((s)->flags & SEED_L_BIT)
+#define SEED_LISTED_SET(s)   ((s)->flags |= SEED_L_BIT)
+#define SEED_LISTED_CLR(s)   ((s)->flags &= ~SEED_L_BIT)
+/*---------------------------------------------------------------------------*/
+/* Buffered Message Set */
+struct mpl_msg {
+  struct mpl_msg *next;         /* Next in seed (if used) or in free list */
+  struct seed_set_entry *seed;
+  uint8_t *buff;                /* Points into the packet arena */
+  uint16_t buff_len;
+  uint8_t seq;
+  uint8_t opt;                  /* Offset of the MPL Option within buff */
+  uint8_t e;                    /* Data timer intervals since our last reset */
+  uint8_t c;                    /* Consistent receptions this interval */
+  uint8_t flags;                /* Is Used */
+};
+
+#define MSG_U_BIT 0x80          /* Is Used */
+
+#define MSG_IS_USED(m)  ((m)->flags & MSG_U_BIT)
+#define MSG_USED_SET(m) ((m)->flags |= MSG_U_BIT)
+
+/* Get the TTL (hop limit) of a buffered message */
+#define MSG_TTL(m) (((struct uip_ip_hdr *)(m)->buff)->ttl)
+
+/* The message takes part in its seed's current data timer interval */
+#define MSG_IS_ACTIVE(m) ((m)->e < MPL_DATA_MESSAGE_TIMER_EXPIRATIONS)
+/*---------------------------------------------------------------------------*/
+/* MPL Option */
+struct mpl_hbho {
+  uint8_t type;
+  uint8_t len;
+  uint8_t flags;                /* S (2 bits), M, V, 4 reserved */
+  uint8_t seq;
+  /* Followed by the Seed ID, 0, 2, 8 or 16 bytes */
+};
+
+#define HBHO_OPT_TYPE_MPL 0x6D
+
+#define HBH_GET_S(h) (((h)->flags & 0xC0) >> 6)
+#define HBH_M_BIT    0x20
+#define HBH_V_BIT    0x10
+#define HBH_SEED_ID(h) ((uint8_t *)(h) + sizeof(struct mpl_hbho))
+
+/* The HBHO header we add to datagrams we originate, padded to 8 bytes */
+#if MPL_SEED_ID_TYPE == 0
+#define HBHO_SEED_ID_LEN 0
+#define HBHO_TOTAL_LEN   8
+#elif MPL_SEED_ID_TYPE == 1
+#define HBHO_SEED_ID_LEN 2
+#define HBHO_TOTAL_LEN   8
+#elif MPL_SEED_ID_TYPE == 2
+#define HBHO_SEED_ID_LEN 8
+#define HBHO_TOTAL_LEN   16
+#if UIP_LLADDR_LEN != 8
+#error "MPL: 64-bit Seed IDs need 8-byte link-layer addresses"
+#endif
+#elif MPL_SEED_ID_TYPE == 3
+#define HBHO_SEED_ID_LEN 16
+#define HBHO_TOTAL_LEN   24
+#else
+#error "MPL: MPL_CONF_SEED_ID_TYPE must be 0, 1, 2 or 3"
+#endif
+
+/* Extension header (2), MPL Option without the Seed ID (4), Seed ID, padding */
+#define HBHO_PAD_LEN (HBHO_TOTAL_LEN - 6 - HBHO_SEED_ID_LEN)
+/*---------------------------------------------------------------------------*/
+/*
+ * MPL Seed Info, in Control Messages:
+ * [min-seqno] [bm-len (6 bits) | S (2 bits)] [Seed ID] [bm-len bytes bitmap]
+ * Bit i of the bitmap (MSB first) stands for sequence min-seqno + i
+ */
+#define SEED_INFO_HDR_LEN   2
+#define SEED_INFO_GET_BM_LEN(i) ((i)[1] >> 2)
+#define SEED_INFO_GET_S(i)      ((i)[1] & 0x03)
+#define SEED_INFO_BM_LEN_MAX 0x3F
+
+#define BM_IS_SET(bm, o) ((bm)[(o) >> 3] & (0x80 >> ((o) & 7)))
+#define BM_SET(bm, o)    ((bm)[(o) >> 3] |= (0x80 >> ((o) & 7)))
+/*---------------------------------------------------------------------------*/
+/* Maintain Stats */
+#if UIP_MCAST6_STATS
+static struct mpl_stats stats;
+
+static const struct uip_mcast6_stats_desc stats_desc[] = {
+  UIP_MCAST6_STATS_DESC(mpl_stats, icmp_in, 0),
+  UIP_MCAST6_STATS_DESC(mpl_stats, icmp_out, 0),
+  UIP_MCAST6_STATS_DESC(mpl_stats, icmp_bad, 0),
+  UIP_MCAST6_STATS_DESC(mpl_stats, seed_expired, 0),
+  UIP_MCAST6_STATS_DESC(mpl_stats, arena_max, UIP_MCAST6_STATS_T_MAX),
+};
+
+#define MPL_STATS_ADD(x) stats.x++
+#define MPL_STATS_INIT() do { memset(&stats, 0, sizeof(stats)); } while(0)
+#define MPL_STATS_REF(x) (&stats.x)
+#else /* UIP_MCAST6_STATS */
+#define MPL_STATS_ADD(x)
+#define MPL_STATS_INIT()
+#define MPL_STATS_REF(x) NULL
+#endif
+/*---------------------------------------------------------------------------*/
+/* Internal Data Structures */
+/*---------------------------------------------------------------------------*/
+static struct uip_mcast6_trickle control;
+static struct seed_set_entry seeds[MPL_SEED_SET_SIZE];
+static struct mpl_msg buffered_msgs[MPL_BUFFERED_MESSAGE_SET_SIZE];
+UIP_MCAST6_ARENA(arena, MPL_ARENA_SIZE, struct mpl_msg, buffered_msgs);
+static uip_ipaddr_t all_forwarders;
+
+/* Our own sequence number for datagrams we originate */
+static uint8_t last_seq;
+/*---------------------------------------------------------------------------*/
+/* uIPv6 Pointers */
+/*---------------------------------------------------------------------------*/
+#define UIP_EXT_BUF       ((struct uip_ext_hdr *)&uip_buf[UIP_LLH_LEN + UIP_IPH_LEN])
+#define UIP_EXT_BUF_NEXT  ((uint8_t *)&uip_buf[UIP_LLH_LEN + UIP_IPH_LEN + HBHO_TOTAL_LEN])
+#define UIP_EXT_OPT_FIRST ((uint8_t *)&uip_buf[UIP_LLH_LEN + UIP_IPH_LEN + 2])
+#define UIP_IP_BUF        ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+#define UIP_ICMP_BUF      ((struct uip_icmp_hdr *)&uip_buf[uip_l2_l3_hdr_len])
+#define UIP_ICMP_PAYLOAD  ((unsigned char *)&uip_buf[uip_l2_l3_icmp_hdr_len])
+extern uint16_t uip_slen;
+/*---------------------------------------------------------------------------*/
+/* Local function prototypes */
+/*---------------------------------------------------------------------------*/
+static void icmp_input(void);
+static void icmp_output(void);
+static void buffer_free(struct mpl_msg *m);
+/*---------------------------------------------------------------------------*/
+/* ICMPv6 handler declaration */
+UIP_ICMP6_HANDLER(mpl_icmp_handler, ICMP6_MPL,
+                  UIP_ICMP6_HANDLER_CODE_ANY, icmp_input);
+/*---------------------------------------------------------------------------*/
+/* Trickle Timer Functions */
+/*---------------------------------------------------------------------------*/
+/* Data timer periodic: Transmit the messages of its seed due this interval */
+static void
+data_periodic(struct uip_mcast6_trickle *t)
+{
+  struct seed_set_entry *s = (struct seed_set_entry *)t;
+  struct mpl_msg *m;
+  struct mpl_hbho *opt;
+
+  for(m = s->head; m != NULL; m = m->next) {
+    if(!MSG_IS_ACTIVE(m) || MSG_TTL(m) == 0) {
+      continue;
+    }
+    if(SUPPRESSION_ENABLED(&s->t) && m->c >= s->t.k) {
+      continue;
+    }
+
+    /* M: Set if this is the largest sequence we know of for this seed */
+    opt = (struct mpl_hbho *)(m->buff + m->opt);
+    if(m->next == NULL) {
+      opt->flags |= HBH_M_BIT;
+    } else {
+      opt->flags &= ~HBH_M_BIT;
+    }
+
+    PRINTF("MPL: Data Message Out, Seed ");
+    PRINT_SEED(&s->seed_id);
+    PRINTF(" seq %u\n", m->seq);
+
+    uip_len = m->buff_len;
+    memcpy(UIP_IP_BUF, m->buff, uip_len);
+
+    UIP_MCAST6_STATS_ADD(mcast_fwd);
+    tcpip_output(NULL);
+    watchdog_periodic();
+  }
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * End of a data timer interval for its seed. Returns non-zero if some
+ * message still needs the timer to keep going
+ */
+static uint8_t
+data_interval_end(struct uip_mcast6_trickle *t)
+{
+  struct seed_set_entry *s = (struct seed_set_entry *)t;
+  struct mpl_msg *m;
+  uint8_t running = 0;
+
+  t->c = 0;
+  for(m = s->head; m != NULL; m = m->next) {
+    m->c = 0;
+    if(MSG_IS_ACTIVE(m)) {
+      m->e++;
+    }
+    if(MSG_IS_ACTIVE(m)) {
+      running = 1;
+    }
+  }
+  return running;
+}
+/*---------------------------------------------------------------------------*/
+/* Control Message timer periodic: Advertise what we buffer */
+static void
+control_periodic(struct uip_mcast6_trickle *t)
+{
+  if(!SUPPRESSION_ENABLED(t) || t->c < t->k) {
+    icmp_output();
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Control Message timer: Stop after MPL_CONTROL_MESSAGE_TIMER_EXPIRATIONS */
+static uint8_t
+control_interval_end(struct uip_mcast6_trickle *t)
+{
+  t->c = 0;
+  return t->e < MPL_CONTROL_MESSAGE_TIMER_EXPIRATIONS;
+}
+/*---------------------------------------------------------------------------*/
+/* Control Message timer: Something new or inconsistent happened */
+static void
+control_inconsistency(void)
+{
+#if MPL_CONTROL_MESSAGE_TIMER_EXPIRATIONS
+  uip_mcast6_trickle_inconsistency(&control);
+#endif
+}
+/*---------------------------------------------------------------------------*/
+/* Start (or restart) retransmitting message m under its seed's data timer */
+static void
+message_reset(struct mpl_msg *m)
+{
+  m->e = 0;
+  m->c = 0;
+  uip_mcast6_trickle_inconsistency(&m->seed->t);
+}
+/*---------------------------------------------------------------------------*/
+/* Seed Set and Buffered Message Set Functions */
+/*---------------------------------------------------------------------------*/
+static struct seed_set_entry *
+seed_lookup(seed_id_t *id)
+{
+  struct seed_set_entry *s;
+
+  for(s = &seeds[MPL_SEED_SET_SIZE - 1]; s >= seeds; s--) {
+    if(SEED_IS_USED(s) && seed_id_cmp(id, &s->seed_id)) {
+      return s;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static struct seed_set_entry *
+seed_allocate(seed_id_t *id)
+{
+  struct seed_set_entry *s;
+
+  for(s = &seeds[MPL_SEED_SET_SIZE - 1]; s >= seeds; s--) {
+    if(!SEED_IS_USED(s)) {
+      memset(s, 0, sizeof(struct seed_set_entry));
+      TIMER_CONFIGURE(&s->t, DATA_MESSAGE);
+      s->t.periodic = data_periodic;
+      s->t.interval_end = data_interval_end;
+      seed_id_cpy(&s->seed_id, id);
+      SEED_USED_SET(s);
+      return s;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+seed_free(struct seed_set_entry *s)
+{
+  PRINTF("MPL: Free Seed ");
+  PRINT_SEED(&s->seed_id);
+  PRINTF("\n");
+
+  while(s->head != NULL) {
+    buffer_free(s->head);
+  }
+  ctimer_stop(&s->t.ct);
+  s->count = 0;
+  s->flags = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Remove Seed Set entries which reached SEED_SET_ENTRY_LIFETIME */
+static void
+seed_set_expire(void)
+{
+  struct seed_set_entry *s;
+  unsigned long now = clock_seconds();
+
+  for(s = &seeds[MPL_SEED_SET_SIZE - 1]; s >= seeds; s--) {
+    if(SEED_IS_USED(s) && (long)(now - s->expires) >= 0) {
+      MPL_STATS_ADD(seed_expired);
+      seed_free(s);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Find the message with sequence value seq for seed s */
+static struct mpl_msg *
+seed_find(struct seed_set_entry *s, uint8_t seq)
+{
+  struct mpl_msg *m;
+
+  for(m = s->head; m != NULL; m = m->next) {
+    if(SEQ_VAL_IS_EQ(m->seq, seq)) {
+      return m;
+    }
+    if(SEQ_VAL_IS_GT(m->seq, seq)) {
+      break;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Link message m into the list of seed s, keeping it in sequence order */
+static void
+seed_insert(struct seed_set_entry *s, struct mpl_msg *m)
+{
+  struct mpl_msg **prev;
+
+  for(prev = &s->head; *prev != NULL; prev = &(*prev)->next) {
+    if(SEQ_VAL_IS_GT((*prev)->seq, m->seq)) {
+      break;
+    }
+  }
+  m->next = *prev;
+  *prev = m;
+  s->count++;
+}
+/*---------------------------------------------------------------------------*/
+/* Unlink m from its seed and return it to the free list */
+static void
+buffer_free(struct mpl_msg *m)
+{
+  struct mpl_msg **prev;
+
+  if(MSG_IS_USED(m)) {
+    for(prev = &m->seed->head; *prev != NULL; prev = &(*prev)->next) {
+      if(*prev == m) {
+        *prev = m->next;
+        m->seed->count--;
+        break;
+      }
+    }
+  }
+  m->flags = 0;
+  uip_mcast6_arena_free(&arena, m);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Drop the oldest message of the seed with the most buffered messages. The
+ * seed's lower bound moves past it, so we won't accept it again
+ */
+static uint8_t
+buffer_reclaim(void)
+{
+  struct seed_set_entry *s;
+  struct seed_set_entry *largest = NULL;
+
+  for(s = &seeds[MPL_SEED_SET_SIZE - 1]; s >= seeds; s--) {
+    if(SEED_IS_USED(s) && (largest == NULL || s->count > largest->count)) {
+      largest = s;
+    }
+  }
+
+  if(largest == NULL || largest->head == NULL) {
+    return 0;
+  }
+
+  PRINTF("MPL: Reclaim seq. %u from Seed ", largest->head->seq);
+  PRINT_SEED(&largest->seed_id);
+  PRINTF("\n");
+
+  largest->min_seqno = largest->head->seq + 1;
+  buffer_free(largest->head);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Find the MPL Option in the datagram's Hop-by-Hop header */
+static struct mpl_hbho *
+hbho_find(void)
+{
+  uint8_t *opt = UIP_EXT_OPT_FIRST;
+  uint8_t *end = (uint8_t *)UIP_EXT_BUF + ((UIP_EXT_BUF->len + 1) << 3);
+
+  if(end > &uip_buf[UIP_LLH_LEN + uip_len]) {
+    return NULL;
+  }
+
+  while(opt < end) {
+    if(*opt == UIP_EXT_HDR_OPT_PAD1) {
+      opt++;
+      continue;
+    }
+    if(opt + 2 > end || opt + 2 + opt[1] > end) {
+      return NULL;
+    }
+    if(*opt == HBHO_OPT_TYPE_MPL) {
+      return (struct mpl_hbho *)opt;
+    }
+    opt += 2 + opt[1];
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+icmp_output(void)
+{
+  struct seed_set_entry *s;
+  struct mpl_msg *m;
+  uint8_t *info;
+  uint8_t *bm;
+  uint8_t bm_len;
+  uint8_t offset;
+  uint16_t payload_len;
+  uint16_t info_len;
+
+  PRINTF("MPL: Control Message Out\n");
+
+  /* Don't advertise seeds which have timed out */
+  seed_set_expire();
+
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->tcflow = 0;
+  UIP_IP_BUF->flow = 0;
+  UIP_IP_BUF->proto = UIP_PROTO_ICMP6;
+  UIP_IP_BUF->ttl = MPL_IP_HOP_LIMIT;
+
+  uip_ext_len = 0;
+  info = UIP_ICMP_PAYLOAD;
+  payload_len = 0;
+
+  for(s = &seeds[MPL_SEED_SET_SIZE - 1]; s >= seeds; s--) {
+    if(!SEED_IS_USED(s)) {
+      continue;
+    }
+
+    /* Enough bitmap to cover everything up to our newest message */
+    bm_len = 0;
+    for(m = s->head; m != NULL; m = m->next) {
+      bm_len = (uint8_t)(m->seq - s->min_seqno) / 8 + 1;
+    }
+    if(bm_len > SEED_INFO_BM_LEN_MAX) {
+      bm_len = SEED_INFO_BM_LEN_MAX;
+    }
+
+    info_len = SEED_INFO_HDR_LEN + s->seed_id.len + bm_len;
+    if(UIP_IPICMPH_LEN + payload_len + info_len > UIP_BUFSIZE - UIP_LLH_LEN) {
+      PRINTF("MPL: Control Message Out, no room for more seeds\n");
+      break;
+    }
+
+    info[0] = s->min_seqno;
+    info[1] = (bm_len << 2) | SEED_ID_S(s->seed_id.len);
+    memcpy(&info[SEED_INFO_HDR_LEN], s->seed_id.id, s->seed_id.len);
+
+    bm = &info[SEED_INFO_HDR_LEN + s->seed_id.len];
+    memset(bm, 0, bm_len);
+    for(m = s->head; m != NULL; m = m->next) {
+      offset = m->seq - s->min_seqno;
+      if(offset < bm_len * 8) {
+        BM_SET(bm, offset);
+      }
+    }
+
+    PRINTF("MPL: Control Message Out - Seed ");
+    PRINT_SEED(&s->seed_id);
+    PRINTF(" min %u, %u messages, bm-len %u\n", s->min_seqno, s->count,
+           bm_len);
+
+    info += info_len;
+    payload_len += info_len;
+  }
+
+  if(payload_len == 0) {
+    VERBOSE_PRINTF("MPL: Control Message Out - nothing to send\n");
+    return;
+  }
+
+  uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, &all_forwarders);
+  uip_ds6_select_src(&UIP_IP_BUF->srcipaddr, &UIP_IP_BUF->destipaddr);
+
+  UIP_IP_BUF->len[0] = (UIP_ICMPH_LEN + payload_len) >> 8;
+  UIP_IP_BUF->len[1] = (UIP_ICMPH_LEN + payload_len) & 0xff;
+
+  UIP_ICMP_BUF->type = ICMP6_MPL;
+  UIP_ICMP_BUF->icode = MPL_ICMP_CODE;
+
+  UIP_ICMP_BUF->icmpchksum = 0;
+  UIP_ICMP_BUF->icmpchksum = ~uip_icmp6chksum();
+
+  uip_len = UIP_IPH_LEN + UIP_ICMPH_LEN + payload_len;
+
+  tcpip_ipv6_output();
+  MPL_STATS_ADD(icmp_out);
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+accept(uint8_t in)
+{
+  struct mpl_hbho *opt;
+  struct seed_set_entry *s;
+  struct mpl_msg *m;
+  seed_id_t seed_id;
+  uint8_t seq;
+  uint8_t new_seed = 0;
+
+  PRINTF("MPL: Multicast I/O\n");
+
+#if UIP_CONF_IPV6_CHECKS
+  if(uip_is_addr_mcast_non_routable(&UIP_IP_BUF->destipaddr)) {
+    PRINTF("MPL: Mcast I/O, bad destination\n");
+    UIP_MCAST6_STATS_ADD(mcast_bad);
+    return UIP_MCAST6_DROP;
+  }
+  /*
+   * Abort transmission if the v6 src is unspecified. This may happen if the
+   * seed tries to TX while it's still performing DAD or waiting for a prefix
+   */
+  if(uip_is_addr_unspecified(&UIP_IP_BUF->srcipaddr)) {
+    PRINTF("MPL: Mcast I/O, bad source\n");
+    UIP_MCAST6_STATS_ADD(mcast_bad);
+    return UIP_MCAST6_DROP;
+  }
+#endif
+
+  /* Check the Next Header field: Must be HBHO */
+  if(UIP_IP_BUF->proto != UIP_PROTO_HBHO) {
+    PRINTF("MPL: Mcast I/O, bad proto\n");
+    UIP_MCAST6_STATS_ADD(mcast_bad);
+    return UIP_MCAST6_DROP;
+  }
+
+  opt = hbho_find();
+  if(opt == NULL) {
+    PRINTF("MPL: Mcast I/O, no MPL Option\n");
+    UIP_MCAST6_STATS_ADD(mcast_bad);
+    return UIP_MCAST6_DROP;
+  }
+
+  /* V must be 0 for this version of the protocol */
+  if((opt->flags & HBH_V_BIT) ||
+     opt->len < sizeof(struct mpl_hbho) - 2 + (HBH_GET_S(opt) == 0 ? 0 :
+                                               seed_id_len[HBH_GET_S(opt)])) {
+    PRINTF("MPL: Mcast I/O, bad MPL Option\n");
+    UIP_MCAST6_STATS_ADD(mcast_bad);
+    return UIP_MCAST6_DROP;
+  }
+
+#if UIP_MCAST6_STATS
+  if(in == MPL_DGRAM_IN) {
+    UIP_MCAST6_STATS_ADD(mcast_in_all);
+  }
+#endif
+
+  /* Elided Seed ID: It's the IPv6 source address */
+  seed_id.len = seed_id_len[HBH_GET_S(opt)];
+  if(HBH_GET_S(opt) == 0) {
+    memcpy(seed_id.id, &UIP_IP_BUF->srcipaddr, seed_id.len);
+  } else {
+    memcpy(seed_id.id, HBH_SEED_ID(opt), seed_id.len);
+  }
+  seq = opt->seq;
+
+  PRINTF("MPL: Seed ");
+  PRINT_SEED(&seed_id);
+  PRINTF(" seq %u\n", seq);
+
+  seed_set_expire();
+
+  s = seed_lookup(&seed_id);
+  if(s != NULL) {
+    if(SEQ_VAL_IS_LT(seq, s->min_seqno)) {
+      PRINTF("MPL: Too old\n");
+      UIP_MCAST6_STATS_ADD(mcast_dropped);
+      return UIP_MCAST6_DROP;
+    }
+    m = seed_find(s, seq);
+    if(m != NULL) {
+      /* Seen before. Consistent for this message's data timer */
+      PRINTF("MPL: Seen before\n");
+      m->c++;
+      UIP_MCAST6_STATS_ADD(mcast_dropped);
+      return UIP_MCAST6_DROP;
+    }
+  } else {
+    s = seed_allocate(&seed_id);
+    if(s == NULL) {
+      PRINTF("MPL: Failed to allocate Seed Set entry\n");
+      UIP_MCAST6_STATS_ADD(mcast_dropped);
+      return UIP_MCAST6_DROP;
+    }
+    s->min_seqno = seq;
+    new_seed = 1;
+    PRINTF("MPL: New seed\n");
+  }
+
+  m = uip_mcast6_arena_alloc(&arena, uip_len);
+  if(m == NULL) {
+    PRINTF("MPL: Buffer allocation failed\n");
+    if(new_seed) {
+      seed_free(s);
+    }
+    UIP_MCAST6_STATS_ADD(mcast_dropped);
+    return UIP_MCAST6_DROP;
+  }
+
+#if UIP_MCAST6_STATS
+  if(in == MPL_DGRAM_IN) {
+    UIP_MCAST6_STATS_ADD(mcast_in_unique);
+  }
+#endif
+
+  memcpy(m->buff, UIP_IP_BUF, uip_len);
+  m->buff_len = uip_len;
+  m->seq = seq;
+  m->opt = (uint8_t *)opt - (uint8_t *)UIP_IP_BUF;
+  m->seed = s;
+  MSG_USED_SET(m);
+  seed_insert(s, m);
+  s->expires = clock_seconds() + MPL_SEED_SET_ENTRY_LIFETIME;
+
+  PRINTF("MPL: Seed ");
+  PRINT_SEED(&s->seed_id);
+  PRINTF(" now buffers %u messages from %u\n", s->count, s->min_seqno);
+
+  /* Forwarders decrement the hop limit once, before retransmitting */
+  if(in == MPL_DGRAM_IN) {
+    MSG_TTL(m)--;
+  }
+
+#if MPL_PROACTIVE_FORWARDING
+  message_reset(m);
+#else
+  /* Wait for a Control Message to tell us someone misses it */
+  m->e = MPL_DATA_MESSAGE_TIMER_EXPIRATIONS;
+#endif
+
+  /* A new message is an inconsistency for the Control Message timer */
+  control_inconsistency();
+
+  return UIP_MCAST6_ACCEPT;
+}
+/*---------------------------------------------------------------------------*/
+static void
+icmp_input()
+{
+  struct seed_set_entry *s;
+  struct mpl_msg *m;
+  seed_id_t seed_id;
+  uint8_t *info;
+  uint8_t *end;
+  uint8_t *bm;
+  uint8_t bm_len;
+  uint8_t min_seqno;
+  uint8_t offset;
+  uint8_t inconsistency = 0;
+  uint16_t i;
+
+#if UIP_CONF_IPV6_CHECKS
+  if(!uip_is_addr_linklocal(&UIP_IP_BUF->srcipaddr)) {
+    PRINTF("MPL: Control Message In, bad source\n");
+    MPL_STATS_ADD(icmp_bad);
+    goto discard;
+  }
+
+  if(!uip_ipaddr_cmp(&UIP_IP_BUF->destipaddr, &all_forwarders)) {
+    PRINTF("MPL: Control Message In, bad destination\n");
+    MPL_STATS_ADD(icmp_bad);
+    goto discard;
+  }
+
+  if(UIP_ICMP_BUF->icode != MPL_ICMP_CODE) {
+    PRINTF("MPL: Control Message In, bad ICMP code\n");
+    MPL_STATS_ADD(icmp_bad);
+    goto discard;
+  }
+
+  if(UIP_IP_BUF->ttl != MPL_IP_HOP_LIMIT) {
+    PRINTF("MPL: Control Message In, bad TTL\n");
+    MPL_STATS_ADD(icmp_bad);
+    goto discard;
+  }
+#endif
+
+  PRINTF("MPL: Control Message In from ");
+  PRINT6ADDR(&UIP_IP_BUF->srcipaddr);
+  PRINTF(" len %u, ext %u\n", uip_len, uip_ext_len);
+
+  MPL_STATS_ADD(icmp_in);
+
+  seed_set_expire();
+
+  for(s = &seeds[MPL_SEED_SET_SIZE - 1]; s >= seeds; s--) {
+    SEED_LISTED_CLR(s);
+  }
+
+  info = UIP_ICMP_PAYLOAD;
+  end = &uip_buf[UIP_LLH_LEN + uip_len];
+
+  while(info < end) {
+    if(info + SEED_INFO_HDR_LEN > end) {
+      goto bad;
+    }
+    min_seqno = info[0];
+    bm_len = SEED_INFO_GET_BM_LEN(info);
+    seed_id.len = seed_id_len[SEED_INFO_GET_S(info)];
+    if(info + SEED_INFO_HDR_LEN + seed_id.len + bm_len > end) {
+      goto bad;
+    }
+    memcpy(seed_id.id, &info[SEED_INFO_HDR_LEN], seed_id.len);
+    bm = &info[SEED_INFO_HDR_LEN + seed_id.len];
+
+    PRINTF("MPL: Control Message In - Seed ");
+    PRINT_SEED(&seed_id);
+    PRINTF(" min %u, bm-len %u\n", min_seqno, bm_len);
+
+    s = seed_lookup(&seed_id);
+    if(s == NULL) {
+      /* Unknown seed. If they buffer something for it, we are missing it */
+      for(i = 0; i < bm_len; i++) {
+        if(bm[i] != 0) {
+          PRINTF("MPL: Inconsistency - we miss an unknown seed\n");
+          inconsistency = 1;
+          break;
+        }
+      }
+    } else {
+      SEED_LISTED_SET(s);
+
+      /* Messages we hold that they don't, as long as they still want them */
+      for(m = s->head; m != NULL; m = m->next) {
+        if(SEQ_VAL_IS_LT(m->seq, min_seqno)) {
+          continue;
+        }
+        offset = m->seq - min_seqno;
+        if(offset >= bm_len * 8 || !BM_IS_SET(bm, offset)) {
+          PRINTF("MPL: Inconsistency - seq. %u missing\n", m->seq);
+          message_reset(m);
+          inconsistency = 1;
+        }
+      }
+
+      /* Messages they hold that we don't and would still accept */
+      for(i = 0; i < bm_len * 8; i++) {
+        if(BM_IS_SET(bm, i) &&
+           !SEQ_VAL_IS_LT((uint8_t)(min_seqno + i), s->min_seqno) &&
+           seed_find(s, min_seqno + i) == NULL) {
+          PRINTF("MPL: Inconsistency - we miss seq. %u\n",
+                 (uint8_t)(min_seqno + i));
+          inconsistency = 1;
+          break;
+        }
+      }
+    }
+
+    info += SEED_INFO_HDR_LEN + seed_id.len + bm_len;
+  }
+
+  /* Seeds they didn't list at all: Everything we hold is news to them */
+  for(s = &seeds[MPL_SEED_SET_SIZE - 1]; s >= seeds; s--) {
+    if(SEED_IS_USED(s) && !SEED_IS_LISTED(s)) {
+      for(m = s->head; m != NULL; m = m->next) {
+        message_reset(m);
+        inconsistency = 1;
+      }
+    }
+  }
+
+  if(inconsistency) {
+    control_inconsistency();
+  } else {
+    control.c++;
+  }
+  goto discard;
+
+bad:
+  PRINTF("MPL: Control Message In, bad Seed Info\n");
+  MPL_STATS_ADD(icmp_bad);
+
+discard:
+  uip_clear_buf();
+}
+/*---------------------------------------------------------------------------*/
+static void
+out()
+{
+  struct mpl_hbho *opt;
+#if HBHO_PAD_LEN > 0
+  uint8_t *pad;
+#endif
+
+  if(uip_len + HBHO_TOTAL_LEN > UIP_BUFSIZE) {
+    PRINTF("MPL: Multicast Out can not add HBHO. Packet too long\n");
+    goto drop;
+  }
+
+  /* Slide 'right' by HBHO_TOTAL_LEN bytes */
+  memmove(UIP_EXT_BUF_NEXT, UIP_EXT_BUF, uip_len - UIP_IPH_LEN);
+  memset(UIP_EXT_BUF, 0, HBHO_TOTAL_LEN);
+
+  UIP_EXT_BUF->next = UIP_IP_BUF->proto;
+  UIP_EXT_BUF->len = (HBHO_TOTAL_LEN >> 3) - 1;
+
+  opt = (struct mpl_hbho *)UIP_EXT_OPT_FIRST;
+  opt->type = HBHO_OPT_TYPE_MPL;
+  opt->len = sizeof(struct mpl_hbho) - 2 + HBHO_SEED_ID_LEN;
+
+  /* We are the seed, so this is always our largest sequence */
+  last_seq++;
+  opt->seq = last_seq;
+  opt->flags = (MPL_SEED_ID_TYPE << 6) | HBH_M_BIT;
+
+#if MPL_SEED_ID_TYPE == 1
+  memcpy(HBH_SEED_ID(opt), &uip_lladdr.addr[UIP_LLADDR_LEN - 2], 2);
+#elif MPL_SEED_ID_TYPE == 2
+  memcpy(HBH_SEED_ID(opt), uip_lladdr.addr, 8);
+#elif MPL_SEED_ID_TYPE == 3
+  memcpy(HBH_SEED_ID(opt), &UIP_IP_BUF->srcipaddr, 16);
+#endif
+
+  /* Pad the rest with PadN */
+#if HBHO_PAD_LEN > 0
+  pad = HBH_SEED_ID(opt) + HBHO_SEED_ID_LEN;
+  pad[0] = UIP_EXT_HDR_OPT_PADN;
+  pad[1] = HBHO_PAD_LEN - 2;
+#endif
+
+  uip_ext_len += HBHO_TOTAL_LEN;
+  uip_len += HBHO_TOTAL_LEN;
+
+  /* Update the proto and length field in the v6 header */
+  UIP_IP_BUF->proto = UIP_PROTO_HBHO;
+  UIP_IP_BUF->len[0] = ((uip_len - UIP_IPH_LEN) >> 8);
+  UIP_IP_BUF->len[1] = ((uip_len - UIP_IPH_LEN) & 0xff);
+
+  PRINTF("MPL: Multicast Out, seq %u\n", last_seq);
+
+  /*
+   * Buffer the message so that we can advertise and retransmit it, send it
+   * right away and then stop the core from sending it again
+   */
+  if(accept(MPL_DGRAM_OUT)) {
+    tcpip_output(NULL);
+    UIP_MCAST6_STATS_ADD(mcast_out);
+  }
+
+drop:
+  uip_slen = 0;
+  uip_clear_buf();
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+in()
+{
+  /*
+   * We call accept() which will sort out buffering and forwarding. Depending
+   * on accept()'s return value, we then need to signal the core
+   * whether to deliver this to higher layers
+   */
+  if(accept(MPL_DGRAM_IN) == UIP_MCAST6_DROP) {
+    return UIP_MCAST6_DROP;
+  }
+
+  if(!uip_ds6_is_my_maddr(&UIP_IP_BUF->destipaddr)) {
+    PRINTF("MPL: Not a group member. No further processing\n");
+    return UIP_MCAST6_DROP;
+  } else {
+    PRINTF("MPL: Ours. Deliver to upper layers\n");
+    UIP_MCAST6_STATS_ADD(mcast_in_ours);
+    return UIP_MCAST6_ACCEPT;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+init()
+{
+  PRINTF("MPL: RFC 7731 Multicast\n");
+
+  memset(seeds, 0, sizeof(seeds));
+  memset(&control, 0, sizeof(control));
+  uip_mcast6_arena_init(&arena, buffer_reclaim, MPL_STATS_REF(arena_max));
+
+  MPL_STATS_INIT();
+  UIP_MCAST6_STATS_INIT(&stats);
+
+  /* Control Messages go to, and come from, ALL_MPL_FORWARDERS link-local */
+  uip_ip6addr(&all_forwarders, 0xff02, 0, 0, 0, 0, 0, 0, 0x00fc);
+  uip_ds6_maddr_add(&all_forwarders);
+
+  /* Register the ICMPv6 input handler */
+  uip_icmp6_register_input_handler(&mpl_icmp_handler);
+
+  /* The Control Message timer starts when we first have something to say */
+  TIMER_CONFIGURE(&control, CONTROL_MESSAGE);
+  control.periodic = control_periodic;
+  control.interval_end = control_interval_end;
+}
+/*---------------------------------------------------------------------------*/
+static const struct uip_mcast6_stats_desc *
+describe_stats(uint8_t *n)
+{
+#if UIP_MCAST6_STATS
+  *n = sizeof(stats_desc) / sizeof(stats_desc[0]);
+  return stats_desc;
+#else
+  *n = 0;
+  return NULL;
+#endif
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief The MPL engine driver
+ */
+const struct uip_mcast6_driver mpl_driver = {
+  "MPL",
+  init,
+  out,
+  in,
+  describe_stats,
+};
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2026, The Contiki Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup uip6-multicast
+ * @{
+ */
+/**
+ * \defgroup mpl-multicast Multicast Protocol for Low-Power and Lossy Networks (MPL)
+ *
+ * IPv6 multicast according to RFC 7731.
+ *
+ * The engine keeps a Seed Set and a Buffered Message Set, using the same
+ * sliding window, per-window message list and packet arena arrangement as
+ * the ROLL TM engine. Buffered messages are retransmitted proactively under
+ * per-seed Trickle timers, while MPL Control Messages advertise what we hold
+ * as a compact bitmap for each seed and trigger reactive forwarding.
+ *
+ * MPL Data Messages carry the MPL Option in a Hop-by-Hop header which we
+ * add to the datagram itself. We do not do IPv6-in-IPv6 encapsulation, so
+ * the MPL Domain is effectively the destination's multicast scope
+ * @{
+ */
+/**
+ * \file
+ *    Header file for the MPL multicast engine
+ *
+ * \author
+ *    The Contiki Project
+ */
+
+#ifndef MPL_H_
+#define MPL_H_
+
+#include "contiki-conf.h"
+#include "net/ipv6/multicast/uip-mcast6-stats.h"
+
+#include <stdint.h>
+/*---------------------------------------------------------------------------*/
+/* Protocol Constants */
+/*---------------------------------------------------------------------------*/
+#ifndef ICMP6_MPL
+#define ICMP6_MPL                       159 /**< MPL Control Message type */
+#endif
+#define MPL_ICMP_CODE                     0 /**< MPL ICMPv6 code field */
+#define MPL_IP_HOP_LIMIT               0xFF /**< Hop limit for ICMP messages */
+#define MPL_INFINITE_REDUNDANCY        0xFF
+#define MPL_DGRAM_OUT                     0
+#define MPL_DGRAM_IN                      1
+/*---------------------------------------------------------------------------*/
+/* Configuration */
+/*---------------------------------------------------------------------------*/
+/**
+ * Seed ID format for datagrams we originate. This is the S field of the
+ * MPL Option:
+ * - 0: The Seed ID is our IPv6 source address and is elided (default)
+ * - 1: 16 bits, the last two bytes of our link-layer address
+ * - 2: 64 bits, our link-layer address. Needs 8-byte LL addresses
+ * - 3: 128 bits, our IPv6 source address carried in the option
+ *
+ * We accept all four formats on input regardless of this setting
+ */
+#ifdef MPL_CONF_SEED_ID_TYPE
+#define MPL_SEED_ID_TYPE MPL_CONF_SEED_ID_TYPE
+#else
+#define MPL_SEED_ID_TYPE 0
+#endif
+/*---------------------------------------------------------------------------*/
+/**
+ * Seed Set size. How many seeds we can track at the same time
+ */
+#ifdef MPL_CONF_SEED_SET_SIZE
+#define MPL_SEED_SET_SIZE MPL_CONF_SEED_SET_SIZE
+#else
+#define MPL_SEED_SET_SIZE 2
+#endif
+/*---------------------------------------------------------------------------*/
+/**
+ * Buffered Message Set size. Shared across all seeds. Each entry only costs
+ * a small descriptor, datagrams are stored in the arena below
+ */
+#ifdef MPL_CONF_BUFFERED_MESSAGE_SET_SIZE
+#define MPL_BUFFERED_MESSAGE_SET_SIZE MPL_CONF_BUFFERED_MESSAGE_SET_SIZE
+#else
+#define MPL_BUFFERED_MESSAGE_SET_SIZE 6
+#endif
+/*---------------------------------------------------------------------------*/
+/**
+ * Size of the packet arena in bytes. See ROLL_TM_CONF_ARENA_SIZE
+ */
+#ifdef MPL_CONF_ARENA_SIZE
+#define MPL_ARENA_SIZE MPL_CONF_ARENA_SIZE
+#else
+#define MPL_ARENA_SIZE \
+  (MPL_BUFFERED_MESSAGE_SET_SIZE * (UIP_BUFSIZE - UIP_LLH_LEN))
+#endif
+/*---------------------------------------------------------------------------*/
+/**
+ * SEED_SET_ENTRY_LIFETIME, in seconds. A seed we haven't heard new messages
+ * from for this long is removed from the Seed Set, along with anything we
+ * still buffer for it
+ */
+#ifdef MPL_CONF_SEED_SET_ENTRY_LIFETIME
+#define MPL_SEED_SET_ENTRY_LIFETIME MPL_CONF_SEED_SET_ENTRY_LIFETIME
+#else
+#define MPL_SEED_SET_ENTRY_LIFETIME (30 * 60)
+#endif
+/*---------------------------------------------------------------------------*/
+/**
+ * PROACTIVE_FORWARDING: Retransmit new messages under their seed's Trickle
+ * timer without waiting for a Control Message to tell us a neighbour misses
+ * them
+ */
+#ifdef MPL_CONF_PROACTIVE_FORWARDING
+#define MPL_PROACTIVE_FORWARDING MPL_CONF_PROACTIVE_FORWARDING
+#else
+#define MPL_PROACTIVE_FORWARDING 1
+#endif
+/*---------------------------------------------------------------------------*/
+/*
+ * Trickle parameters for Data Messages (one timer per seed) and Control
+ * Messages. Imin in clock ticks, Imax in doublings of Imin. The timers run
+ * for TIMER_EXPIRATIONS intervals after each reset. Setting
+ * MPL_CONF_CONTROL_MESSAGE_TIMER_EXPIRATIONS to 0 turns off Control Messages
+ * and with them reactive forwarding
+ */
+#ifdef MPL_CONF_DATA_MESSAGE_IMIN
+#define MPL_DATA_MESSAGE_IMIN MPL_CONF_DATA_MESSAGE_IMIN
+#else
+#define MPL_DATA_MESSAGE_IMIN (CLOCK_SECOND >> 2)
+#endif
+
+#ifdef MPL_CONF_DATA_MESSAGE_IMAX
+#define MPL_DATA_MESSAGE_IMAX MPL_CONF_DATA_MESSAGE_IMAX
+#else
+#define MPL_DATA_MESSAGE_IMAX 1
+#endif
+
+#ifdef MPL_CONF_DATA_MESSAGE_K
+#define MPL_DATA_MESSAGE_K MPL_CONF_DATA_MESSAGE_K
+#else
+#define MPL_DATA_MESSAGE_K 1
+#endif
+
+#ifdef MPL_CONF_DATA_MESSAGE_TIMER_EXPIRATIONS
+#define MPL_DATA_MESSAGE_TIMER_EXPIRATIONS \
+  MPL_CONF_DATA_MESSAGE_TIMER_EXPIRATIONS
+#else
+#define MPL_DATA_MESSAGE_TIMER_EXPIRATIONS 3
+#endif
+
+#ifdef MPL_CONF_CONTROL_MESSAGE_IMIN
+#define MPL_CONTROL_MESSAGE_IMIN MPL_CONF_CONTROL_MESSAGE_IMIN
+#else
+#define MPL_CONTROL_MESSAGE_IMIN (CLOCK_SECOND >> 2)
+#endif
+
+#ifdef MPL_CONF_CONTROL_MESSAGE_IMAX
+#define MPL_CONTROL_MESSAGE_IMAX MPL_CONF_CONTROL_MESSAGE_IMAX
+#else
+#define MPL_CONTROL_MESSAGE_IMAX 5
+#endif
+
+#ifdef MPL_CONF_CONTROL_MESSAGE_K
+#define MPL_CONTROL_MESSAGE_K MPL_CONF_CONTROL_MESSAGE_K
+#else
+#define MPL_CONTROL_MESSAGE_K 1
+#endif
+
+#ifdef MPL_CONF_CONTROL_MESSAGE_TIMER_EXPIRATIONS
+#define MPL_CONTROL_MESSAGE_TIMER_EXPIRATIONS \
+  MPL_CONF_CONTROL_MESSAGE_TIMER_EXPIRATIONS
+#else
+#define MPL_CONTROL_MESSAGE_TIMER_EXPIRATIONS 10
+#endif
+/*---------------------------------------------------------------------------*/
+/* Stats datatype */
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Multicast stats extension for the MPL engine
+ */
+struct mpl_stats {
+  /** Number of received Control Messages */
+  UIP_MCAST6_STATS_DATATYPE icmp_in;
+
+  /** Number of Control Messages sent */
+  UIP_MCAST6_STATS_DATATYPE icmp_out;
+
+  /** Number of malformed Control Messages seen by us */
+  UIP_MCAST6_STATS_DATATYPE icmp_bad;
+
+  /** Number of Seed Set entries removed after SEED_SET_ENTRY_LIFETIME */
+  UIP_MCAST6_STATS_DATATYPE seed_expired;
+
+  /** Largest number of packet arena bytes in use at the same time */
+  UIP_MCAST6_STATS_DATATYPE arena_max;
+};
+/*---------------------------------------------------------------------------*/
+#endif /* MPL_H_ */
+/*---------------------------------------------------------------------------*/
+/** @} */
+/** @} */
@@ -46,7 +46,10 @@
 #include "net/ipv6/uip-icmp6.h"
 #include "net/ipv6/multicast/uip-mcast6.h"
 #include "net/ipv6/multicast/roll-tm.h"
+#include "net/ipv6/multicast/uip-mcast6-trickle.h"
 #include "dev/watchdog.h"
+#include "lib/list.h"
+#include "lib/memb.h"
 #include <string.h>
 
 #define DEBUG DEBUG_NONE
@@ -83,67 +86,72 @@ typedef uip_ip6addr_t seed_id_t;
 #define seed_id_cpy(a, b) (memcpy((a), (b), sizeof(seed_id_t)))
 
 /* Trickle Timers */
+struct mcast_packet;
+
 struct trickle_param {
-  clock_time_t i_min;           /* Clock ticks */
-  clock_time_t t_start;         /* Start of the interval (absolute clock_time) */
-  clock_time_t t_end;           /* End of the interval (absolute clock_time) */
-  clock_time_t t_next;          /* Clock ticks, randomised in [I/2, I) */
+  struct uip_mcast6_trickle tr; /* Must be first */
   clock_time_t t_last_trigger;
-  struct ctimer ct;
-  uint8_t i_current;            /* Current doublings from i_min */
-  uint8_t i_max;                /* Max number of doublings */
-  uint8_t k;                    /* Redundancy Constant */
+  uint32_t clock;               /* Ticks, advanced on every periodic */
+  struct mcast_packet *expiry;  /* Our packets, first to expire first */
+  struct mcast_packet *expiry_tail;
+  struct mcast_packet *active;  /* First packet of expiry still in Tactive */
   uint8_t t_active;             /* Units of Imax */
   uint8_t t_dwell;              /* Units of Imax */
-  uint8_t c;                    /* Consistency Counter */
   uint8_t inconsistency;
 };
 
-/**
- * \brief Convert a timer to a sane clock_time_t value after d doublings
- * m is a value of Imin, d is a number of doublings
- * Careful of overflows
- */
-#define TRICKLE_TIME(m, d) ((clock_time_t)((m) << (d)))
-
 /**
  * \brief Convert Imax from number of doublings to clock_time_t units for
  * trickle_param t. Again, watch out for overflows */
-#define TRICKLE_IMAX(t) ((uint32_t)((t)->i_min << (t)->i_max))
+#define TRICKLE_IMAX(t) ((uint32_t)((t)->tr.i_min << (t)->tr.i_max))
 
 /**
  * \brief Convert Tactive for a trickle timer to a sane clock_time_t value
  * t is a pointer to the timer
  * Careful of overflows
  */
-#define TRICKLE_ACTIVE(t) ((uint32_t)(TRICKLE_IMAX(t) * t->t_active))
+#define TRICKLE_ACTIVE(t) ((uint32_t)(TRICKLE_IMAX(t) * (t)->t_active))
 
 /**
  * \brief Convert Tdwell for a trickle timer to a sane clock_time_t value
  * t is a pointer to the timer
  * Careful of overflows
  */
-#define TRICKLE_DWELL(t) ((uint32_t)(TRICKLE_IMAX(t) * t->t_dwell))
+#define TRICKLE_DWELL(t) ((uint32_t)(TRICKLE_IMAX(t) * (t)->t_dwell))
+
+/**
+ * \brief The current time on the clock of trickle_param t
+ *
+ * clock_time_t may be too narrow to measure Tdwell, so each timer keeps a
+ * 32-bit clock which it brings up to date on every periodic
+ */
+#define TRICKLE_CLOCK(t) \
+  ((t)->clock + (uint32_t)(clock_time() - (t)->t_last_trigger))
+
+/**
+ * \brief The M value of trickle_param t (a pointer into t[])
+ */
+#define TRICKLE_M(p) ((unsigned)((p) - t))
 
 /**
  * \brief Check if suppression is enabled for trickle_param t
  * t is a pointer to the timer
  */
-#define SUPPRESSION_ENABLED(t) ((t)->k != ROLL_TM_INFINITE_REDUNDANCY)
+#define SUPPRESSION_ENABLED(t) ((t)->tr.k != ROLL_TM_INFINITE_REDUNDANCY)
 
 /**
  * \brief Check if suppression is disabled for trickle_param t
  * t is a pointer to the timer
  */
-#define SUPPRESSION_DISABLED(t) ((t)->k == ROLL_TM_INFINITE_REDUNDANCY)
+#define SUPPRESSION_DISABLED(t) ((t)->tr.k == ROLL_TM_INFINITE_REDUNDANCY)
 
 /**
  * \brief Init trickle_timer[m]
  */
 #define TIMER_CONFIGURE(m) do { \
-  t[m].i_min = ROLL_TM_IMIN_##m; \
-  t[m].i_max = ROLL_TM_IMAX_##m; \
-  t[m].k = ROLL_TM_K_##m; \
+  t[m].tr.i_min = ROLL_TM_IMIN_##m; \
+  t[m].tr.i_max = ROLL_TM_IMAX_##m; \
+  t[m].tr.k = ROLL_TM_K_##m; \
   t[m].t_active = ROLL_TM_T_ACTIVE_##m; \
   t[m].t_dwell = ROLL_TM_T_DWELL_##m; \
   t[m].t_last_trigger = clock_time(); \
@@ -151,56 +159,45 @@ struct trickle_param {
 /*---------------------------------------------------------------------------*/
 /* Sequence Values and Serial Number Arithmetic
  *
- * Sequence Number Comparisons as per RFC1982 "Serial Number Arithmetic"
- * Our 'SERIAL_BITS' value is 15 here
- *
- * NOTE: There can be pairs of sequence numbers s1 and s2 with an undefined
- * ordering. All three macros would evaluate as 0, as in:
- * SEQ_VAL_IS_EQUAL(s1, s2) == 0 and
- * SEQ_VAL_IS_GT(s1, s2)    == 0 and
- * SEQ_VAL_IS_LT(s1, s2)    == 0
- *
- * This is not a bug of this implementation, it's an RFC design choice
- */
-
-/**
- * \brief s1 is said to be equal s2 iif SEQ_VAL_IS_EQ(s1, s2) == 1
+ * Our 'SERIAL_BITS' value is 15 here. See uip-mcast6-trickle.h for pairs of
+ * sequence values which have no defined ordering
  */
-#define SEQ_VAL_IS_EQ(i1, i2) ((i1) == (i2))
-
-/**
- * \brief s1 is said to be less than s2 iif SEQ_VAL_IS_LT(s1, s2) == 1
- */
-#define SEQ_VAL_IS_LT(i1, i2) \
-  ( \
-    ((i1) != (i2)) && \
-    ((((i1) < (i2)) && ((int16_t)((i2) - (i1)) < 0x4000)) || \
-     (((i1) > (i2)) && ((int16_t)((i1) - (i2)) > 0x4000))) \
-  )
-
-/**
- * \brief s1 is said to be greater than s2 iif SEQ_VAL_IS_LT(s1, s2) == 1
- */
-#define SEQ_VAL_IS_GT(i1, i2) \
-( \
-  ((i1) != (i2)) && \
-  ((((i1) < (i2)) && ((int16_t)((i2) - (i1)) > 0x4000)) || \
-   (((i1) > (i2)) && ((int16_t)((i1) - (i2)) < 0x4000))) \
-)
-
-/**
- * \brief Add n to s: (s + n) modulo (2 ^ SERIAL_BITS) => ((s + n) % 0x8000)
+#define SEQ_VAL_IS_EQ(i1, i2) UIP_MCAST6_SEQ_IS_EQ(i1, i2)
+#define SEQ_VAL_IS_LT(i1, i2) UIP_MCAST6_SEQ_IS_LT(i1, i2, 15)
+#define SEQ_VAL_IS_GT(i1, i2) UIP_MCAST6_SEQ_IS_GT(i1, i2, 15)
+#define SEQ_VAL_ADD(s, n) UIP_MCAST6_SEQ_ADD(s, n, 15)
+#define SEQ_VAL_OFFSET(s, base) UIP_MCAST6_SEQ_OFFSET(s, base, 15)
+/*---------------------------------------------------------------------------*/
+#if ROLL_TM_SEED_TRICKLE
+/*
+ * Trickle state of a single window, on the parameters of t[M]. Event times
+ * are ticks after t_start, so comparing them is safe across clock wraps
  */
-#define SEQ_VAL_ADD(s, n) (((s) + (n)) % 0x8000)
+struct seed_trickle {
+  clock_time_t t_start;         /* Start of the interval */
+  clock_time_t t_next;          /* Periodic, relative to t_start */
+  clock_time_t t_end;           /* End of the interval, relative to t_start */
+  uint8_t i_current;            /* Current doublings from i_min */
+  uint8_t c;                    /* Consistency Counter */
+  uint8_t inconsistency;        /* Set by the ICMP message being parsed */
+  uint8_t pending;              /* Periodic not yet handled this interval */
+};
+#endif
 /*---------------------------------------------------------------------------*/
 /* Sliding Windows */
 struct sliding_window {
+  struct sliding_window *next;  /* Next in windows_list (list.h needs this) */
+  struct sliding_window *hash_next; /* Next in its window_hash bucket */
+  struct mcast_packet *head;    /* Our buffered packets, in sequence order */
   seed_id_t seed_id;
   int16_t lower_bound;          /* lolipop */
   int16_t upper_bound;          /* lolipop */
   int16_t min_listed;           /* lolipop */
   uint8_t flags;                /* Is used, Trickle param, Is listed */
   uint8_t count;
+#if ROLL_TM_SEED_TRICKLE
+  struct seed_trickle tr;
+#endif
 };
 
 #define SLIDING_WINDOW_U_BIT 0x80       /* Is used */
@@ -225,7 +222,6 @@ struct sliding_window {
  * w: pointer to a sliding window
  */
 #define SLIDING_WINDOW_IS_USED_CLR(w) ((w)->flags &= ~SLIDING_WINDOW_U_BIT)
-#define window_free(w) SLIDING_WINDOW_IS_USED_CLR(w)
 
 /**
  * \brief Set 'Is Seen' bit for window w
@@ -263,24 +259,52 @@ struct sliding_window {
  */
 #define SLIDING_WINDOW_GET_M(w) \
   ((uint8_t)(((w)->flags & SLIDING_WINDOW_M_BIT) == SLIDING_WINDOW_M_BIT))
+
+/**
+ * \brief Flag an inconsistency for the messages of sliding window w
+ * w: pointer to a sliding window
+ */
+#if ROLL_TM_SEED_TRICKLE
+#define SLIDING_WINDOW_INCONSISTENT(w) ((w)->tr.inconsistency = 1)
+#else
+#define SLIDING_WINDOW_INCONSISTENT(w) \
+  (t[SLIDING_WINDOW_GET_M(w)].inconsistency = 1)
+#endif
+/*---------------------------------------------------------------------------*/
+/*
+ * What's left of a window taken over while its messages were within Tdwell.
+ * Anything not above upper_bound is one of those, or older
+ */
+struct window_tombstone {
+  seed_id_t seed_id;
+  uint32_t until;               /* TRICKLE_CLOCK() when all are past Tdwell */
+  int16_t upper_bound;          /* lolipop */
+  uint8_t m;                    /* Trickle parametrization */
+  uint8_t used;
+};
 /*---------------------------------------------------------------------------*/
 /* Multicast Packet Buffers */
 struct mcast_packet {
+  struct mcast_packet *next;    /* Next in window (if used) or in free list */
 #if ROLL_TM_SHORT_SEEDS
   /* Short seeds are stored inside the message */
   seed_id_t seed_id;
 #endif
-  uint32_t active;              /* Starts at 0 and increments */
-  uint32_t dwell;               /* Starts at 0 and increments */
+  struct mcast_packet *expiry_next; /* Next in its timer's expiry list */
+  uint32_t born;                /* TRICKLE_CLOCK() at reception */
+#if ROLL_TM_RECLAIM_POLICY == ROLL_TM_RECLAIM_ADVERTISED
+  uint32_t advertised;          /* TRICKLE_CLOCK() when last in our ICMP */
+#endif
   uint16_t buff_len;
   uint16_t seq_val;             /* host-byte order */
   struct sliding_window *sw;    /* Pointer to the SW this packet belongs to */
-  uint8_t flags;                /* Is-Used, Must Send, Is Listed */
-  uint8_t buff[UIP_BUFSIZE - UIP_LLH_LEN];
+  uint8_t flags;                /* Is-Used, Sent, Must Send, Is Listed */
+  uint8_t *buff;                /* Points into the packet arena */
 };
 
 /* Flag bits */
 #define MCAST_PACKET_U_BIT       0x80   /* Is Used */
+#define MCAST_PACKET_T_BIT       0x40   /* Sent at least once */
 #define MCAST_PACKET_S_BIT       0x20   /* Must Send Next Pass */
 #define MCAST_PACKET_L_BIT       0x10   /* Is listed in ICMP message */
 
@@ -333,6 +357,18 @@ struct mcast_packet {
  */
 #define MCAST_PACKET_SEND_CLR(p) ((p)->flags &= ~MCAST_PACKET_S_BIT)
 
+/**
+ * \brief Has message p been sent at least once? Our own go out right away
+ * p: pointer to a struct mcast_packet
+ */
+#define MCAST_PACKET_WAS_SENT(p) ((p)->flags & MCAST_PACKET_T_BIT)
+
+/**
+ * \brief Set 'Sent' bit for message p
+ * p: pointer to a struct mcast_packet
+ */
+#define MCAST_PACKET_SENT_SET(p) ((p)->flags |= MCAST_PACKET_T_BIT)
+
 /**
  * \brief Is the message p listed in current ICMP message?
  * p: pointer to a struct mcast_packet
@@ -356,6 +392,35 @@ struct mcast_packet {
  * p: pointer to a struct mcast_packet
  */
 #define MCAST_PACKET_FREE(p) ((p)->flags = 0)
+
+/**
+ * \brief Is a multicast packet still within Tactive (and thus advertised)?
+ * p: pointer to a struct mcast_packet
+ */
+#define MCAST_PACKET_IS_ACTIVE(p) \
+  (MCAST_PACKET_AGE(p) < (int32_t)TRICKLE_ACTIVE(MCAST_PACKET_TIMER(p)))
+
+/**
+ * \brief The trickle_param for multicast packet p
+ */
+#define MCAST_PACKET_TIMER(p) (&t[SLIDING_WINDOW_GET_M((p)->sw)])
+
+/**
+ * \brief Age of multicast packet p as of its timer's last periodic
+ * Packets received since then have a negative age
+ */
+#define MCAST_PACKET_AGE(p) \
+  ((int32_t)(MCAST_PACKET_TIMER(p)->clock - (p)->born))
+
+/**
+ * \brief Record that we just advertised multicast packet p
+ */
+#if ROLL_TM_RECLAIM_POLICY == ROLL_TM_RECLAIM_ADVERTISED
+#define MCAST_PACKET_ADVERTISED(p) \
+  ((p)->advertised = TRICKLE_CLOCK(MCAST_PACKET_TIMER(p)))
+#else
+#define MCAST_PACKET_ADVERTISED(p)
+#endif
 /*---------------------------------------------------------------------------*/
 /* Sequence Lists in Multicast Trickle ICMP messages */
 struct sequence_list_header {
@@ -364,6 +429,15 @@ struct sequence_list_header {
   seed_id_t seed_id;
 };
 
+/*
+ * With ICMP code ROLL_TM_ICMP_CODE, the header is followed by seq_len 2-byte
+ * sequence values. With ROLL_TM_ICMP_CODE_BITMAP, it is followed by a 2-byte
+ * base sequence value and by a bitmap seq_len bytes long. The MSB of the
+ * bitmap's first byte stands for the base value, the next bit for base + 1
+ * and so forth
+ */
+#define SEQUENCE_LIST_BASE_LEN 2
+
 #define SEQUENCE_LIST_S_BIT 0x80
 #define SEQUENCE_LIST_M_BIT 0x40
 #define SEQUENCE_LIST_RES   0x3F
@@ -401,7 +475,7 @@ struct hbho_mcast {
 #define HBHO_OPT_TYPE_TRICKLE 0x0C
 #define HBHO_LEN_LONG_SEED       2
 #define HBHO_LEN_SHORT_SEED      4
-#define HBHO_TOTAL_LEN           8
+#define HBHO_TOTAL_LEN           ROLL_TM_HBHO_LEN
 /**
  * \brief Get the Trickle Parametrization for a multicast HBHO header
  * m: pointer to the HBHO header
@@ -431,18 +505,49 @@ struct hbho_mcast {
 #if UIP_MCAST6_STATS
 static struct roll_tm_stats stats;
 
+static const struct uip_mcast6_stats_desc stats_desc[] = {
+  UIP_MCAST6_STATS_DESC(roll_tm_stats, icmp_in, 0),
+  UIP_MCAST6_STATS_DESC(roll_tm_stats, icmp_out, 0),
+  UIP_MCAST6_STATS_DESC(roll_tm_stats, icmp_bad, 0),
+  UIP_MCAST6_STATS_DESC(roll_tm_stats, arena_max, UIP_MCAST6_STATS_T_MAX),
+  UIP_MCAST6_STATS_DESC(roll_tm_stats, reclaim_largest, 0),
+  UIP_MCAST6_STATS_DESC(roll_tm_stats, reclaim_oldest, 0),
+  UIP_MCAST6_STATS_DESC(roll_tm_stats, reclaim_advertised, 0),
+  UIP_MCAST6_STATS_DESC(roll_tm_stats, reclaim_spent, 0),
+  UIP_MCAST6_STATS_DESC(roll_tm_stats, reclaim_failed, 0),
+  UIP_MCAST6_STATS_DESC(roll_tm_stats, win_reaped, 0),
+  UIP_MCAST6_STATS_DESC(roll_tm_stats, out_moved, 0),
+};
+
 #define ROLL_TM_STATS_ADD(x) stats.x++
+#define ROLL_TM_STATS_ADD_N(x, n) stats.x += (n)
 #define ROLL_TM_STATS_INIT() do { memset(&stats, 0, sizeof(stats)); } while(0)
+#define ROLL_TM_STATS_REF(x) (&stats.x)
 #else /* UIP_MCAST6_STATS */
 #define ROLL_TM_STATS_ADD(x)
+#define ROLL_TM_STATS_ADD_N(x, n) (void)(n)
 #define ROLL_TM_STATS_INIT()
+#define ROLL_TM_STATS_REF(x) NULL
 #endif
 /*---------------------------------------------------------------------------*/
 /* Internal Data Structures */
 /*---------------------------------------------------------------------------*/
 static struct trickle_param t[2];
-static struct sliding_window windows[ROLL_TM_WINS];
+#if ROLL_TM_SEED_TRICKLE
+static struct ctimer seed_ct;   /* Next due event of any window's trickle */
+#endif
+MEMB(windows_memb, struct sliding_window, ROLL_TM_WINS);
+LIST(windows_list);
+
+/* Seed ID to window index, chained through hash_next */
+#if ROLL_TM_WIN_HASH_SIZE & (ROLL_TM_WIN_HASH_SIZE - 1)
+#error "ROLL_TM_CONF_WIN_HASH_SIZE must be a power of 2"
+#endif
+static struct sliding_window *window_hash[ROLL_TM_WIN_HASH_SIZE];
+static struct window_tombstone tombstones[ROLL_TM_TOMBSTONES];
 static struct mcast_packet buffered_msgs[ROLL_TM_BUFF_NUM];
+UIP_MCAST6_ARENA(arena, ROLL_TM_ARENA_SIZE, struct mcast_packet,
+                 buffered_msgs);
 /*---------------------------------------------------------------------------*/
 /* Temporary Stores */
 /*---------------------------------------------------------------------------*/
@@ -461,6 +566,7 @@ static uint16_t last_seq;
 #define UIP_EXT_BUF       ((struct uip_ext_hdr *)&uip_buf[UIP_LLH_LEN + UIP_IPH_LEN])
 #define UIP_EXT_BUF_NEXT  ((uint8_t *)&uip_buf[UIP_LLH_LEN + UIP_IPH_LEN + HBHO_TOTAL_LEN])
 #define UIP_EXT_OPT_FIRST ((struct hbho_mcast *)&uip_buf[UIP_LLH_LEN + UIP_IPH_LEN + 2])
+#define UIP_EXT_OPT_PADN  ((struct uip_ext_hdr_opt_padn *)&uip_buf[UIP_LLH_LEN + UIP_IPH_LEN + 2])
 #define UIP_IP_BUF        ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
 #define UIP_ICMP_BUF      ((struct uip_icmp_hdr *)&uip_buf[uip_l2_l3_hdr_len])
 #define UIP_ICMP_PAYLOAD  ((unsigned char *)&uip_buf[uip_l2_l3_icmp_hdr_len])
@@ -469,292 +575,650 @@ extern uint16_t uip_slen;
 /* Local function prototypes */
 /*---------------------------------------------------------------------------*/
 static void icmp_input(void);
-static void icmp_output(void);
-static void window_update_bounds(void);
-static void reset_trickle_timer(uint8_t);
-static void handle_timer(void *);
+static void icmp_output(struct sliding_window *only);
+#if DEBUG
+static void window_check_bounds(void);
+#endif
+static void buffer_free(struct mcast_packet *p);
+static void window_free(struct sliding_window *w);
+#if ROLL_TM_SEED_TRICKLE
+static void seed_trickle_reset(struct sliding_window *w);
+static void seed_trickle_schedule(void);
+#endif
 /*---------------------------------------------------------------------------*/
 /* ROLL TM ICMPv6 handler declaration */
 UIP_ICMP6_HANDLER(roll_tm_icmp_handler, ICMP6_ROLL_TM,
                   UIP_ICMP6_HANDLER_CODE_ANY, icmp_input);
 /*---------------------------------------------------------------------------*/
-/* Return a random number in [I/2, I), for a timer with Imin when the timer's
- * current number of doublings is d */
-static clock_time_t
-random_interval(clock_time_t i_min, uint8_t d)
+/*
+ * Bring the clock of timer param up to date, free its packets past Tdwell
+ * and move its active cursor past those no longer within Tactive
+ */
+static void
+expiry_advance(struct trickle_param *param)
 {
-  clock_time_t min = TRICKLE_TIME(i_min >> 1, d);
+  clock_time_t now;
+  clock_time_t diff_last;       /* Time diff from last pass */
+
+  VERBOSE_PRINTF("ROLL TM: M=%u Periodic at %lu, last=%lu\n",
+                 TRICKLE_M(param), (unsigned long)clock_time(),
+                 (unsigned long)param->t_last_trigger);
 
-  VERBOSE_PRINTF("ROLL TM: Random [%lu, %lu)\n", (unsigned long)min,
-                 (unsigned long)(TRICKLE_TIME(i_min, d)));
+  /* Advance our clock */
+  now = clock_time();
+  diff_last = now - param->t_last_trigger;
+  param->t_last_trigger = now;
+  param->clock += diff_last;
 
-  return min + (random_rand() % (TRICKLE_TIME(i_min, d) - 1 - min));
+  VERBOSE_PRINTF("ROLL TM: M=%u Periodic diff from last %lu, clock %lu\n",
+                 TRICKLE_M(param),
+                 (unsigned long)diff_last, (unsigned long)param->clock);
+
+  /*
+   * Packets are appended to the expiry list as they arrive and they all have
+   * the same Tdwell and Tactive. Those past Tdwell are thus at its head and
+   * those still within Tactive at its tail, so we only ever touch packets
+   * which change state or which we may have to send
+   */
+  while(param->expiry != NULL &&
+        MCAST_PACKET_AGE(param->expiry) > (int32_t)TRICKLE_DWELL(param)) {
+    locmpptr = param->expiry;
+    locswptr = locmpptr->sw;
+    PRINTF("ROLL TM: M=%u Free Packet %u (%ld > %lu)\n",
+           TRICKLE_M(param), locmpptr->seq_val,
+           (long)MCAST_PACKET_AGE(locmpptr),
+           (unsigned long)TRICKLE_DWELL(param));
+    buffer_free(locmpptr);
+    if(locswptr->count == 0) {
+      PRINTF("ROLL TM: M=%u Free Window ", TRICKLE_M(param));
+      PRINT_SEED(&locswptr->seed_id);
+      PRINTF("\n");
+      window_free(locswptr);
+    }
+  }
+
+  while(param->active != NULL &&
+        MCAST_PACKET_AGE(param->active) >= (int32_t)TRICKLE_ACTIVE(param)) {
+    VERBOSE_PRINTF("ROLL TM: M=%u Packet %u no longer active\n",
+                   TRICKLE_M(param), param->active->seq_val);
+    param->active = param->active->expiry_next;
+  }
 }
 /*---------------------------------------------------------------------------*/
-/* Called at the end of the current interval for timer ptr */
+/* Transmit buffered packet p */
 static void
-double_interval(void *ptr)
+packet_send(struct mcast_packet *p)
 {
-  struct trickle_param *param = (struct trickle_param *)ptr;
-  int16_t offset;
-  clock_time_t next;
+  PRINTF("ROLL TM: M=%u Periodic - Sending packet from Seed ",
+         SLIDING_WINDOW_GET_M(p->sw));
+  PRINT_SEED(&p->sw->seed_id);
+  PRINTF(" seq %u\n", p->seq_val);
+  uip_len = p->buff_len;
+  memcpy(UIP_IP_BUF, p->buff, uip_len);
+
+  /* From accept() to our first transmission */
+  if(!MCAST_PACKET_WAS_SENT(p)) {
+    UIP_MCAST6_STATS_LATENCY_ADD(UIP_MCAST6_LATENCY_FWD,
+                                 TRICKLE_CLOCK(MCAST_PACKET_TIMER(p)) -
+                                 p->born);
+    MCAST_PACKET_SENT_SET(p);
+  }
 
-  /*
-   * If we got called long past our expiration, store the offset and try to
-   * compensate this period
-   */
-  offset = (int16_t)(clock_time() - param->t_end);
+  UIP_MCAST6_STATS_ADD(mcast_fwd);
+  tcpip_output(NULL);
+  MCAST_PACKET_SEND_CLR(p);
+  watchdog_periodic();
+}
+/*---------------------------------------------------------------------------*/
+#if !ROLL_TM_SEED_TRICKLE
+/* Periodic of timer tr: Send its active packets and advertise them */
+static void
+trickle_periodic(struct uip_mcast6_trickle *tr)
+{
+  struct trickle_param *param = (struct trickle_param *)tr;
+
+  expiry_advance(param);
 
-  /* Calculate next interval */
-  if(param->i_current < param->i_max) {
-    param->i_current++;
+  /* Handle multicast transmissions */
+  for(locmpptr = param->active; locmpptr != NULL;
+      locmpptr = locmpptr->expiry_next) {
+    if(MCAST_PACKET_TTL(locmpptr) > 0 &&
+       ((SUPPRESSION_ENABLED(param) && MCAST_PACKET_MUST_SEND(locmpptr)) ||
+        SUPPRESSION_DISABLED(param))) {
+      packet_send(locmpptr);
+    }
+  }
+
+  /* Suppression Enabled - Send an ICMP */
+  if(SUPPRESSION_ENABLED(param)) {
+    if(tr->c < tr->k) {
+      icmp_output(NULL);
+    }
   }
 
-  param->t_start = param->t_end;
-  param->t_end = param->t_start + (param->i_min << param->i_current);
+  /* Done handling inconsistencies for this timer */
+  param->inconsistency = 0;
+  tr->c = 0;
 
-  next = random_interval(param->i_min, param->i_current);
-  if(next > offset) {
-    next -= offset;
-  } else {
-    next = 0;
+#if DEBUG
+  window_check_bounds();
+#endif
+}
+#else /* !ROLL_TM_SEED_TRICKLE */
+/*---------------------------------------------------------------------------*/
+/* Ticks until the next event of window w's trickle is due, 0 if overdue */
+static clock_time_t
+seed_trickle_due(struct sliding_window *w)
+{
+  clock_time_t elapsed = clock_time() - w->tr.t_start;
+  clock_time_t rel = w->tr.pending ? w->tr.t_next : w->tr.t_end;
+
+  return elapsed >= rel ? 0 : rel - elapsed;
+}
+/*---------------------------------------------------------------------------*/
+/* Start a new interval at Imin for window w. Callers reschedule seed_ct */
+static void
+seed_trickle_reset(struct sliding_window *w)
+{
+  struct trickle_param *param = &t[SLIDING_WINDOW_GET_M(w)];
+
+  w->tr.t_start = clock_time();
+  w->tr.t_end = param->tr.i_min;
+  w->tr.i_current = 0;
+  w->tr.c = 0;
+  w->tr.t_next = uip_mcast6_trickle_random(param->tr.i_min, 0);
+  w->tr.pending = 1;
+
+  VERBOSE_PRINTF("ROLL TM: Reset window at %lu, End %lu, Periodic in %lu\n",
+                 (unsigned long)w->tr.t_start, (unsigned long)w->tr.t_end,
+                 (unsigned long)w->tr.t_next);
+}
+/*---------------------------------------------------------------------------*/
+/* Periodic for window w: Send its messages and advertise them */
+static void
+seed_trickle_periodic(struct sliding_window *w)
+{
+  struct trickle_param *param = &t[SLIDING_WINDOW_GET_M(w)];
+  struct mcast_packet *p;
+
+  for(p = w->head; p != NULL; p = p->next) {
+    if(MCAST_PACKET_IS_ACTIVE(p) && MCAST_PACKET_TTL(p) > 0 &&
+       (SUPPRESSION_DISABLED(param) || MCAST_PACKET_MUST_SEND(p))) {
+      packet_send(p);
+    }
+  }
+
+  if(SUPPRESSION_ENABLED(param) && w->tr.c < param->tr.k) {
+    icmp_output(w);
   }
-  param->t_next = next;
-  ctimer_set(&param->ct, param->t_next, handle_timer, (void *)param);
 
-  VERBOSE_PRINTF("ROLL TM: Doubling at %lu (offset %d), Start %lu, End %lu,"
-                 " Periodic in %lu\n", clock_time(), offset,
-                 (unsigned long)param->t_start,
-                 (unsigned long)param->t_end, (unsigned long)param->t_next);
+  w->tr.c = 0;
+  w->tr.pending = 0;
 }
 /*---------------------------------------------------------------------------*/
-/*
- * Called at a random point in [I/2,I) of the current interval for ptr
- * PARAM is a pointer to the timer that triggered the callback (&t[index])
- */
+/* End of window w's interval: Double it. Late calls eat into the next one */
 static void
-handle_timer(void *ptr)
+seed_trickle_double(struct sliding_window *w)
 {
-  struct trickle_param *param;
-  clock_time_t diff_last;       /* Time diff from last pass */
-  clock_time_t diff_start;      /* Time diff from interval start */
-  uint8_t m;
+  struct trickle_param *param = &t[SLIDING_WINDOW_GET_M(w)];
 
-  param = (struct trickle_param *)ptr;
-  if(param == &t[0]) {
-    m = 0;
-  } else if(param == &t[1]) {
-    m = 1;
-  } else {
-    /* This is an ooops and a serious one too */
-    return;
+  if(w->tr.i_current < param->tr.i_max) {
+    w->tr.i_current++;
   }
 
+  w->tr.t_start += w->tr.t_end;
+  w->tr.t_end = UIP_MCAST6_TRICKLE_TIME(param->tr.i_min, w->tr.i_current);
+  w->tr.t_next = uip_mcast6_trickle_random(param->tr.i_min, w->tr.i_current);
+  w->tr.pending = 1;
+}
+/*---------------------------------------------------------------------------*/
+/* seed_ct callback: Handle the events due for all windows */
+static void
+seed_trickle_handler(void *ptr)
+{
+  struct sliding_window *w;
+
   /* Bail out pronto if our uIPv6 stack is not ready to send messages */
   if(uip_ds6_get_link_local(ADDR_PREFERRED) == NULL) {
     VERBOSE_PRINTF
       ("ROLL TM: Suppressing timer processing. Stack not ready\n");
-    reset_trickle_timer(m);
+    for(w = list_head(windows_list); w != NULL; w = list_item_next(w)) {
+      seed_trickle_reset(w);
+    }
+    seed_trickle_schedule();
     return;
   }
 
-  VERBOSE_PRINTF("ROLL TM: M=%u Periodic at %lu, last=%lu\n",
-                 m, (unsigned long)clock_time(),
-                 (unsigned long)param->t_last_trigger);
+  /* This may free windows, so do it before we walk them */
+  expiry_advance(&t[0]);
+  expiry_advance(&t[1]);
 
-  /* Temporarily store 'now' in t_next and calculate diffs */
-  param->t_next = clock_time();
-  diff_last = param->t_next - param->t_last_trigger;
-  diff_start = param->t_next - param->t_start;
-  param->t_last_trigger = param->t_next;
-
-  VERBOSE_PRINTF
-    ("ROLL TM: M=%u Periodic diff from last %lu, from start %lu\n", m,
-     (unsigned long)diff_last, (unsigned long)diff_start);
-
-  /* Handle all buffered messages */
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    if(MCAST_PACKET_IS_USED(locmpptr)
-       && (SLIDING_WINDOW_GET_M(locmpptr->sw) == m)) {
-
-      /*
-       * if()
-       * If the packet was received during the last interval, its reception
-       * caused an inconsistency (and thus a timer reset). This means that
-       * the packet was received at about t_start, we increment by diff_start
-       *
-       * else()
-       * If the packet was not received during the last window, it is safe to
-       * increase its lifetime counters by the time diff from last pass
-       *
-       * if active == dwell == 0 but i_current != 0, this is an oops
-       * (new packet that didn't reset us). We don't handle it
-       */
-      if(locmpptr->active == 0) {
-        locmpptr->active += diff_start;
-        locmpptr->dwell += diff_start;
+  for(w = list_head(windows_list); w != NULL; w = list_item_next(w)) {
+    if(seed_trickle_due(w) == 0) {
+      if(w->tr.pending) {
+        seed_trickle_periodic(w);
       } else {
-        locmpptr->active += diff_last;
-        locmpptr->dwell += diff_last;
-      }
-
-      VERBOSE_PRINTF("ROLL TM: M=%u Packet %u active %lu of %lu\n",
-                     m, locmpptr->seq_val, locmpptr->active,
-                     TRICKLE_ACTIVE(param));
-
-      if(locmpptr->dwell > TRICKLE_DWELL(param)) {
-        locmpptr->sw->count--;
-        PRINTF("ROLL TM: M=%u Free Packet %u (%lu > %lu), Window now at %u\n",
-               m, locmpptr->seq_val, locmpptr->dwell,
-               TRICKLE_DWELL(param), locmpptr->sw->count);
-        if(locmpptr->sw->count == 0) {
-          PRINTF("ROLL TM: M=%u Free Window ", m);
-          PRINT_SEED(&locmpptr->sw->seed_id);
-          PRINTF("\n");
-          window_free(locmpptr->sw);
-        }
-        MCAST_PACKET_FREE(locmpptr);
-      } else if(MCAST_PACKET_TTL(locmpptr) > 0) {
-        /* Handle multicast transmissions */
-        if(locmpptr->active < TRICKLE_ACTIVE(param) &&
-           ((SUPPRESSION_ENABLED(param) && MCAST_PACKET_MUST_SEND(locmpptr)) ||
-           SUPPRESSION_DISABLED(param))) {
-          PRINTF("ROLL TM: M=%u Periodic - Sending packet from Seed ", m);
-          PRINT_SEED(&locmpptr->sw->seed_id);
-          PRINTF(" seq %u\n", locmpptr->seq_val);
-          uip_len = locmpptr->buff_len;
-          memcpy(UIP_IP_BUF, &locmpptr->buff, uip_len);
-
-          UIP_MCAST6_STATS_ADD(mcast_fwd);
-          tcpip_output(NULL);
-          MCAST_PACKET_SEND_CLR(locmpptr);
-          watchdog_periodic();
-        }
+        seed_trickle_double(w);
       }
     }
   }
 
-  /* Suppression Enabled - Send an ICMP */
-  if(SUPPRESSION_ENABLED(param)) {
-    if(param->c < param->k) {
-      icmp_output();
-    }
-  }
+#if DEBUG
+  window_check_bounds();
+#endif
 
-  /* Done handling inconsistencies for this timer */
-  param->inconsistency = 0;
-  param->c = 0;
+  seed_trickle_schedule();
+}
+/*---------------------------------------------------------------------------*/
+/* Arm seed_ct for the first event due across all windows */
+static void
+seed_trickle_schedule()
+{
+  struct sliding_window *w;
+  clock_time_t next = 0;
+  clock_time_t due;
 
-  window_update_bounds();
+  w = list_head(windows_list);
+  if(w == NULL) {
+    ctimer_stop(&seed_ct);
+    return;
+  }
 
-  /* Temporarily store 'now' in t_next */
-  param->t_next = clock_time();
-  if(param->t_next >= param->t_end) {
-    /* took us too long to process things, double interval asap */
-    param->t_next = 0;
-  } else {
-    param->t_next = param->t_end - param->t_next;
+  for(next = seed_trickle_due(w); w != NULL; w = list_item_next(w)) {
+    due = seed_trickle_due(w);
+    if(due < next) {
+      next = due;
+    }
   }
-  VERBOSE_PRINTF
-    ("ROLL TM: M=%u Periodic at %lu, Interval End at %lu in %lu\n", m,
-     (unsigned long)clock_time(), (unsigned long)param->t_end,
-     (unsigned long)param->t_next);
-  ctimer_set(&param->ct, param->t_next, double_interval, (void *)param);
+  ctimer_set(&seed_ct, next, seed_trickle_handler, NULL);
+}
+#endif /* !ROLL_TM_SEED_TRICKLE */
+/*---------------------------------------------------------------------------*/
+/* Index into window_hash. The last two bytes are all of a short Seed ID and
+ * the tail of the interface identifier of a long one */
+static uint8_t
+window_hash_of(const seed_id_t *s, uint8_t m)
+{
+  const uint8_t *b = (const uint8_t *)s;
 
-  return;
+  return (b[sizeof(seed_id_t) - 2] ^ b[sizeof(seed_id_t) - 1] ^ m) &
+         (ROLL_TM_WIN_HASH_SIZE - 1);
 }
 /*---------------------------------------------------------------------------*/
+/* Take window w out of the list and the index and give it back to the pool */
 static void
-reset_trickle_timer(uint8_t index)
+window_free(struct sliding_window *w)
 {
-  t[index].t_start = clock_time();
-  t[index].t_end = t[index].t_start + (t[index].i_min);
-  t[index].i_current = 0;
-  t[index].c = 0;
-  t[index].t_next = random_interval(t[index].i_min, t[index].i_current);
-
-  VERBOSE_PRINTF
-    ("ROLL TM: M=%u Reset at %lu, Start %lu, End %lu, New Interval %lu\n",
-     index, (unsigned long)t[index].t_start, (unsigned long)t[index].t_start,
-     (unsigned long)t[index].t_end, (unsigned long)t[index].t_next);
-
-  ctimer_set(&t[index].ct, t[index].t_next, handle_timer, (void *)&t[index]);
+  struct sliding_window **prev;
+
+  for(prev = &window_hash[window_hash_of(&w->seed_id,
+                                         SLIDING_WINDOW_GET_M(w))];
+      *prev != NULL; prev = &(*prev)->hash_next) {
+    if(*prev == w) {
+      *prev = w->hash_next;
+      break;
+    }
+  }
+  list_remove(windows_list, w);
+  memb_free(&windows_memb, w);
 }
 /*---------------------------------------------------------------------------*/
-static struct sliding_window *
-window_allocate()
+/* The tombstone of Seed ID s and parametrization m, NULL if there's none */
+static struct window_tombstone *
+tombstone_lookup(const seed_id_t *s, uint8_t m)
 {
-  for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
-      iterswptr--) {
-    if(!SLIDING_WINDOW_IS_USED(iterswptr)) {
-      iterswptr->count = 0;
-      iterswptr->lower_bound = -1;
-      iterswptr->upper_bound = -1;
-      iterswptr->min_listed = -1;
-      return iterswptr;
+  struct window_tombstone *ts;
+
+  for(ts = tombstones; ts < &tombstones[ROLL_TM_TOMBSTONES]; ts++) {
+    if(ts->used && ts->m == m && seed_id_cmp(s, &ts->seed_id)) {
+      if((int32_t)(TRICKLE_CLOCK(&t[m]) - ts->until) >= 0) {
+        /* Its messages would all be gone by now */
+        ts->used = 0;
+        return NULL;
+      }
+      return ts;
     }
   }
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * A free tombstone, NULL if all are in use. Those past Tdwell are free, even
+ * if nobody looked them up since
+ */
+static struct window_tombstone *
+tombstone_allocate(void)
+{
+  struct window_tombstone *ts;
+
+  for(ts = tombstones; ts < &tombstones[ROLL_TM_TOMBSTONES]; ts++) {
+    if(!ts->used ||
+       (int32_t)(TRICKLE_CLOCK(&t[ts->m]) - ts->until) >= 0) {
+      return ts;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Out of windows. Free the windows whose messages are all past Tdwell, as
+ * the next periodic would. Failing that, take over an idle one, none of
+ * whose messages we still transmit or advertise. Of those, the one with the
+ * fewest messages goes. It leaves a tombstone until its messages are past
+ * Tdwell, or stays if there's no tombstone for it
+ */
+static uint8_t
+window_reap()
+{
+  struct sliding_window *w;
+  struct sliding_window *idle = NULL;
+  struct window_tombstone *ts;
+  struct mcast_packet *p;
+  uint32_t until;
+
+  expiry_advance(&t[0]);
+  expiry_advance(&t[1]);
+  if(list_length(windows_list) < ROLL_TM_WINS) {
+    return 1;
+  }
+
+  for(w = list_head(windows_list); w != NULL; w = list_item_next(w)) {
+    p = w->head;
+    while(p != NULL && !MCAST_PACKET_IS_ACTIVE(p)) {
+      p = p->next;
+    }
+    if(p == NULL && (idle == NULL || w->count < idle->count)) {
+      idle = w;
+    }
+  }
+
+  if(idle == NULL) {
+    return 0;
+  }
+
+  ts = tombstone_allocate();
+  if(ts == NULL) {
+    PRINTF("ROLL TM: No tombstone to reap a window\n");
+    return 0;
+  }
+
+  PRINTF("ROLL TM: Reap idle window for Seed ");
+  PRINT_SEED(&idle->seed_id);
+  PRINTF(" M=%u, count %u\n", SLIDING_WINDOW_GET_M(idle), idle->count);
+
+  /* Its messages are past Tactive, but not yet past Tdwell */
+  if(idle->head != NULL) {
+    until = idle->head->born;
+    for(p = idle->head->next; p != NULL; p = p->next) {
+      if((int32_t)(p->born - until) > 0) {
+        until = p->born;
+      }
+    }
+    seed_id_cpy(&ts->seed_id, &idle->seed_id);
+    ts->m = SLIDING_WINDOW_GET_M(idle);
+    ts->until = until + TRICKLE_DWELL(&t[ts->m]);
+    ts->upper_bound = idle->upper_bound;
+    ts->used = 1;
+  }
+
+  while(idle->head != NULL) {
+    buffer_free(idle->head);
+  }
+  window_free(idle);
+  ROLL_TM_STATS_ADD(win_reaped);
+
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Get an empty window for Seed ID s and parametrization m */
+static struct sliding_window *
+window_allocate(seed_id_t *s, uint8_t m)
+{
+  struct sliding_window *w;
+  uint8_t h;
+
+  w = memb_alloc(&windows_memb);
+  if(w == NULL && window_reap()) {
+    w = memb_alloc(&windows_memb);
+  }
+  if(w == NULL) {
+    return NULL;
+  }
+
+  memset(w, 0, sizeof(struct sliding_window));
+  w->lower_bound = -1;
+  w->upper_bound = -1;
+  w->min_listed = -1;
+  seed_id_cpy(&w->seed_id, s);
+  if(m) {
+    SLIDING_WINDOW_M_SET(w);
+  }
+
+#if ROLL_TM_SEED_TRICKLE
+  /* Our clocks stand still while we have no windows. Resync them */
+  if(list_head(windows_list) == NULL) {
+    expiry_advance(&t[0]);
+    expiry_advance(&t[1]);
+  }
+  seed_trickle_reset(w);
+#endif
+
+  h = window_hash_of(s, m);
+  w->hash_next = window_hash[h];
+  window_hash[h] = w;
+  list_add(windows_list, w);
+
+  return w;
+}
+/*---------------------------------------------------------------------------*/
 static struct sliding_window *
 window_lookup(seed_id_t *s, uint8_t m)
 {
-  for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
-      iterswptr--) {
+  for(iterswptr = window_hash[window_hash_of(s, m)]; iterswptr != NULL;
+      iterswptr = iterswptr->hash_next) {
     VERBOSE_PRINTF("ROLL TM: M=%u (%u) ", SLIDING_WINDOW_GET_M(iterswptr), m);
     VERBOSE_PRINT_SEED(&iterswptr->seed_id);
     VERBOSE_PRINTF("\n");
-    if(seed_id_cmp(s, &iterswptr->seed_id) &&
-       SLIDING_WINDOW_GET_M(iterswptr) == m) {
+    if(SLIDING_WINDOW_GET_M(iterswptr) == m &&
+       seed_id_cmp(s, &iterswptr->seed_id)) {
       return iterswptr;
     }
   }
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+/* Find the packet with sequence value seq in window w */
+static struct mcast_packet *
+window_find(struct sliding_window *w, uint16_t seq)
+{
+  struct mcast_packet *p;
+
+  for(p = w->head; p != NULL; p = p->next) {
+    if(SEQ_VAL_IS_EQ(p->seq_val, seq)) {
+      return p;
+    }
+    if(SEQ_VAL_IS_GT(p->seq_val, seq)) {
+      /* Sorted, it's not further down either */
+      break;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Link packet p into the list of window w, keeping it in sequence order.
+ * The bounds are those of the list's head and tail
+ */
+static void
+window_insert(struct sliding_window *w, struct mcast_packet *p)
+{
+  struct mcast_packet **prev;
+
+  for(prev = &w->head; *prev != NULL; prev = &(*prev)->next) {
+    if(SEQ_VAL_IS_GT((*prev)->seq_val, p->seq_val)) {
+      break;
+    }
+  }
+  p->next = *prev;
+  *prev = p;
+
+  w->count++;
+  w->lower_bound = w->head->seq_val;
+  if(p->next == NULL) {
+    w->upper_bound = p->seq_val;
+  }
+
+  VERBOSE_PRINTF("ROLL TM: Insert %u, Bounds: [%d - %d]\n",
+                 p->seq_val, w->lower_bound, w->upper_bound);
+}
+/*---------------------------------------------------------------------------*/
+/* Unlink packet p from the list of window w */
 static void
-window_update_bounds()
+window_remove(struct sliding_window *w, struct mcast_packet *p)
 {
-  for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
-      iterswptr--) {
-    iterswptr->lower_bound = -1;
-  }
-
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    if(MCAST_PACKET_IS_USED(locmpptr)) {
-      iterswptr = locmpptr->sw;
-      VERBOSE_PRINTF("ROLL TM: Update Bounds: [%d - %d] vs %u\n",
-                     iterswptr->lower_bound, iterswptr->upper_bound,
-                     locmpptr->seq_val);
-      if(iterswptr->lower_bound < 0
-         || SEQ_VAL_IS_LT(locmpptr->seq_val, iterswptr->lower_bound)) {
-        iterswptr->lower_bound = locmpptr->seq_val;
-      }
-      if(iterswptr->upper_bound < 0 ||
-         SEQ_VAL_IS_GT(locmpptr->seq_val, iterswptr->upper_bound)) {
-        iterswptr->upper_bound = locmpptr->seq_val;
+  struct mcast_packet *prev = NULL;
+  struct mcast_packet *q;
+
+  for(q = w->head; q != NULL && q != p; q = q->next) {
+    prev = q;
+  }
+  if(q == NULL) {
+    return;
+  }
+
+  if(prev != NULL) {
+    prev->next = p->next;
+  } else {
+    w->head = p->next;
+  }
+  w->count--;
+
+  if(w->head == NULL) {
+    w->lower_bound = -1;
+  } else {
+    w->lower_bound = w->head->seq_val;
+    if(p->next == NULL) {
+      w->upper_bound = prev->seq_val;
+    }
+  }
+
+  VERBOSE_PRINTF("ROLL TM: Remove %u, Bounds: [%d - %d]\n",
+                 p->seq_val, w->lower_bound, w->upper_bound);
+}
+/*---------------------------------------------------------------------------*/
+#if DEBUG
+/* Recalculate all bounds and counts from scratch and complain on mismatch */
+static void
+window_check_bounds()
+{
+  struct mcast_packet *p;
+  int16_t lower;
+  int16_t upper;
+  uint8_t count;
+
+  for(iterswptr = list_head(windows_list); iterswptr != NULL;
+      iterswptr = list_item_next(iterswptr)) {
+    if(!SLIDING_WINDOW_IS_USED(iterswptr)) {
+      continue;
+    }
+    lower = -1;
+    upper = iterswptr->upper_bound;
+    count = 0;
+    for(p = iterswptr->head; p != NULL; p = p->next) {
+      if(lower == -1) {
+        lower = p->seq_val;
       }
+      upper = p->seq_val;
+      count++;
+    }
+    if(lower != iterswptr->lower_bound || upper != iterswptr->upper_bound ||
+       count != iterswptr->count) {
+      PRINTF("ROLL TM: Window ");
+      PRINT_SEED(&iterswptr->seed_id);
+      PRINTF(" has [%d - %d] count %u, expected [%d - %d] count %u\n",
+             iterswptr->lower_bound, iterswptr->upper_bound,
+             iterswptr->count, lower, upper, count);
     }
   }
 }
+#endif
 /*---------------------------------------------------------------------------*/
+/* Append p to the expiry list of its timer */
+static void
+expiry_insert(struct mcast_packet *p)
+{
+  struct trickle_param *param = MCAST_PACKET_TIMER(p);
+
+  p->born = TRICKLE_CLOCK(param);
+  MCAST_PACKET_ADVERTISED(p);
+  p->expiry_next = NULL;
+  if(param->expiry_tail != NULL) {
+    param->expiry_tail->expiry_next = p;
+  } else {
+    param->expiry = p;
+  }
+  param->expiry_tail = p;
+  if(param->active == NULL) {
+    param->active = p;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Unlink p from the expiry list of its timer. Usually, p is its head */
+static void
+expiry_remove(struct mcast_packet *p)
+{
+  struct trickle_param *param = MCAST_PACKET_TIMER(p);
+  struct mcast_packet *prev = NULL;
+  struct mcast_packet *q;
+
+  for(q = param->expiry; q != NULL && q != p; q = q->expiry_next) {
+    prev = q;
+  }
+  if(q == NULL) {
+    return;
+  }
+
+  if(prev != NULL) {
+    prev->expiry_next = p->expiry_next;
+  } else {
+    param->expiry = p->expiry_next;
+  }
+  if(param->expiry_tail == p) {
+    param->expiry_tail = prev;
+  }
+  if(param->active == p) {
+    param->active = p->expiry_next;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Unlink p from its window and return it to the free list */
+static void
+buffer_free(struct mcast_packet *p)
+{
+  if(MCAST_PACKET_IS_USED(p)) {
+    window_remove(p->sw, p);
+    expiry_remove(p);
+  }
+  MCAST_PACKET_FREE(p);
+  uip_mcast6_arena_free(&arena, p);
+}
+/*---------------------------------------------------------------------------*/
+/* Reclaim policies: Each returns the packet to evict or NULL */
+/*---------------------------------------------------------------------------*/
+/* The lowest sequence value of the largest window, if it has more than one */
 static struct mcast_packet *
-buffer_reclaim()
+reclaim_largest()
 {
-  struct sliding_window *largest = windows;
-  struct mcast_packet *rv;
+  struct sliding_window *largest = NULL;
+  struct sliding_window *w;
 
-  for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
-      iterswptr--) {
-    if(iterswptr->count > largest->count) {
-      largest = iterswptr;
+  for(w = list_head(windows_list); w != NULL; w = list_item_next(w)) {
+    if(largest == NULL || w->count > largest->count) {
+      largest = w;
     }
   }
 
-  if(largest->count == 1) {
+  if(largest == NULL || largest->count <= 1) {
     /* Can't reclaim last entry for a window and this is the largest window */
     return NULL;
   }
@@ -763,44 +1227,237 @@ buffer_reclaim()
   PRINT_SEED(&largest->seed_id);
   PRINTF(" M=%u, count was %u\n",
          SLIDING_WINDOW_GET_M(largest), largest->count);
-  /* Find the packet at the lowest bound for the largest window */
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    if(MCAST_PACKET_IS_USED(locmpptr) && (locmpptr->sw == largest) &&
-       SEQ_VAL_IS_EQ(locmpptr->seq_val, largest->lower_bound)) {
-      rv = locmpptr;
-      PRINTF("ROLL TM: Reclaim seq. val %u\n", locmpptr->seq_val);
-      MCAST_PACKET_FREE(rv);
-      largest->count--;
-      window_update_bounds();
-      VERBOSE_PRINTF("ROLL TM: Reclaim - new bounds [%u , %u]\n",
-                     largest->lower_bound, largest->upper_bound);
-      return rv;
+
+  /* The packet at the lowest bound for the largest window: Head of its list */
+  return largest->head;
+}
+/*---------------------------------------------------------------------------*/
+#if ROLL_TM_RECLAIM_POLICY == ROLL_TM_RECLAIM_OLDEST || \
+    ROLL_TM_RECLAIM_POLICY == ROLL_TM_RECLAIM_SPENT
+/* Time left until p reaches Tdwell */
+static int32_t
+dwell_left(struct mcast_packet *p)
+{
+  struct trickle_param *param = MCAST_PACKET_TIMER(p);
+
+  return (int32_t)TRICKLE_DWELL(param) -
+         (int32_t)(TRICKLE_CLOCK(param) - p->born);
+}
+#endif
+/*---------------------------------------------------------------------------*/
+#if ROLL_TM_RECLAIM_POLICY == ROLL_TM_RECLAIM_OLDEST
+/* The packet which would expire first: One of the expiry list heads */
+static struct mcast_packet *
+reclaim_oldest()
+{
+  if(t[0].expiry == NULL) {
+    return t[1].expiry;
+  }
+  if(t[1].expiry == NULL) {
+    return t[0].expiry;
+  }
+  return dwell_left(t[0].expiry) <= dwell_left(t[1].expiry) ?
+         t[0].expiry : t[1].expiry;
+}
+#endif
+/*---------------------------------------------------------------------------*/
+#if ROLL_TM_RECLAIM_POLICY == ROLL_TM_RECLAIM_ADVERTISED
+/* The packet which we have gone the longest without advertising */
+static struct mcast_packet *
+reclaim_advertised()
+{
+  struct mcast_packet *p;
+  struct mcast_packet *rv = NULL;
+  uint32_t now;
+  uint32_t since;
+  uint32_t age;
+  uint32_t rv_since = 0;
+  uint32_t rv_age = 0;
+
+  for(p = &buffered_msgs[ROLL_TM_BUFF_NUM - 1]; p >= buffered_msgs; p--) {
+    if(MCAST_PACKET_IS_USED(p)) {
+      now = TRICKLE_CLOCK(MCAST_PACKET_TIMER(p));
+      since = now - p->advertised;
+      age = now - p->born;
+      /* On a tie, the older one goes */
+      if(rv == NULL || since > rv_since ||
+         (since == rv_since && age > rv_age)) {
+        rv = p;
+        rv_since = since;
+        rv_age = age;
+      }
     }
   }
-
-  /* oops */
-  return NULL;
+  return rv;
 }
+#endif
 /*---------------------------------------------------------------------------*/
+#if ROLL_TM_RECLAIM_POLICY == ROLL_TM_RECLAIM_SPENT
+/*
+ * The oldest of the packets we will not transmit again: Those past Tactive
+ * and those whose hop limit has run out
+ */
 static struct mcast_packet *
-buffer_allocate()
+reclaim_spent()
 {
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    if(!MCAST_PACKET_IS_USED(locmpptr)) {
-      return locmpptr;
+  struct mcast_packet *p;
+  struct mcast_packet *rv = NULL;
+
+  for(p = &buffered_msgs[ROLL_TM_BUFF_NUM - 1]; p >= buffered_msgs; p--) {
+    if(MCAST_PACKET_IS_USED(p) &&
+       (!MCAST_PACKET_IS_ACTIVE(p) || MCAST_PACKET_TTL(p) == 0)) {
+      if(rv == NULL || dwell_left(p) < dwell_left(rv)) {
+        rv = p;
+      }
     }
   }
-  return NULL;
+  return rv;
+}
+#endif
+/*---------------------------------------------------------------------------*/
+/*
+ * Evict p. If p is not the lowest in its window, a retransmission of the
+ * lower ones would be taken for a new message once p is gone, so they go
+ * too. Frees the window if it ends up empty. Returns the number evicted
+ */
+static uint8_t
+reclaim_evict(struct mcast_packet *p)
+{
+  struct sliding_window *w = p->sw;
+  struct mcast_packet *q;
+  uint8_t n = 0;
+
+  do {
+    q = w->head;
+    PRINTF("ROLL TM: Reclaim seq. val %u\n", q->seq_val);
+    buffer_free(q);
+    n++;
+  } while(q != p);
+
+  VERBOSE_PRINTF("ROLL TM: Reclaim - new bounds [%d , %d]\n",
+                 w->lower_bound, w->upper_bound);
+
+  /* accept() is about to store a message in locswptr, even if empty now */
+  if(w->count == 0 && w != locswptr) {
+    window_free(w);
+  }
+
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+buffer_reclaim()
+{
+  struct mcast_packet *rv;
+  uint8_t n;
+
+#if ROLL_TM_RECLAIM_POLICY == ROLL_TM_RECLAIM_OLDEST
+  rv = reclaim_oldest();
+  if(rv != NULL) {
+    n = reclaim_evict(rv);
+    ROLL_TM_STATS_ADD_N(reclaim_oldest, n);
+    return 1;
+  }
+#elif ROLL_TM_RECLAIM_POLICY == ROLL_TM_RECLAIM_ADVERTISED
+  rv = reclaim_advertised();
+  if(rv != NULL) {
+    n = reclaim_evict(rv);
+    ROLL_TM_STATS_ADD_N(reclaim_advertised, n);
+    return 1;
+  }
+#elif ROLL_TM_RECLAIM_POLICY == ROLL_TM_RECLAIM_SPENT
+  rv = reclaim_spent();
+  if(rv != NULL) {
+    n = reclaim_evict(rv);
+    ROLL_TM_STATS_ADD_N(reclaim_spent, n);
+    return 1;
+  }
+#endif
+
+  rv = reclaim_largest();
+  if(rv != NULL) {
+    n = reclaim_evict(rv);
+    ROLL_TM_STATS_ADD_N(reclaim_largest, n);
+    return 1;
+  }
+
+  ROLL_TM_STATS_ADD(reclaim_failed);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+#if ROLL_TM_ICMP_BITMAP
+/*
+ * Number of bitmap bytes needed to advertise the active packets of window w.
+ * Stores the sequence value of the first active packet in base. Returns 0 if
+ * there is nothing to advertise
+ */
+static uint16_t
+window_bitmap_len(struct sliding_window *w, uint16_t *base)
+{
+  struct mcast_packet *p;
+  uint16_t len = 0;
+
+  for(p = w->head; p != NULL; p = p->next) {
+    if(MCAST_PACKET_IS_ACTIVE(p)) {
+      if(len == 0) {
+        *base = p->seq_val;
+      }
+      len = (SEQ_VAL_OFFSET(p->seq_val, *base) >> 3) + 1;
+    }
+  }
+  return len;
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Pick an encoding for our next ICMP message: 1 if bitmaps will be shorter
+ * than the 2-byte lists for all windows combined, 0 otherwise. Only window
+ * only is considered, unless NULL
+ */
+static uint8_t
+icmp_output_bitmap(struct sliding_window *only)
+{
+  uint16_t list_len = 0;
+  uint16_t bitmap_len = 0;
+  uint16_t len;
+  uint16_t base;
+
+  for(iterswptr = list_head(windows_list); iterswptr != NULL;
+      iterswptr = list_item_next(iterswptr)) {
+    if(!SLIDING_WINDOW_IS_USED(iterswptr) || iterswptr->count == 0 ||
+       (only != NULL && iterswptr != only)) {
+      continue;
+    }
+    len = window_bitmap_len(iterswptr, &base);
+    if(len > 0xFF) {
+      /* seq_len can't hold it */
+      return 0;
+    }
+    if(len > 0) {
+      bitmap_len += SEQUENCE_LIST_BASE_LEN + len;
+      for(locmpptr = iterswptr->head; locmpptr != NULL;
+          locmpptr = locmpptr->next) {
+        if(MCAST_PACKET_IS_ACTIVE(locmpptr)) {
+          list_len += 2;
+        }
+      }
+    }
+  }
+  return bitmap_len < list_len;
+}
+#endif /* ROLL_TM_ICMP_BITMAP */
+/*---------------------------------------------------------------------------*/
+/* Advertise our buffered messages: Those of window only, or all if NULL */
 static void
-icmp_output()
+icmp_output(struct sliding_window *only)
 {
   struct sequence_list_header *sl;
   uint8_t *buffer;
   uint16_t payload_len;
+  uint8_t bitmap = 0;
+#if ROLL_TM_ICMP_BITMAP
+  uint16_t base;
+  uint16_t offset;
+#endif
 
   PRINTF("ROLL TM: ICMPv6 Out\n");
 
@@ -815,9 +1472,14 @@ icmp_output()
 
   VERBOSE_PRINTF("ROLL TM: ICMPv6 Out - Hdr @ %p, payload @ %p\n", UIP_ICMP_BUF, sl);
 
-  for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
-      iterswptr--) {
-    if(SLIDING_WINDOW_IS_USED(iterswptr) && iterswptr->count > 0) {
+#if ROLL_TM_ICMP_BITMAP
+  bitmap = icmp_output_bitmap(only);
+#endif
+
+  for(iterswptr = list_head(windows_list); iterswptr != NULL;
+      iterswptr = list_item_next(iterswptr)) {
+    if(SLIDING_WINDOW_IS_USED(iterswptr) && iterswptr->count > 0 &&
+       (only == NULL || iterswptr == only)) {
       memset(sl, 0, sizeof(struct sequence_list_header));
 #if ROLL_TM_SHORT_SEEDS
       sl->flags = SEQUENCE_LIST_S_BIT;
@@ -832,13 +1494,34 @@ icmp_output()
 
       buffer = (uint8_t *)sl + sizeof(struct sequence_list_header);
 
-      for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-          locmpptr >= buffered_msgs; locmpptr--) {
-        if(MCAST_PACKET_IS_USED(locmpptr) &&
-           locmpptr->active < TRICKLE_ACTIVE((&t[SLIDING_WINDOW_GET_M(iterswptr)]))) {
-          if(locmpptr->sw == iterswptr) {
+#if ROLL_TM_ICMP_BITMAP
+      if(bitmap) {
+        sl->seq_len = window_bitmap_len(iterswptr, &base);
+        PRINTF(", Base=%u", base);
+        *buffer = (uint8_t)(base >> 8);
+        buffer++;
+        *buffer = (uint8_t)(base & 0xFF);
+        buffer++;
+        memset(buffer, 0, sl->seq_len);
+        for(locmpptr = iterswptr->head; locmpptr != NULL;
+            locmpptr = locmpptr->next) {
+          if(MCAST_PACKET_IS_ACTIVE(locmpptr)) {
+            PRINTF(", %u", locmpptr->seq_val);
+            MCAST_PACKET_ADVERTISED(locmpptr);
+            offset = SEQ_VAL_OFFSET(locmpptr->seq_val, base);
+            buffer[offset >> 3] |= 0x80 >> (offset & 7);
+          }
+        }
+        buffer += sl->seq_len;
+      } else
+#endif
+      {
+        for(locmpptr = iterswptr->head; locmpptr != NULL;
+            locmpptr = locmpptr->next) {
+          if(MCAST_PACKET_IS_ACTIVE(locmpptr)) {
             sl->seq_len++;
             PRINTF(", %u", locmpptr->seq_val);
+            MCAST_PACKET_ADVERTISED(locmpptr);
             *buffer = (uint8_t)(locmpptr->seq_val >> 8);
             buffer++;
             *buffer = (uint8_t)(locmpptr->seq_val & 0xFF);
@@ -850,7 +1533,7 @@ icmp_output()
 
       /* Scrap the entire window if it has no content */
       if(sl->seq_len > 0) {
-        payload_len += sizeof(struct sequence_list_header) + sl->seq_len * 2;
+        payload_len += buffer - (uint8_t *)sl;
         sl = (struct sequence_list_header *)buffer;
       }
     }
@@ -868,7 +1551,7 @@ icmp_output()
   UIP_IP_BUF->len[1] = (UIP_ICMPH_LEN + payload_len) & 0xff;
 
   UIP_ICMP_BUF->type = ICMP6_ROLL_TM;
-  UIP_ICMP_BUF->icode = ROLL_TM_ICMP_CODE;
+  UIP_ICMP_BUF->icode = bitmap ? ROLL_TM_ICMP_CODE_BITMAP : ROLL_TM_ICMP_CODE;
 
   UIP_ICMP_BUF->icmpchksum = 0;
   UIP_ICMP_BUF->icmpchksum = ~uip_icmp6chksum();
@@ -894,6 +1577,7 @@ static uint8_t
 accept(uint8_t in)
 {
   seed_id_t *seed_ptr;
+  struct window_tombstone *ts;
   uint8_t m;
   uint16_t seq_val;
 
@@ -978,17 +1662,19 @@ accept(uint8_t in)
       UIP_MCAST6_STATS_ADD(mcast_dropped);
       return UIP_MCAST6_DROP;
     }
-    for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-        locmpptr >= buffered_msgs; locmpptr--) {
-      if(MCAST_PACKET_IS_USED(locmpptr) &&
-         locmpptr->sw == locswptr &&
-         SLIDING_WINDOW_GET_M(locmpptr->sw) == m &&
-         SEQ_VAL_IS_EQ(seq_val, locmpptr->seq_val)) {
-        /* Seen before , drop */
-        PRINTF("ROLL TM: Seen before\n");
-        UIP_MCAST6_STATS_ADD(mcast_dropped);
-        return UIP_MCAST6_DROP;
-      }
+    if(window_find(locswptr, seq_val) != NULL) {
+      /* Seen before , drop */
+      PRINTF("ROLL TM: Seen before\n");
+      UIP_MCAST6_STATS_ADD(mcast_dropped);
+      return UIP_MCAST6_DROP;
+    }
+  } else {
+    ts = tombstone_lookup(seed_ptr, m);
+    if(ts != NULL && !SEQ_VAL_IS_GT(seq_val, ts->upper_bound)) {
+      /* Buffered before we reaped its window, or older */
+      PRINTF("ROLL TM: Too old, reaped window\n");
+      UIP_MCAST6_STATS_ADD(mcast_dropped);
+      return UIP_MCAST6_DROP;
     }
   }
 
@@ -997,7 +1683,7 @@ accept(uint8_t in)
   /* We have not seen this message before */
   /* Allocate a window if we have to */
   if(!locswptr) {
-    locswptr = window_allocate();
+    locswptr = window_allocate(seed_ptr, m);
     PRINTF("ROLL TM: New seed\n");
   }
   if(!locswptr) {
@@ -1008,11 +1694,7 @@ accept(uint8_t in)
   }
 
   /* Allocate a buffer */
-  locmpptr = buffer_allocate();
-  if(!locmpptr) {
-    PRINTF("ROLL TM: Buffer allocation failed, reclaiming\n");
-    locmpptr = buffer_reclaim();
-  }
+  locmpptr = uip_mcast6_arena_alloc(&arena, uip_len);
 
   if(!locmpptr) {
     /* Failed to allocate / reclaim a buffer. If the window has only just been
@@ -1020,9 +1702,9 @@ accept(uint8_t in)
     PRINTF("ROLL TM: Buffer reclaim failed\n");
     if(locswptr->count == 0) {
       window_free(locswptr);
-      UIP_MCAST6_STATS_ADD(mcast_dropped);
-      return UIP_MCAST6_DROP;
     }
+    UIP_MCAST6_STATS_ADD(mcast_dropped);
+    return UIP_MCAST6_DROP;
   }
 #if UIP_MCAST6_STATS
   if(in == ROLL_TM_DGRAM_IN) {
@@ -1031,39 +1713,28 @@ accept(uint8_t in)
 #endif
 
   /* We have a window and we have a buffer. Accept this message */
-  /* Set the seed ID and correct M for this window */
-  SLIDING_WINDOW_M_CLR(locswptr);
-  if(m) {
-    SLIDING_WINDOW_M_SET(locswptr);
-  }
   SLIDING_WINDOW_IS_USED_SET(locswptr);
-  seed_id_cpy(&locswptr->seed_id, seed_ptr);
   PRINTF("ROLL TM: Window for seed ");
   PRINT_SEED(&locswptr->seed_id);
   PRINTF(" M=%u, count=%u\n",
          SLIDING_WINDOW_GET_M(locswptr), locswptr->count);
 
-  /* If this window was previously empty, set its lower bound to this packet */
-  if(locswptr->count == 0) {
-    locswptr->lower_bound = seq_val;
-    VERBOSE_PRINTF("ROLL TM: New Lower Bound %u\n", locswptr->lower_bound);
-  }
-
-  /* If this is a new Seq Num, update the window upper bound */
-  if(locswptr->count == 0 || SEQ_VAL_IS_GT(seq_val, locswptr->upper_bound)) {
-    locswptr->upper_bound = seq_val;
-    VERBOSE_PRINTF("ROLL TM: New Upper Bound %u\n", locswptr->upper_bound);
-  }
-
-  locswptr->count++;
-
-  memset(locmpptr, 0, sizeof(struct mcast_packet));
-  memcpy(&locmpptr->buff, UIP_IP_BUF, uip_len);
+  memcpy(locmpptr->buff, UIP_IP_BUF, uip_len);
   locmpptr->sw = locswptr;
   locmpptr->buff_len = uip_len;
   locmpptr->seq_val = seq_val;
   MCAST_PACKET_USED_SET(locmpptr);
 
+  /* Link it in. This also updates the window's bounds and count */
+  window_insert(locswptr, locmpptr);
+  expiry_insert(locmpptr);
+
+  /* The window's lower bound takes over from the tombstone */
+  ts = tombstone_lookup(seed_ptr, m);
+  if(ts != NULL) {
+    ts->used = 0;
+  }
+
   PRINTF("ROLL TM: Window for seed ");
   PRINT_SEED(&locswptr->seed_id);
   PRINTF(" M=%u, %u values within [%u , %u]\n",
@@ -1080,24 +1751,100 @@ accept(uint8_t in)
     MCAST_PACKET_SEND_SET(locmpptr);
     MCAST_PACKET_TTL(locmpptr)--;
 
+#if ROLL_TM_SEED_TRICKLE
+    PRINTF("ROLL TM: Inconsistency. Reset window trickle\n");
+    seed_trickle_reset(locswptr);
+#else
     t[m].inconsistency = 1;
 
     PRINTF("ROLL TM: Inconsistency. Reset T%u\n", m);
-    reset_trickle_timer(m);
+    uip_mcast6_trickle_reset(&t[m].tr);
+#endif
+  } else {
+    /* Our caller sends it right away, this is no forwarding latency */
+    MCAST_PACKET_SENT_SET(locmpptr);
   }
 
+#if ROLL_TM_SEED_TRICKLE
+  seed_trickle_schedule();
+#endif
+
   /* Deliver if necessary */
   return UIP_MCAST6_ACCEPT;
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Check an advertised bitmap of len bytes, starting at sequence value base,
+ * against our own packets in window w. We build our own bitmap one byte at a
+ * time from the window's list: Values set in both are listed, values only
+ * set in theirs from our lower bound up are messages we are missing.
+ * Returns 1 if we are missing any
+ */
+static uint8_t
+window_bitmap_cmp(struct sliding_window *w, uint16_t base, uint8_t *bm,
+                  uint8_t len)
+{
+  struct mcast_packet *p;
+  uint16_t offset;
+  uint16_t lower = 0;
+  uint8_t ours;
+  uint8_t missing = 0;
+  uint8_t bit;
+  uint8_t i;
+
+  /* Advertised values below our lower bound are old news */
+  if(w->lower_bound >= 0 && SEQ_VAL_IS_LT(base, w->lower_bound)) {
+    lower = SEQ_VAL_OFFSET(w->lower_bound, base);
+  }
+
+  /* Our packets below base were not listed */
+  p = w->head;
+  while(p != NULL && SEQ_VAL_IS_LT(p->seq_val, base)) {
+    p = p->next;
+  }
+
+  for(i = 0; i < len; i++) {
+    ours = 0;
+    for(; p != NULL; p = p->next) {
+      offset = SEQ_VAL_OFFSET(p->seq_val, base);
+      if((offset >> 3) != i) {
+        break;
+      }
+      bit = 0x80 >> (offset & 7);
+      ours |= bit;
+      if(bm[i] & bit) {
+        MCAST_PACKET_LISTED_SET(p);
+        PRINTF("ROLL TM: ICMPv6 In, %u listed\n", p->seq_val);
+        /* The list is sorted, the first one we see is the lowest */
+        if(w->min_listed == -1) {
+          w->min_listed = p->seq_val;
+        }
+      }
+    }
+
+    if(lower >= (uint16_t)(i + 1) << 3) {
+      continue;
+    }
+    if(lower > (uint16_t)i << 3) {
+      missing |= bm[i] & ~ours & (0xFF >> (lower & 7));
+    } else {
+      missing |= bm[i] & ~ours;
+    }
+  }
+
+  return missing != 0;
+}
+/*---------------------------------------------------------------------------*/
 /* ROLL TM ICMPv6 Input Handler */
 static void
 icmp_input()
 {
   uint8_t inconsistency;
+  uint8_t bitmap;
   uint16_t *seq_ptr;
   uint16_t *end_ptr;
   uint16_t val;
+  uint8_t *payload_end;
 
 #if UIP_CONF_IPV6_CHECKS
   if(!uip_is_addr_linklocal(&UIP_IP_BUF->srcipaddr)) {
@@ -1117,7 +1864,8 @@ icmp_input()
     goto discard;
   }
 
-  if(UIP_ICMP_BUF->icode != ROLL_TM_ICMP_CODE) {
+  if(UIP_ICMP_BUF->icode != ROLL_TM_ICMP_CODE &&
+     UIP_ICMP_BUF->icode != ROLL_TM_ICMP_CODE_BITMAP) {
     PRINTF("ROLL TM: ICMPv6 In, bad ICMP code\n");
     ROLL_TM_STATS_ADD(icmp_bad);
     goto discard;
@@ -1136,27 +1884,26 @@ icmp_input()
 
   ROLL_TM_STATS_ADD(icmp_in);
 
-  /* Reset Is-Listed bit for all windows */
-  for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
-      iterswptr--) {
+  /* Reset Is-Listed bit for all windows and their cached packets */
+  for(iterswptr = list_head(windows_list); iterswptr != NULL;
+      iterswptr = list_item_next(iterswptr)) {
     SLIDING_WINDOW_LISTED_CLR(iterswptr);
+#if ROLL_TM_SEED_TRICKLE
+    iterswptr->tr.inconsistency = 0;
+#endif
+    for(locmpptr = iterswptr->head; locmpptr != NULL;
+        locmpptr = locmpptr->next) {
+      MCAST_PACKET_LISTED_CLR(locmpptr);
+    }
   }
 
-  /* Reset Is-Listed bit for all cached packets */
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    MCAST_PACKET_LISTED_CLR(locmpptr);
-  }
-
+  bitmap = UIP_ICMP_BUF->icode == ROLL_TM_ICMP_CODE_BITMAP;
   locslhptr = (struct sequence_list_header *)UIP_ICMP_PAYLOAD;
+  payload_end = (uint8_t *)UIP_ICMP_PAYLOAD + uip_len - uip_l2_l3_icmp_hdr_len;
 
   VERBOSE_PRINTF("ROLL TM: ICMPv6 In, parse from %p to %p\n",
-                 UIP_ICMP_PAYLOAD,
-                 (uint8_t *)UIP_ICMP_PAYLOAD + uip_len -
-                 uip_l2_l3_icmp_hdr_len);
-  while(locslhptr <
-        (struct sequence_list_header *)((uint8_t *)UIP_ICMP_PAYLOAD +
-                                        uip_len - uip_l2_l3_icmp_hdr_len)) {
+                 UIP_ICMP_PAYLOAD, payload_end);
+  while((uint8_t *)locslhptr < payload_end) {
     VERBOSE_PRINTF("ROLL TM: ICMPv6 In, seq hdr @ %p\n", locslhptr);
 
     if((locslhptr->flags & SEQUENCE_LIST_RES) != 0) {
@@ -1184,9 +1931,18 @@ icmp_input()
 
     seq_ptr = (uint16_t *)((uint8_t *)locslhptr
                            + sizeof(struct sequence_list_header));
-    end_ptr = (uint16_t *)((uint8_t *)locslhptr
-                           + sizeof(struct sequence_list_header) +
-                           locslhptr->seq_len * 2);
+    if(bitmap) {
+      end_ptr = (uint16_t *)((uint8_t *)seq_ptr + SEQUENCE_LIST_BASE_LEN +
+                             locslhptr->seq_len);
+    } else {
+      end_ptr = seq_ptr + locslhptr->seq_len;
+    }
+
+    if((uint8_t *)end_ptr > payload_end) {
+      PRINTF("ROLL TM: ICMPv6 In, truncated sequence list\n");
+      ROLL_TM_STATS_ADD(icmp_bad);
+      goto drop;
+    }
 
     /* Fetch a pointer to the corresponding trickle timer */
     loctpptr = &t[SEQUENCE_LIST_GET_M(locslhptr)];
@@ -1203,50 +1959,56 @@ icmp_input()
       locswptr->min_listed = -1;
       PRINTF("ROLL TM: ICMPv6 In, Window bounds [%u , %u]\n",
              locswptr->lower_bound, locswptr->upper_bound);
-      for(; seq_ptr < end_ptr; seq_ptr++) {
-        /* Check for "They have new" */
-        /* If an advertised seq. val is GT our upper bound */
-        val = uip_htons(*seq_ptr);
-        PRINTF("ROLL TM: ICMPv6 In, Check seq %u @ %p\n", val, seq_ptr);
-        if(SEQ_VAL_IS_GT(val, locswptr->upper_bound)) {
-          PRINTF("ROLL TM: Inconsistency - Advertised Seq. ID %u GT upper"
-                 " bound %u\n", val, locswptr->upper_bound);
-          loctpptr->inconsistency = 1;
+      if(bitmap) {
+        val = ((uint8_t *)seq_ptr)[0] << 8 | ((uint8_t *)seq_ptr)[1];
+        if(window_bitmap_cmp(locswptr, val,
+                             (uint8_t *)seq_ptr + SEQUENCE_LIST_BASE_LEN,
+                             locslhptr->seq_len)) {
+          PRINTF("ROLL TM: Inconsistency - Advertised bitmap from %u has"
+                 " values missing in [%u, %u] or above\n", val,
+                 locswptr->lower_bound, locswptr->upper_bound);
+          SLIDING_WINDOW_INCONSISTENT(locswptr);
         }
+      } else {
+        for(; seq_ptr < end_ptr; seq_ptr++) {
+          /* Check for "They have new" */
+          /* If an advertised seq. val is GT our upper bound */
+          val = uip_htons(*seq_ptr);
+          PRINTF("ROLL TM: ICMPv6 In, Check seq %u @ %p\n", val, seq_ptr);
+          if(SEQ_VAL_IS_GT(val, locswptr->upper_bound)) {
+            PRINTF("ROLL TM: Inconsistency - Advertised Seq. ID %u GT upper"
+                   " bound %u\n", val, locswptr->upper_bound);
+            SLIDING_WINDOW_INCONSISTENT(locswptr);
+          }
 
-        /* If an advertised seq. val is within our bounds */
-        if((SEQ_VAL_IS_LT(val, locswptr->upper_bound) ||
-            SEQ_VAL_IS_EQ(val, locswptr->upper_bound)) &&
-           (SEQ_VAL_IS_GT(val, locswptr->lower_bound) ||
-            SEQ_VAL_IS_EQ(val, locswptr->lower_bound))) {
-
-          inconsistency = 1;
-          /* Check if the advertised sequence is in our buffer */
-          for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-              locmpptr >= buffered_msgs; locmpptr--) {
-            if(MCAST_PACKET_IS_USED(locmpptr) && locmpptr->sw == locswptr) {
-              if(SEQ_VAL_IS_EQ(locmpptr->seq_val, val)) {
-
-                inconsistency = 0;
-                MCAST_PACKET_LISTED_SET(locmpptr);
-                PRINTF("ROLL TM: ICMPv6 In, %u listed\n", locmpptr->seq_val);
-
-                /* Update lowest seq. num listed for this window
-                 * We need this to check for "we have new" */
-                if(locswptr->min_listed == -1 ||
-                   SEQ_VAL_IS_LT(val, locswptr->min_listed)) {
-                  locswptr->min_listed = val;
-                }
-                break;
+          /* If an advertised seq. val is within our bounds */
+          if((SEQ_VAL_IS_LT(val, locswptr->upper_bound) ||
+              SEQ_VAL_IS_EQ(val, locswptr->upper_bound)) &&
+             (SEQ_VAL_IS_GT(val, locswptr->lower_bound) ||
+              SEQ_VAL_IS_EQ(val, locswptr->lower_bound))) {
+
+            inconsistency = 1;
+            /* Check if the advertised sequence is in our buffer */
+            locmpptr = window_find(locswptr, val);
+            if(locmpptr != NULL) {
+              inconsistency = 0;
+              MCAST_PACKET_LISTED_SET(locmpptr);
+              PRINTF("ROLL TM: ICMPv6 In, %u listed\n", locmpptr->seq_val);
+
+              /* Update lowest seq. num listed for this window
+               * We need this to check for "we have new" */
+              if(locswptr->min_listed == -1 ||
+                 SEQ_VAL_IS_LT(val, locswptr->min_listed)) {
+                locswptr->min_listed = val;
               }
             }
-          }
-          if(inconsistency) {
-            PRINTF("ROLL TM: Inconsistency - ");
-            PRINTF("Advertised Seq. ID %u within bounds", val);
-            PRINTF(" [%u, %u] but no matching entry\n",
-                   locswptr->lower_bound, locswptr->upper_bound);
-            loctpptr->inconsistency = 1;
+            if(inconsistency) {
+              PRINTF("ROLL TM: Inconsistency - ");
+              PRINTF("Advertised Seq. ID %u within bounds", val);
+              PRINTF(" [%u, %u] but no matching entry\n",
+                     locswptr->lower_bound, locswptr->upper_bound);
+              SLIDING_WINDOW_INCONSISTENT(locswptr);
+            }
           }
         }
       }
@@ -1254,35 +2016,38 @@ icmp_input()
       /* A new sliding window in an ICMP message is not explicitly stated
        * in the draft as inconsistency. Until this is clarified, we consider
        * this to be a point where we diverge from the draft for performance
-       * improvement reasons (or as some would say, 'this is an extension') */
+       * improvement reasons (or as some would say, 'this is an extension').
+       * With per-window trickle there is no window to reset, we will hear
+       * the seed's next message */
+#if !ROLL_TM_SEED_TRICKLE
       PRINTF("ROLL TM: Inconsistency - Advertised window unknown to us\n");
       loctpptr->inconsistency = 1;
+#endif
     }
-    locslhptr = (struct sequence_list_header *)(((uint8_t *)locslhptr) +
-        sizeof(struct sequence_list_header) + (2 * locslhptr->seq_len));
+    locslhptr = (struct sequence_list_header *)end_ptr;
   }
   /* Done parsing the message */
 
   /* Check for "We have new */
   PRINTF("ROLL TM: ICMPv6 In, Check our buffer\n");
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    if(MCAST_PACKET_IS_USED(locmpptr)) {
-      locswptr = locmpptr->sw;
+  for(locswptr = list_head(windows_list); locswptr != NULL;
+      locswptr = list_item_next(locswptr)) {
+    for(locmpptr = locswptr->head; locmpptr != NULL;
+        locmpptr = locmpptr->next) {
       PRINTF("ROLL TM: ICMPv6 In, ");
       PRINTF("Check %u, Seed L: %u, This L: %u Min L: %d\n",
              locmpptr->seq_val, SLIDING_WINDOW_IS_LISTED(locswptr),
              MCAST_PACKET_IS_LISTED(locmpptr), locswptr->min_listed);
 
-      /* Point to the sliding window's trickle param */
-      loctpptr = &t[SLIDING_WINDOW_GET_M(locswptr)];
       if(!SLIDING_WINDOW_IS_LISTED(locswptr)) {
+#if !ROLL_TM_SEED_TRICKLE
         /* If a buffered packet's Seed ID was not listed */
         PRINTF("ROLL TM: Inconsistency - Seed ID ");
         PRINT_SEED(&locswptr->seed_id);
         PRINTF(" was not listed\n");
-        loctpptr->inconsistency = 1;
+        SLIDING_WINDOW_INCONSISTENT(locswptr);
         MCAST_PACKET_SEND_SET(locmpptr);
+#endif
       } else {
         /* This packet was not listed but a prior one was */
         if(!MCAST_PACKET_IS_LISTED(locmpptr) &&
@@ -1291,7 +2056,7 @@ icmp_input()
           PRINTF("ROLL TM: Inconsistency - ");
           PRINTF("Seq. %u was not listed but %u was\n",
                  locmpptr->seq_val, locswptr->min_listed);
-          loctpptr->inconsistency = 1;
+          SLIDING_WINDOW_INCONSISTENT(locswptr);
           MCAST_PACKET_SEND_SET(locmpptr);
         }
       }
@@ -1300,16 +2065,29 @@ icmp_input()
 
 drop:
 
+#if ROLL_TM_SEED_TRICKLE
+  /* Only windows listed in this message heard about anything */
+  for(locswptr = list_head(windows_list); locswptr != NULL;
+      locswptr = list_item_next(locswptr)) {
+    if(locswptr->tr.inconsistency) {
+      seed_trickle_reset(locswptr);
+    } else if(SLIDING_WINDOW_IS_LISTED(locswptr)) {
+      locswptr->tr.c++;
+    }
+  }
+  seed_trickle_schedule();
+#else
   if(t[0].inconsistency) {
-    reset_trickle_timer(0);
+    uip_mcast6_trickle_reset(&t[0].tr);
   } else {
-    t[0].c++;
+    t[0].tr.c++;
   }
   if(t[1].inconsistency) {
-    reset_trickle_timer(1);
+    uip_mcast6_trickle_reset(&t[1].tr);
   } else {
-    t[1].c++;
+    t[1].tr.c++;
   }
+#endif
 
 discard:
 
@@ -1317,21 +2095,49 @@ discard:
   return;
 }
 /*---------------------------------------------------------------------------*/
+void
+roll_tm_hbho_reserve(uint8_t next)
+{
+  memset(UIP_EXT_BUF, 0, HBHO_TOTAL_LEN);
+  UIP_EXT_BUF->next = next;
+  UIP_EXT_OPT_PADN->opt_type = UIP_EXT_HDR_OPT_PADN;
+  UIP_EXT_OPT_PADN->opt_len = HBHO_TOTAL_LEN - 4;
+
+  UIP_IP_BUF->proto = UIP_PROTO_HBHO;
+  uip_ext_len = HBHO_TOTAL_LEN;
+  uip_len = UIP_IPH_LEN + HBHO_TOTAL_LEN;
+}
+/*---------------------------------------------------------------------------*/
 static void
 out()
 {
+  /*
+   * If the send path left headroom for us, there is a padding-only HBH
+   * header of our size right after the IPv6 header and we can write our
+   * option over it. Otherwise, make room
+   */
+  if(UIP_IP_BUF->proto == UIP_PROTO_HBHO && uip_ext_len == HBHO_TOTAL_LEN &&
+     UIP_EXT_BUF->len == 0 &&
+     UIP_EXT_OPT_PADN->opt_type == UIP_EXT_HDR_OPT_PADN &&
+     UIP_EXT_OPT_PADN->opt_len == HBHO_TOTAL_LEN - 4) {
+    PRINTF("ROLL TM: Multicast Out, HBHO in place\n");
+  } else {
+    if(uip_len + HBHO_TOTAL_LEN > UIP_BUFSIZE) {
+      PRINTF("ROLL TM: Multicast Out can not add HBHO. Packet too long\n");
+      goto drop;
+    }
 
-  if(uip_len + HBHO_TOTAL_LEN > UIP_BUFSIZE) {
-    PRINTF("ROLL TM: Multicast Out can not add HBHO. Packet too long\n");
-    goto drop;
-  }
+    /* Slide 'right' by HBHO_TOTAL_LEN bytes */
+    memmove(UIP_EXT_BUF_NEXT, UIP_EXT_BUF, uip_len - UIP_IPH_LEN);
+    UIP_EXT_BUF->next = UIP_IP_BUF->proto;
 
-  /* Slide 'right' by HBHO_TOTAL_LEN bytes */
-  memmove(UIP_EXT_BUF_NEXT, UIP_EXT_BUF, uip_len - UIP_IPH_LEN);
-  memset(UIP_EXT_BUF, 0, HBHO_TOTAL_LEN);
+    uip_ext_len += HBHO_TOTAL_LEN;
+    uip_len += HBHO_TOTAL_LEN;
+    ROLL_TM_STATS_ADD(out_moved);
+  }
 
-  UIP_EXT_BUF->next = UIP_IP_BUF->proto;
   UIP_EXT_BUF->len = 0;
+  memset(UIP_EXT_OPT_FIRST, 0, HBHO_TOTAL_LEN - 2);
 
   lochbhmptr = UIP_EXT_OPT_FIRST;
   lochbhmptr->type = HBHO_OPT_TYPE_TRICKLE;
@@ -1355,9 +2161,6 @@ out()
   HBH_SET_M(lochbhmptr);
 #endif
 
-  uip_ext_len += HBHO_TOTAL_LEN;
-  uip_len += HBHO_TOTAL_LEN;
-
   /* Update the proto and length field in the v6 header */
   UIP_IP_BUF->proto = UIP_PROTO_HBHO;
   UIP_IP_BUF->len[0] = ((uip_len - UIP_IPH_LEN) >> 8);
@@ -1375,6 +2178,9 @@ out()
    * Queue this message but don't set its MUST_SEND flag. We reset the trickle
    * timer and we send it immediately. We then set uip_len = 0 to stop the core
    * from re-sending it.
+   *
+   * accept() caches uip_buf as it is, so what goes out is byte for byte what
+   * we will retransmit and advertise later on
    */
   if(accept(ROLL_TM_DGRAM_OUT)) {
     tcpip_output(NULL);
@@ -1382,8 +2188,10 @@ out()
   }
 
 drop:
+  /* Nothing reads uip_buf past uip_len, no need to wipe it */
   uip_slen = 0;
-  uip_clear_buf();
+  uip_len = 0;
+  uip_ext_len = 0;
 }
 /*---------------------------------------------------------------------------*/
 static uint8_t
@@ -1413,9 +2221,12 @@ init()
 {
   PRINTF("ROLL TM: ROLL Multicast - Draft #%u\n", ROLL_TM_VER);
 
-  memset(windows, 0, sizeof(windows));
-  memset(buffered_msgs, 0, sizeof(buffered_msgs));
+  memb_init(&windows_memb);
+  list_init(windows_list);
+  memset(window_hash, 0, sizeof(window_hash));
+  memset(tombstones, 0, sizeof(tombstones));
   memset(t, 0, sizeof(t));
+  uip_mcast6_arena_init(&arena, buffer_reclaim, ROLL_TM_STATS_REF(arena_max));
 
   ROLL_TM_STATS_INIT();
   UIP_MCAST6_STATS_INIT(&stats);
@@ -1423,20 +2234,32 @@ init()
   /* Register the ICMPv6 input handler */
   uip_icmp6_register_input_handler(&roll_tm_icmp_handler);
 
-  for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
-      iterswptr--) {
-    iterswptr->lower_bound = -1;
-    iterswptr->upper_bound = -1;
-    iterswptr->min_listed = -1;
-  }
-
   TIMER_CONFIGURE(0);
-  reset_trickle_timer(0);
   TIMER_CONFIGURE(1);
-  reset_trickle_timer(1);
+#if ROLL_TM_SEED_TRICKLE
+  /* Windows start their own trickle as they get allocated */
+  ctimer_stop(&seed_ct);
+#else
+  t[0].tr.periodic = trickle_periodic;
+  t[1].tr.periodic = trickle_periodic;
+  uip_mcast6_trickle_reset(&t[0].tr);
+  uip_mcast6_trickle_reset(&t[1].tr);
+#endif
   return;
 }
 /*---------------------------------------------------------------------------*/
+static const struct uip_mcast6_stats_desc *
+describe_stats(uint8_t *n)
+{
+#if UIP_MCAST6_STATS
+  *n = sizeof(stats_desc) / sizeof(stats_desc[0]);
+  return stats_desc;
+#else
+  *n = 0;
+  return NULL;
+#endif
+}
+/*---------------------------------------------------------------------------*/
 /**
  * \brief The ROLL TM engine driver
  */
@@ -1445,6 +2268,7 @@ const struct uip_mcast6_driver roll_tm_driver = {
   init,
   out,
   in,
+  describe_stats,
 };
 /*---------------------------------------------------------------------------*/
 /** @} */
@@ -71,11 +71,23 @@
 /*---------------------------------------------------------------------------*/
 #define ROLL_TM_VER                    1   /**< Supported Draft Version */
 #define ROLL_TM_ICMP_CODE              0   /**< ROLL TM ICMPv6 code field */
+#define ROLL_TM_ICMP_CODE_BITMAP       1   /**< ICMPv6 code, bitmap lists */
 #define ROLL_TM_IP_HOP_LIMIT        0xFF   /**< Hop limit for ICMP messages */
 #define ROLL_TM_INFINITE_REDUNDANCY 0xFF
 #define ROLL_TM_DGRAM_OUT              0
 #define ROLL_TM_DGRAM_IN               1
 
+/**
+ * Length of the Hop-by-Hop header we add to the datagrams we originate.
+ *
+ * A send path can leave this much headroom after the IPv6 header: An HBH
+ * header carrying nothing but a PadN option, with its next header field set
+ * and counted in uip_ext_len. We then write our option in place instead of
+ * sliding the whole payload to make room for it. roll_tm_hbho_reserve()
+ * builds that header
+ */
+#define ROLL_TM_HBHO_LEN               8
+
 /*
  * The draft does not currently specify a default number for the trickle
  * interval nor a way to derive it. Examples however hint at 100 msec.
@@ -168,23 +180,76 @@
  * want to support for our lowpan
  * If a node is seeding two multicast streams, parametrized on different M
  * values, then this seed will occupy two different sliding windows
+ *
+ * Windows are drawn from a pool of this size as seeds show up and go back
+ * to it when their last message expires. Only windows in use are ever
+ * walked, so a large pool costs RAM but no CPU. When the pool runs dry, a
+ * new seed takes over an idle window: One none of whose messages are still
+ * within Tactive
  */
 #ifdef ROLL_TM_CONF_WINS
 #define ROLL_TM_WINS ROLL_TM_CONF_WINS
 #else
 #define ROLL_TM_WINS 2
 #endif
+
+/**
+ * Number of tombstones for windows taken over while their messages were
+ * still within Tdwell. A tombstone keeps the seed's upper bound until Tdwell
+ * is over, so that we keep dropping retransmissions of those messages
+ *
+ * Each costs about the size of a Seed ID. With none free, an idle window
+ * can't be taken over until its messages are past Tdwell
+ */
+#ifdef ROLL_TM_CONF_TOMBSTONES
+#define ROLL_TM_TOMBSTONES ROLL_TM_CONF_TOMBSTONES
+#else
+#define ROLL_TM_TOMBSTONES ROLL_TM_WINS
+#endif
+
+/**
+ * Number of buckets in the Seed ID to window index. Must be a power of 2
+ */
+#ifdef ROLL_TM_CONF_WIN_HASH_SIZE
+#define ROLL_TM_WIN_HASH_SIZE ROLL_TM_CONF_WIN_HASH_SIZE
+#else
+#define ROLL_TM_WIN_HASH_SIZE 4
+#endif
 /*---------------------------------------------------------------------------*/
 /**
  * Maximum Number of Buffered Multicast Messages
  * This buffer is shared across all Seed IDs, therefore a new very active Seed
  * may eventually occupy all slots. It would make little sense (if any) to
  * define support for fewer buffered messages than seeds*2
+ *
+ * Each message only costs a small descriptor here. The datagrams themselves
+ * live in the packet arena below, so the default allows for more messages
+ * than the arena holds at full size
  */
 #ifdef ROLL_TM_CONF_BUFF_NUM
 #define ROLL_TM_BUFF_NUM ROLL_TM_CONF_BUFF_NUM
 #else
-#define ROLL_TM_BUFF_NUM 6
+#define ROLL_TM_BUFF_NUM 12
+#endif
+/*---------------------------------------------------------------------------*/
+/**
+ * Size of the packet arena in bytes
+ * Buffered datagrams are stored back to back in the arena, each taking its
+ * own length rounded up to 4 bytes. When a new datagram doesn't fit, older
+ * ones are reclaimed to make room.
+ *
+ * The default is the byte budget of the old fixed buffers: six full-size
+ * datagrams. Up to ROLL_TM_BUFF_NUM datagrams fit when they are short, which
+ * is the usual case. Full-size ones still only fit six at a time, and older
+ * messages get reclaimed early to make room for a seventh. Networks which
+ * carry mostly large datagrams should raise this or lower
+ * ROLL_TM_CONF_BUFF_NUM, which saves the descriptors. Use the arena_max stat
+ * to size it
+ */
+#ifdef ROLL_TM_CONF_ARENA_SIZE
+#define ROLL_TM_ARENA_SIZE ROLL_TM_CONF_ARENA_SIZE
+#else
+#define ROLL_TM_ARENA_SIZE (6 * (UIP_BUFSIZE - UIP_LLH_LEN))
 #endif
 /*---------------------------------------------------------------------------*/
 /**
@@ -222,6 +287,68 @@
 #define ROLL_TM_SET_M_BIT 1
 #endif
 /*---------------------------------------------------------------------------*/
+/**
+ * \name Buffer reclaim policies
+ *
+ * Which buffered message to evict when a new one doesn't fit. The messages
+ * of the same window below it are evicted with it, so that we don't take
+ * their retransmissions for new ones.
+ *
+ * With ROLL_TM_RECLAIM_LARGEST, a window's last message is never evicted and
+ * new messages are dropped when each window holds a single one. The other
+ * policies may empty a window, which frees it for a new seed. The reclaim_*
+ * stats count evictions by the rule that made them
+ * @{
+ */
+#define ROLL_TM_RECLAIM_LARGEST    0 /**< Lowest seq. of the largest window */
+#define ROLL_TM_RECLAIM_OLDEST     1 /**< Closest to the end of Tdwell */
+#define ROLL_TM_RECLAIM_ADVERTISED 2 /**< Least recently in our ICMP */
+#define ROLL_TM_RECLAIM_SPENT      3 /**< Won't be sent again, else LARGEST */
+/** @} */
+
+#ifdef ROLL_TM_CONF_RECLAIM_POLICY
+#define ROLL_TM_RECLAIM_POLICY ROLL_TM_CONF_RECLAIM_POLICY
+#else
+#define ROLL_TM_RECLAIM_POLICY ROLL_TM_RECLAIM_LARGEST
+#endif
+/*---------------------------------------------------------------------------*/
+/**
+ * Sequence list encoding for our outgoing ICMP messages
+ *
+ * When set, we advertise each window as a base sequence value followed by a
+ * bitmap of the values we hold, under ICMP code ROLL_TM_ICMP_CODE_BITMAP.
+ * This is only done if it results in a shorter message than the 2-byte
+ * per value lists of ROLL_TM_ICMP_CODE. Incoming messages are understood
+ * in either encoding regardless of this setting. Leave this at 0 if some
+ * nodes in the network run an older version of this engine
+ */
+#ifdef ROLL_TM_CONF_ICMP_BITMAP
+#define ROLL_TM_ICMP_BITMAP ROLL_TM_CONF_ICMP_BITMAP
+#else
+#define ROLL_TM_ICMP_BITMAP 0
+#endif
+/*---------------------------------------------------------------------------*/
+/**
+ * Trickle state per sliding window
+ *
+ * By default we run two Trickle timers, one per M value, and an inconsistency
+ * on any window resets the timer shared by all windows with the same M. When
+ * set, each window runs its own Trickle instance on the parameters of its M
+ * value, all of them multiplexed onto a single ctimer. A window's periodic
+ * only transmits and advertises that window's messages, so one busy seed no
+ * longer drags all others back to Imin.
+ *
+ * Each ICMP message then only lists a single seed, so a window missing from
+ * a neighbour's message is no longer treated as an inconsistency. Messages
+ * from a seed a neighbour has never heard of reach it through their first
+ * transmission only
+ */
+#ifdef ROLL_TM_CONF_SEED_TRICKLE
+#define ROLL_TM_SEED_TRICKLE ROLL_TM_CONF_SEED_TRICKLE
+#else
+#define ROLL_TM_SEED_TRICKLE 0
+#endif
+/*---------------------------------------------------------------------------*/
 /* Stats datatype */
 /*---------------------------------------------------------------------------*/
 /**
@@ -236,8 +363,44 @@ struct roll_tm_stats {
 
   /** Number of malformed ICMP datagrams seen by us */
   UIP_MCAST6_STATS_DATATYPE icmp_bad;
+
+  /** Largest number of packet arena bytes in use at the same time */
+  UIP_MCAST6_STATS_DATATYPE arena_max;
+
+  /** Messages evicted as the lowest of the largest window */
+  UIP_MCAST6_STATS_DATATYPE reclaim_largest;
+
+  /** Messages evicted as the closest to the end of Tdwell */
+  UIP_MCAST6_STATS_DATATYPE reclaim_oldest;
+
+  /** Messages evicted as the least recently advertised */
+  UIP_MCAST6_STATS_DATATYPE reclaim_advertised;
+
+  /** Messages evicted because they won't be transmitted again */
+  UIP_MCAST6_STATS_DATATYPE reclaim_spent;
+
+  /** Number of times we needed space but found nothing to evict */
+  UIP_MCAST6_STATS_DATATYPE reclaim_failed;
+
+  /** Number of idle windows handed over to a new seed */
+  UIP_MCAST6_STATS_DATATYPE win_reaped;
+
+  /** Originated datagrams without headroom, moved to fit our HBH header */
+  UIP_MCAST6_STATS_DATATYPE out_moved;
 };
 /*---------------------------------------------------------------------------*/
+/**
+ * \brief Leave room for our HBH option in a datagram built in uip_buf
+ * \param next The header that will follow, e.g. UIP_PROTO_UDP
+ *
+ * For senders that build the whole datagram themselves before handing it
+ * over to UIP_MCAST6.out(), as the TM example's root does. Call it with the
+ * IPv6 header in place, then write the upper layer header at UIP_LLH_LEN +
+ * UIP_IPH_LEN + uip_ext_len. uip_len and uip_ext_len cover the headroom on
+ * return. The payload length in the IPv6 header is left to the caller
+ */
+void roll_tm_hbho_reserve(uint8_t next);
+/*---------------------------------------------------------------------------*/
 #endif /* ROLL_TM_H_ */
 /*---------------------------------------------------------------------------*/
 /** @} */
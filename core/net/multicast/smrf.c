@@ -45,6 +45,10 @@
 #include "contiki-net.h"
 #include "net/ipv6/multicast/uip-mcast6.h"
 #include "net/ipv6/multicast/uip-mcast6-route.h"
+#include "net/ipv6/multicast/uip-mcast6-dup.h"
+#include "net/ipv6/multicast/uip-mcast6-adapt.h"
+#include "net/ipv6/multicast/uip-mcast6-fwd.h"
+#include "net/ipv6/multicast/uip-mcast6-parent.h"
 #include "net/ipv6/multicast/uip-mcast6-stats.h"
 #include "net/ipv6/multicast/smrf.h"
 #include "net/rpl/rpl.h"
@@ -62,64 +66,84 @@
 /* Number of slots in the next 500ms */
 #define SMRF_INTERVAL_COUNT  ((CLOCK_SECOND >> 2) / fwd_delay)
 /*---------------------------------------------------------------------------*/
+/* Maintain Stats */
+#if UIP_MCAST6_STATS
+static struct smrf_stats stats;
+
+static const struct uip_mcast6_stats_desc stats_desc[] = {
+  UIP_MCAST6_STATS_DESC(smrf_stats, fwd_queue_full, 0),
+  UIP_MCAST6_STATS_DESC(smrf_stats, fwd_queue_max, UIP_MCAST6_STATS_T_MAX),
+  UIP_MCAST6_STATS_DESC(smrf_stats, parent_refresh, 0),
+  UIP_MCAST6_STATS_DESC(smrf_stats, adapt_backoff, 0),
+};
+
+#define SMRF_STATS_ADD(x) stats.x++
+#define SMRF_STATS_MAX(x, v) do { \
+  if((v) > stats.x) { \
+    stats.x = (v); \
+  } \
+} while(0)
+#define SMRF_STATS_INIT() do { memset(&stats, 0, sizeof(stats)); } while(0)
+#define SMRF_STATS_REF(x) (&stats.x)
+#else /* UIP_MCAST6_STATS */
+#define SMRF_STATS_ADD(x)
+#define SMRF_STATS_MAX(x, v)
+#define SMRF_STATS_INIT()
+#define SMRF_STATS_REF(x) NULL
+#endif
+/*---------------------------------------------------------------------------*/
 /* Internal Data */
 /*---------------------------------------------------------------------------*/
-static struct ctimer mcast_periodic;
-static uint8_t mcast_len;
-static uip_buf_t mcast_buf;
+UIP_MCAST6_FWD(fwd_queue, SMRF_FWD_QUEUE);
 static uint8_t fwd_delay;
 static uint8_t fwd_spread;
+
+/* Our preferred parent in each RPL instance */
+static struct uip_mcast6_parents parents;
+/*---------------------------------------------------------------------------*/
+/* Forwarding delay floor and spread bound: Fixed or tuned at runtime */
+#if SMRF_ADAPTIVE
+static struct uip_mcast6_adapt adapt;
+
+#define SMRF_FWD_MIN()         uip_mcast6_adapt_min_delay(&adapt)
+#define SMRF_FWD_MAX_SPREAD()  uip_mcast6_adapt_spread(&adapt)
+#define SMRF_ADAPT_UPDATE(bad) do { \
+  if(uip_mcast6_adapt_update(&adapt, (bad))) { \
+    SMRF_STATS_ADD(adapt_backoff); \
+  } \
+} while(0)
+#else
+#define SMRF_FWD_MIN()         SMRF_MIN_FWD_DELAY
+#define SMRF_FWD_MAX_SPREAD()  SMRF_MAX_SPREAD
+#define SMRF_ADAPT_UPDATE(bad) do { (void)(bad); } while(0)
+#endif
 /*---------------------------------------------------------------------------*/
 /* uIPv6 Pointers */
 /*---------------------------------------------------------------------------*/
 #define UIP_IP_BUF        ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
 /*---------------------------------------------------------------------------*/
-static void
-mcast_fwd(void *p)
+void
+smrf_parent_switch(struct rpl_parent *old, struct rpl_parent *new)
 {
-  memcpy(uip_buf, &mcast_buf, mcast_len);
-  uip_len = mcast_len;
-  UIP_IP_BUF->ttl--;
-  tcpip_output(NULL);
-  uip_clear_buf();
+  PRINTF("SMRF: Parent switch\n");
+  /* Rare enough not to bother working out which instance it was */
+  uip_mcast6_parent_flush(&parents);
 }
 /*---------------------------------------------------------------------------*/
 static uint8_t
 in()
 {
-  rpl_dag_t *d;                 /* Our DODAG */
-  uip_ipaddr_t *parent_ipaddr;  /* Our pref. parent's IPv6 address */
-  const uip_lladdr_t *parent_lladdr;  /* Our pref. parent's LL address */
-
-  /*
-   * Fetch a pointer to the LL address of our preferred parent
-   *
-   * ToDo: This rpl_get_any_dag() call is a dirty replacement of the previous
-   *   rpl_get_dag(RPL_DEFAULT_INSTANCE);
-   * so that things can compile with the new RPL code. This needs updated to
-   * read instance ID from the RPL HBHO and use the correct parent accordingly
-   */
-  d = rpl_get_any_dag();
-  if(!d) {
-    UIP_MCAST6_STATS_ADD(mcast_dropped);
-    return UIP_MCAST6_DROP;
-  }
-
-  /* Retrieve our preferred parent's LL address */
-  parent_ipaddr = rpl_get_parent_ipaddr(d->preferred_parent);
-  parent_lladdr = uip_ds6_nbr_lladdr_from_ipaddr(parent_ipaddr);
-
-  if(parent_lladdr == NULL) {
-    UIP_MCAST6_STATS_ADD(mcast_dropped);
-    return UIP_MCAST6_DROP;
-  }
+  struct uip_mcast6_fwd_slot *slot;
+  struct uip_mcast6_parent *pc; /* Our pref. parent, datagram's instance */
+  uip_mcast6_route_t *rt;       /* Route for the datagram's group, if any */
+  uint8_t bad;                  /* Feedback for the adaptive forwarding delay */
 
   /*
    * We accept a datagram if it arrived from our preferred parent, discard
    * otherwise.
    */
-  if(memcmp(parent_lladdr, packetbuf_addr(PACKETBUF_ADDR_SENDER),
-            UIP_LLADDR_LEN)) {
+  pc = uip_mcast6_parent_in(&parents);
+  if(pc == NULL) {
     PRINTF("SMRF: Routable in but SMRF ignored it\n");
     UIP_MCAST6_STATS_ADD(mcast_dropped);
     return UIP_MCAST6_DROP;
@@ -131,14 +155,26 @@ in()
   }
 
   UIP_MCAST6_STATS_ADD(mcast_in_all);
+
+  /* MAC-layer retransmissions, or a parent switch mid-flood */
+  if(uip_mcast6_dup_check()) {
+    PRINTF("SMRF: Duplicate, dropped\n");
+    UIP_MCAST6_STATS_ADD(mcast_dropped);
+    UIP_MCAST6_ROUTE_STATS_ADD(
+      uip_mcast6_route_lookup(&UIP_IP_BUF->destipaddr), dropped);
+    SMRF_ADAPT_UPDATE(1);
+    return UIP_MCAST6_DROP;
+  }
+
   UIP_MCAST6_STATS_ADD(mcast_in_unique);
+  bad = 0;
 
   /* If we have an entry in the mcast routing table, something with
    * a higher RPL rank (somewhere down the tree) is a group member */
-  if(uip_mcast6_route_lookup(&UIP_IP_BUF->destipaddr)) {
-    /* If we enter here, we will definitely forward */
-    UIP_MCAST6_STATS_ADD(mcast_fwd);
-
+  rt = uip_mcast6_route_lookup(&UIP_IP_BUF->destipaddr);
+  UIP_MCAST6_ROUTE_STATS_ADD(rt, in);
+  UIP_MCAST6_ROUTE_STATS_ADD_N(rt, bytes, uip_len);
+  if(rt) {
     /*
      * Add a delay (D) of at least SMRF_FWD_DELAY() to compensate for how
      * contikimac handles broadcasts. We can't start our TX before the sender
@@ -146,35 +182,52 @@ in()
      */
     fwd_delay = SMRF_FWD_DELAY();
 
-    /* Finalise D: D = min(SMRF_FWD_DELAY(), SMRF_MIN_FWD_DELAY) */
-#if SMRF_MIN_FWD_DELAY
-    if(fwd_delay < SMRF_MIN_FWD_DELAY) {
-      fwd_delay = SMRF_MIN_FWD_DELAY;
+    /* Finalise D: D = min(SMRF_FWD_DELAY(), SMRF_FWD_MIN()) */
+#if SMRF_ADAPTIVE || SMRF_MIN_FWD_DELAY
+    if(fwd_delay < SMRF_FWD_MIN()) {
+      fwd_delay = SMRF_FWD_MIN();
     }
 #endif
 
     if(fwd_delay == 0) {
       /* No delay required, send it, do it now, why wait? */
+      UIP_MCAST6_STATS_ADD(mcast_fwd);
+      UIP_MCAST6_ROUTE_STATS_ADD(rt, fwd);
+      UIP_MCAST6_STATS_LATENCY_ADD(UIP_MCAST6_LATENCY_FWD, 0);
       UIP_IP_BUF->ttl--;
       tcpip_output(NULL);
       UIP_IP_BUF->ttl++;        /* Restore before potential upstack delivery */
     } else {
       /* Randomise final delay in [D , D*Spread], step D */
       fwd_spread = SMRF_INTERVAL_COUNT;
-      if(fwd_spread > SMRF_MAX_SPREAD) {
-        fwd_spread = SMRF_MAX_SPREAD;
+      if(fwd_spread > SMRF_FWD_MAX_SPREAD()) {
+        fwd_spread = SMRF_FWD_MAX_SPREAD();
       }
       if(fwd_spread) {
         fwd_delay = fwd_delay * (1 + ((random_rand() >> 11) % fwd_spread));
       }
 
-      memcpy(&mcast_buf, uip_buf, uip_len);
-      mcast_len = uip_len;
-      ctimer_set(&mcast_periodic, fwd_delay, mcast_fwd, NULL);
+      /* Queue it. Datagrams already waiting keep their own deadline */
+      slot = uip_mcast6_fwd_alloc(&fwd_queue);
+      if(slot == NULL) {
+        PRINTF("SMRF: Forwarding queue full\n");
+        SMRF_STATS_ADD(fwd_queue_full);
+        UIP_MCAST6_STATS_ADD(mcast_dropped);
+        UIP_MCAST6_ROUTE_STATS_ADD(rt, dropped);
+        bad = 1;
+      } else {
+        UIP_MCAST6_STATS_ADD(mcast_fwd);
+        UIP_MCAST6_ROUTE_STATS_ADD(rt, fwd);
+        memcpy(&slot->buf, uip_buf, uip_len);
+        slot->len = uip_len;
+        uip_mcast6_fwd_schedule(&fwd_queue, slot, fwd_delay);
+        SMRF_STATS_MAX(fwd_queue_max, uip_mcast6_fwd_used(&fwd_queue));
+      }
     }
     PRINTF("SMRF: %u bytes: fwd in %u [%u]\n",
            uip_len, fwd_delay, fwd_spread);
   }
+  SMRF_ADAPT_UPDATE(bad);
 
   /* Done with this packet unless we are a member of the mcast group */
   if(!uip_ds6_is_my_maddr(&UIP_IP_BUF->destipaddr)) {
@@ -190,9 +243,17 @@ in()
 static void
 init()
 {
-  UIP_MCAST6_STATS_INIT(NULL);
+  SMRF_STATS_INIT();
+  UIP_MCAST6_STATS_INIT(&stats);
+
+  uip_mcast6_fwd_init(&fwd_queue, uip_mcast6_fwd_relay);
 
   uip_mcast6_route_init();
+  uip_mcast6_dup_init();
+#if SMRF_ADAPTIVE
+  uip_mcast6_adapt_init(&adapt, SMRF_MIN_FWD_DELAY, SMRF_MAX_SPREAD);
+#endif
+  uip_mcast6_parent_init(&parents, SMRF_STATS_REF(parent_refresh));
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -201,6 +262,18 @@ out()
   return;
 }
 /*---------------------------------------------------------------------------*/
+static const struct uip_mcast6_stats_desc *
+describe_stats(uint8_t *n)
+{
+#if UIP_MCAST6_STATS
+  *n = sizeof(stats_desc) / sizeof(stats_desc[0]);
+  return stats_desc;
+#else
+  *n = 0;
+  return NULL;
+#endif
+}
+/*---------------------------------------------------------------------------*/
 /**
  * \brief The SMRF engine driver
  */
@@ -209,6 +282,7 @@ const struct uip_mcast6_driver smrf_driver = {
   init,
   out,
   in,
+  describe_stats,
 };
 /*---------------------------------------------------------------------------*/
 /** @} */
@@ -51,6 +51,7 @@
 #define SMRF_H_
 
 #include "contiki-conf.h"
+#include "net/ipv6/multicast/uip-mcast6-stats.h"
 
 #include <stdint.h>
 /*---------------------------------------------------------------------------*/
@@ -69,19 +70,60 @@
 #else
 #define SMRF_MAX_SPREAD 4
 #endif
+
+/*
+ * Number of datagrams which can be waiting for their forwarding delay to
+ * expire at the same time. Each slot costs a uip_buf_t worth of RAM. When all
+ * slots are busy, new datagrams are delivered locally but not forwarded
+ */
+#ifdef SMRF_CONF_FWD_QUEUE
+#define SMRF_FWD_QUEUE SMRF_CONF_FWD_QUEUE
+#else
+#define SMRF_FWD_QUEUE 1
+#endif
+
+/*
+ * Tune the forwarding delay at runtime. SMRF_MIN_FWD_DELAY and
+ * SMRF_MAX_SPREAD become the starting floor and the upper bound for the
+ * spread. See uip-mcast6-adapt.h
+ */
+#ifdef SMRF_CONF_ADAPTIVE
+#define SMRF_ADAPTIVE SMRF_CONF_ADAPTIVE
+#else
+#define SMRF_ADAPTIVE 0
+#endif
 /*---------------------------------------------------------------------------*/
 /* Stats datatype */
 /*---------------------------------------------------------------------------*/
+/**
+ * \brief Multicast stats extension for the SMRF engine
+ */
 struct smrf_stats {
-  uint16_t mcast_in_unique;
-  uint16_t mcast_in_all;        /* At layer 3 */
-  uint16_t mcast_in_ours;       /* Unique and we are a group member */
-  uint16_t mcast_fwd;           /* Forwarded by us but we are not the seed */
-  uint16_t mcast_out;           /* We are the seed */
-  uint16_t mcast_bad;
-  uint16_t mcast_dropped;
+  /** Number of datagrams not forwarded because all queue slots were busy */
+  UIP_MCAST6_STATS_DATATYPE fwd_queue_full;
+
+  /** Largest number of queue slots in use at the same time */
+  UIP_MCAST6_STATS_DATATYPE fwd_queue_max;
+
+  /** Number of times we looked up our preferred parent's LL address */
+  UIP_MCAST6_STATS_DATATYPE parent_refresh;
+
+  /** Number of times the adaptive forwarding delay floor went up */
+  UIP_MCAST6_STATS_DATATYPE adapt_backoff;
 };
 /*---------------------------------------------------------------------------*/
+struct rpl_parent;
+
+/**
+ * \brief Notify SMRF that RPL switched preferred parents
+ *
+ *        Hooked into RPL as RPL_CALLBACK_PARENT_SWITCH by uip-mcast6.h. If
+ *        your project already uses that callback, call this from it.
+ *        Otherwise SMRF only notices the switch when a datagram arrives
+ *        from a neighbour other than the parent it knows of
+ */
+void smrf_parent_switch(struct rpl_parent *old, struct rpl_parent *new);
+/*---------------------------------------------------------------------------*/
 #endif /* SMRF_H_ */
 /*---------------------------------------------------------------------------*/
 /** @} */
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2026, The Contiki Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * \addtogroup uip6-multicast
+ * @{
+ */
+/**
+ * \file
+ *    Adaptive forwarding delay controller
+ *
+ * \author
+ *    The Contiki Project
+ */
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/multicast/uip-mcast6-adapt.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/*---------------------------------------------------------------------------*/
+void
+uip_mcast6_adapt_init(struct uip_mcast6_adapt *a, uint8_t min_delay,
+                      uint8_t max_spread)
+{
+  memset(a, 0, sizeof(struct uip_mcast6_adapt));
+  a->min_delay = min_delay;
+  a->max_spread = max_spread;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+uip_mcast6_adapt_update(struct uip_mcast6_adapt *a, uint8_t bad)
+{
+  uint8_t rv;
+
+  a->seen++;
+  if(bad) {
+    a->bad++;
+  }
+
+  if(a->seen < UIP_MCAST6_ADAPT_WINDOW) {
+    return 0;
+  }
+
+  rv = 0;
+  if((uint32_t)a->bad * 100 > (uint32_t)a->seen * UIP_MCAST6_ADAPT_TARGET) {
+    /* Back off fast, unless we're already as slow as we go */
+    if(a->min_delay < UIP_MCAST6_ADAPT_MAX_DELAY) {
+      if(a->min_delay == 0) {
+        a->min_delay = 1;
+      } else if(a->min_delay > UIP_MCAST6_ADAPT_MAX_DELAY / 2) {
+        a->min_delay = UIP_MCAST6_ADAPT_MAX_DELAY;
+      } else {
+        a->min_delay <<= 1;
+      }
+      rv = 1;
+    }
+  } else if(a->min_delay > 0) {
+    /* Probe for something shorter */
+    a->min_delay--;
+  }
+
+  a->seen = 0;
+  a->bad = 0;
+  return rv;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+uip_mcast6_adapt_spread(struct uip_mcast6_adapt *a)
+{
+  int spread;
+
+  spread = 1 + uip_ds6_nbr_num() / UIP_MCAST6_ADAPT_NBRS_PER_SPREAD;
+  if(spread > a->max_spread) {
+    spread = a->max_spread;
+  }
+  return spread < 1 ? 1 : spread;
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2026, The Contiki Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * \addtogroup uip6-multicast
+ * @{
+ */
+/**
+ * \file
+ *    Header file for the adaptive forwarding delay controller used by SMRF
+ *    and ESMRF
+ *
+ *    The controller tunes two things at runtime: The floor of the forwarding
+ *    delay (what *_MIN_FWD_DELAY sets statically) and the random spread.
+ *
+ *    The floor follows AIMD: Every UIP_MCAST6_ADAPT_WINDOW datagrams, if the
+ *    share of them that were duplicates or got dropped for lack of queue
+ *    space exceeds UIP_MCAST6_ADAPT_TARGET percent, the floor doubles.
+ *    Otherwise it goes down by one clock tick. The spread grows with the
+ *    number of neighbours, which is how many nodes may be trying to forward
+ *    the same datagram at the same time
+ *
+ * \author
+ *    The Contiki Project
+ */
+#ifndef UIP_MCAST6_ADAPT_H_
+#define UIP_MCAST6_ADAPT_H_
+
+#include "contiki.h"
+
+#include <stdint.h>
+/*---------------------------------------------------------------------------*/
+/* Configuration */
+/*---------------------------------------------------------------------------*/
+/** Number of datagrams between adjustments */
+#ifdef UIP_MCAST6_ADAPT_CONF_WINDOW
+#define UIP_MCAST6_ADAPT_WINDOW UIP_MCAST6_ADAPT_CONF_WINDOW
+#else
+#define UIP_MCAST6_ADAPT_WINDOW 16
+#endif
+
+/** Acceptable share of bad datagrams in a window, percent */
+#ifdef UIP_MCAST6_ADAPT_CONF_TARGET
+#define UIP_MCAST6_ADAPT_TARGET UIP_MCAST6_ADAPT_CONF_TARGET
+#else
+#define UIP_MCAST6_ADAPT_TARGET 5
+#endif
+
+/** Largest floor for the forwarding delay, clock ticks (max 255) */
+#ifdef UIP_MCAST6_ADAPT_CONF_MAX_DELAY
+#define UIP_MCAST6_ADAPT_MAX_DELAY UIP_MCAST6_ADAPT_CONF_MAX_DELAY
+#else
+#define UIP_MCAST6_ADAPT_MAX_DELAY 32
+#endif
+
+/** Neighbours per extra step of spread */
+#ifdef UIP_MCAST6_ADAPT_CONF_NBRS_PER_SPREAD
+#define UIP_MCAST6_ADAPT_NBRS_PER_SPREAD UIP_MCAST6_ADAPT_CONF_NBRS_PER_SPREAD
+#else
+#define UIP_MCAST6_ADAPT_NBRS_PER_SPREAD 2
+#endif
+/*---------------------------------------------------------------------------*/
+/** \brief State of one adaptive controller */
+struct uip_mcast6_adapt {
+  uint16_t seen;      /**< Datagrams seen in this window */
+  uint16_t bad;       /**< ...of which duplicates or dropped */
+  uint8_t min_delay;  /**< Current floor of the forwarding delay */
+  uint8_t max_spread; /**< Upper bound for the spread */
+};
+/*---------------------------------------------------------------------------*/
+/** \name Adaptive Forwarding Delay */
+/** @{ */
+
+/**
+ * \brief Initialise a controller
+ * \param a The controller
+ * \param min_delay Initial floor of the forwarding delay, clock ticks
+ * \param max_spread Upper bound for the spread
+ */
+void uip_mcast6_adapt_init(struct uip_mcast6_adapt *a, uint8_t min_delay,
+                           uint8_t max_spread);
+
+/**
+ * \brief Feed the controller with one datagram received from our parent
+ * \param a The controller
+ * \param bad Non-zero if the datagram was a duplicate or had to be dropped
+ * \return 1 if the delay floor went up as a result, 0 otherwise
+ */
+uint8_t uip_mcast6_adapt_update(struct uip_mcast6_adapt *a, uint8_t bad);
+
+/**
+ * \brief Current floor of the forwarding delay, clock ticks
+ */
+#define uip_mcast6_adapt_min_delay(a) ((a)->min_delay)
+
+/**
+ * \brief Spread to use for the next datagram, based on neighbour density
+ * \param a The controller
+ * \return A value in [1, max_spread]
+ */
+uint8_t uip_mcast6_adapt_spread(struct uip_mcast6_adapt *a);
+/** @} */
+
+#endif /* UIP_MCAST6_ADAPT_H_ */
+/** @} */
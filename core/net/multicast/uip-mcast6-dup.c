@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2026, The Contiki Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * \addtogroup uip6-multicast
+ * @{
+ */
+/**
+ * \file
+ *    Cache of recently seen multicast datagrams
+ *
+ * \author
+ *    The Contiki Project
+ */
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+#include "net/ipv6/multicast/uip-mcast6-dup.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/*---------------------------------------------------------------------------*/
+#if UIP_MCAST6_DUP_ENTRIES
+/*---------------------------------------------------------------------------*/
+#define UIP_IP_BUF ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+/*---------------------------------------------------------------------------*/
+struct dup_entry {
+  uip_ipaddr_t src;
+  uip_ipaddr_t group;           /* :: if the entry has never been used */
+  uint16_t tag;
+  uint16_t len;
+  clock_time_t seen;
+};
+
+/* Used as a ring: entries[next] is always the oldest one */
+static struct dup_entry entries[UIP_MCAST6_DUP_ENTRIES];
+static uint8_t next;
+/*---------------------------------------------------------------------------*/
+/*
+ * Work out the tag and length of the datagram in uip_buf. A tag of 0 (no UDP
+ * checksum, no flow label) says nothing about the datagram
+ */
+static void
+dup_tag(uint16_t *tag, uint16_t *len)
+{
+  struct uip_ext_hdr *ext;
+  struct uip_udp_hdr *udp;
+  uint16_t offset;
+  uint8_t proto;
+
+  offset = UIP_LLH_LEN + UIP_IPH_LEN;
+  proto = UIP_IP_BUF->proto;
+
+  /* SMRF and ESMRF datagrams normally carry the RPL option */
+  if(proto == UIP_PROTO_HBHO && offset + 2 <= UIP_BUFSIZE) {
+    ext = (struct uip_ext_hdr *)&uip_buf[offset];
+    proto = ext->next;
+    offset += (ext->len + 1) << 3;
+  }
+
+  if(proto == UIP_PROTO_UDP && offset + UIP_UDPH_LEN <= UIP_BUFSIZE) {
+    udp = (struct uip_udp_hdr *)&uip_buf[offset];
+    *tag = udp->udpchksum;
+    *len = udp->udplen;
+  } else {
+    *tag = UIP_IP_BUF->flow;
+    *len = (UIP_IP_BUF->len[0] << 8) | UIP_IP_BUF->len[1];
+  }
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+uip_mcast6_dup_check(void)
+{
+  struct dup_entry *e;
+  uint16_t tag;
+  uint16_t len;
+  clock_time_t now;
+
+  dup_tag(&tag, &len);
+  if(tag == 0) {
+    /* We'd take every datagram of this length for a duplicate */
+    return 0;
+  }
+  now = clock_time();
+
+  for(e = entries; e < &entries[UIP_MCAST6_DUP_ENTRIES]; e++) {
+    if(e->tag == tag && e->len == len &&
+       (clock_time_t)(now - e->seen) < UIP_MCAST6_DUP_LIFETIME &&
+       uip_ipaddr_cmp(&e->group, &UIP_IP_BUF->destipaddr) &&
+       uip_ipaddr_cmp(&e->src, &UIP_IP_BUF->srcipaddr)) {
+      return 1;
+    }
+  }
+
+  e = &entries[next];
+  uip_ipaddr_copy(&e->src, &UIP_IP_BUF->srcipaddr);
+  uip_ipaddr_copy(&e->group, &UIP_IP_BUF->destipaddr);
+  e->tag = tag;
+  e->len = len;
+  e->seen = now;
+  next = (next + 1) % UIP_MCAST6_DUP_ENTRIES;
+
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_mcast6_dup_init(void)
+{
+  memset(entries, 0, sizeof(entries));
+  next = 0;
+}
+/*---------------------------------------------------------------------------*/
+#else /* UIP_MCAST6_DUP_ENTRIES */
+/*---------------------------------------------------------------------------*/
+uint8_t
+uip_mcast6_dup_check(void)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_mcast6_dup_init(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+#endif /* UIP_MCAST6_DUP_ENTRIES */
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2026, The Contiki Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * \addtogroup uip6-multicast
+ * @{
+ */
+/**
+ * \file
+ *    Header file for the cache of recently seen multicast datagrams, used by
+ *    forwarding engines to suppress duplicates
+ *
+ * \author
+ *    The Contiki Project
+ */
+#ifndef UIP_MCAST6_DUP_H_
+#define UIP_MCAST6_DUP_H_
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+
+#include <stdint.h>
+/*---------------------------------------------------------------------------*/
+/* Configuration */
+/*---------------------------------------------------------------------------*/
+/**
+ * Number of datagrams remembered. Set to 0 to disable duplicate suppression,
+ * in which case uip_mcast6_dup_check() always reports a new datagram
+ */
+#ifdef UIP_MCAST6_DUP_CONF_ENTRIES
+#define UIP_MCAST6_DUP_ENTRIES UIP_MCAST6_DUP_CONF_ENTRIES
+#else
+#define UIP_MCAST6_DUP_ENTRIES 4
+#endif
+
+/**
+ * For how long (clock ticks) a datagram is remembered. This should cover
+ * MAC-layer retransmissions and a parent switch, but no more: a sender may
+ * legitimately repeat the exact same datagram later on
+ */
+#ifdef UIP_MCAST6_DUP_CONF_LIFETIME
+#define UIP_MCAST6_DUP_LIFETIME UIP_MCAST6_DUP_CONF_LIFETIME
+#else
+#define UIP_MCAST6_DUP_LIFETIME CLOCK_SECOND
+#endif
+/*---------------------------------------------------------------------------*/
+/** \name Duplicate Suppression */
+/** @{ */
+
+/**
+ * \brief Check whether the datagram in uip_buf is a duplicate
+ * \return 1 if we've seen it recently, 0 otherwise
+ *
+ *        Datagrams are identified by source, destination group and a tag:
+ *        The UDP checksum and length if the datagram is UDP (possibly after a
+ *        hop-by-hop options header), otherwise the flow label and payload
+ *        length. A new datagram is remembered, replacing the oldest entry.
+ *        Datagrams whose tag is 0 (UDP checksum not set, no flow label) are
+ *        never remembered, nor taken for duplicates
+ */
+uint8_t uip_mcast6_dup_check(void);
+
+/**
+ * \brief Forget all datagrams
+ */
+void uip_mcast6_dup_init(void);
+/** @} */
+
+#endif /* UIP_MCAST6_DUP_H_ */
+/** @} */
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2026, The Contiki Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * \addtogroup uip6-multicast
+ * @{
+ */
+/**
+ * \file
+ *    Queue of datagrams waiting for their forwarding delay to expire
+ *
+ * \author
+ *    The Contiki Project
+ */
+
+#include "contiki.h"
+#include "contiki-net.h"
+#include "net/ipv6/multicast/uip-mcast6-fwd.h"
+#include "net/ipv6/multicast/uip-mcast6-stats.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/*---------------------------------------------------------------------------*/
+#define UIP_IP_BUF ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+/*---------------------------------------------------------------------------*/
+static void fwd_expired(void *ptr);
+/*---------------------------------------------------------------------------*/
+/* Point the queue's timer at the earliest deadline in it */
+static void
+timer_update(struct uip_mcast6_fwd *q)
+{
+  struct uip_mcast6_fwd_slot *slot;
+  clock_time_t now;
+  clock_time_t elapsed;
+  clock_time_t next;
+  uint8_t pending;
+
+  now = clock_time();
+  next = 0;
+  pending = 0;
+
+  for(slot = q->slots; slot < &q->slots[q->size]; slot++) {
+    if(slot->len == 0) {
+      continue;
+    }
+    elapsed = now - slot->queued;
+    if(elapsed >= slot->delay) {
+      elapsed = slot->delay;
+    }
+    if(!pending || slot->delay - elapsed < next) {
+      next = slot->delay - elapsed;
+    }
+    pending = 1;
+  }
+
+  if(pending) {
+    ctimer_set(&q->timer, next, fwd_expired, q);
+  } else {
+    ctimer_stop(&q->timer);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Send all queued datagrams whose delay has expired */
+static void
+fwd_expired(void *ptr)
+{
+  struct uip_mcast6_fwd *q = ptr;
+  struct uip_mcast6_fwd_slot *slot;
+  clock_time_t now;
+
+  now = clock_time();
+  for(slot = q->slots; slot < &q->slots[q->size]; slot++) {
+    if(slot->len && (clock_time_t)(now - slot->queued) >= slot->delay) {
+      memcpy(uip_buf, &slot->buf, slot->len);
+      uip_len = slot->len;
+      q->send(slot, now - slot->queued);
+      slot->len = 0;
+    }
+  }
+  uip_clear_buf();
+
+  timer_update(q);
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_mcast6_fwd_init(struct uip_mcast6_fwd *q,
+                    void (*send)(struct uip_mcast6_fwd_slot *slot,
+                                 clock_time_t waited))
+{
+  memset(q->slots, 0, q->size * sizeof(q->slots[0]));
+  q->send = send;
+  ctimer_stop(&q->timer);
+}
+/*---------------------------------------------------------------------------*/
+struct uip_mcast6_fwd_slot *
+uip_mcast6_fwd_alloc(struct uip_mcast6_fwd *q)
+{
+  struct uip_mcast6_fwd_slot *slot;
+
+  for(slot = q->slots; slot < &q->slots[q->size]; slot++) {
+    if(slot->len == 0) {
+      slot->origin = 0;
+      return slot;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_mcast6_fwd_schedule(struct uip_mcast6_fwd *q,
+                        struct uip_mcast6_fwd_slot *slot, clock_time_t delay)
+{
+  slot->queued = clock_time();
+  slot->delay = delay;
+  timer_update(q);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+uip_mcast6_fwd_used(struct uip_mcast6_fwd *q)
+{
+  struct uip_mcast6_fwd_slot *slot;
+  uint8_t used;
+
+  used = 0;
+  for(slot = q->slots; slot < &q->slots[q->size]; slot++) {
+    if(slot->len) {
+      used++;
+    }
+  }
+  return used;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_mcast6_fwd_relay(struct uip_mcast6_fwd_slot *slot, clock_time_t waited)
+{
+  UIP_IP_BUF->ttl--;
+  UIP_MCAST6_STATS_LATENCY_ADD(UIP_MCAST6_LATENCY_FWD, waited);
+  tcpip_output(NULL);
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2026, The Contiki Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * \addtogroup uip6-multicast
+ * @{
+ */
+/**
+ * \file
+ *    Header file for the queue of datagrams waiting for their forwarding
+ *    delay to expire, used by SMRF and ESMRF
+ *
+ * \author
+ *    The Contiki Project
+ */
+#ifndef UIP_MCAST6_FWD_H_
+#define UIP_MCAST6_FWD_H_
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+
+#include <stdint.h>
+/*---------------------------------------------------------------------------*/
+/** \brief A datagram waiting in a forwarding queue */
+struct uip_mcast6_fwd_slot {
+  uip_buf_t buf;        /**< The datagram, as it was in uip_buf */
+  clock_time_t queued;  /**< When it was scheduled (absolute clock_time) */
+  clock_time_t delay;   /**< Clock ticks, from 'queued' */
+  uint16_t len;         /**< 0: Slot is free */
+  uint8_t origin;       /**< For the engine to tell its datagrams apart */
+};
+
+/** \brief A forwarding queue. Declare with UIP_MCAST6_FWD() */
+struct uip_mcast6_fwd {
+  struct uip_mcast6_fwd_slot *slots;
+  uint8_t size;
+
+  /**
+   * Called for each datagram whose delay has expired, once it's back in
+   * uip_buf, with the number of ticks it waited
+   */
+  void (*send)(struct uip_mcast6_fwd_slot *slot, clock_time_t waited);
+  struct ctimer timer;
+};
+
+/**
+ * Declare a forwarding queue called name, with n slots. Each slot costs a
+ * uip_buf_t worth of RAM
+ */
+#define UIP_MCAST6_FWD(name, n) \
+  static struct uip_mcast6_fwd_slot name##_slots[n]; \
+  static struct uip_mcast6_fwd name = { .slots = name##_slots, .size = n }
+
+/** The IPv6 header of the datagram held in slot s */
+#define UIP_MCAST6_FWD_IP_BUF(s) \
+  ((struct uip_ip_hdr *)&(s)->buf.u8[UIP_LLH_LEN])
+/*---------------------------------------------------------------------------*/
+/** \name Forwarding Queue */
+/** @{ */
+
+/**
+ * \brief Empty a queue
+ * \param q The queue
+ * \param send What to do with datagrams whose delay has expired, e.g.
+ *        uip_mcast6_fwd_relay()
+ */
+void uip_mcast6_fwd_init(struct uip_mcast6_fwd *q,
+                         void (*send)(struct uip_mcast6_fwd_slot *slot,
+                                      clock_time_t waited));
+
+/**
+ * \brief Find a free slot
+ * \param q The queue
+ * \return The slot, with origin 0, or NULL if all slots are busy
+ *
+ *        The slot stays free until the caller sets its len, so it can also
+ *        hold a datagram for a while without ever scheduling it
+ */
+struct uip_mcast6_fwd_slot *uip_mcast6_fwd_alloc(struct uip_mcast6_fwd *q);
+
+/**
+ * \brief Schedule the datagram held in a slot
+ * \param q The queue
+ * \param slot A slot from uip_mcast6_fwd_alloc(), with buf and len set
+ * \param delay Clock ticks from now. Datagrams already waiting keep their
+ *        own deadline
+ */
+void uip_mcast6_fwd_schedule(struct uip_mcast6_fwd *q,
+                             struct uip_mcast6_fwd_slot *slot,
+                             clock_time_t delay);
+
+/**
+ * \brief Number of busy slots, for high-water mark stats
+ */
+uint8_t uip_mcast6_fwd_used(struct uip_mcast6_fwd *q);
+
+/**
+ * \brief Relay the datagram in uip_buf one hop down: Decrement its hop
+ *        limit and broadcast it
+ *
+ *        A send callback for uip_mcast6_fwd_init(). Counts waited in the
+ *        UIP_MCAST6_LATENCY_FWD histogram
+ */
+void uip_mcast6_fwd_relay(struct uip_mcast6_fwd_slot *slot,
+                          clock_time_t waited);
+/** @} */
+
+#endif /* UIP_MCAST6_FWD_H_ */
+/** @} */
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2026, The Contiki Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * \addtogroup uip6-multicast
+ * @{
+ */
+/**
+ * \file
+ *    Cache of RPL preferred parents
+ *
+ * \author
+ *    The Contiki Project
+ */
+
+#include "contiki.h"
+#include "contiki-net.h"
+#include "net/ipv6/multicast/uip-mcast6-parent.h"
+#include "net/rpl/rpl.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define DEBUG DEBUG_NONE
+#include "net/ip/uip-debug.h"
+
+/*---------------------------------------------------------------------------*/
+#define UIP_IP_BUF ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+/*---------------------------------------------------------------------------*/
+/*
+ * RPL instance ID of the datagram in uip_buf, as carried in the RPL
+ * hop-by-hop option. UIP_MCAST6_PARENT_ANY_INSTANCE if there is no such
+ * option
+ */
+static int16_t
+rpl_hbh_instance(void)
+{
+  struct uip_ext_hdr *hbh;
+  struct uip_ext_hdr_opt_rpl *opt;
+  uint16_t pos;
+  uint16_t end;
+
+  if(UIP_IP_BUF->proto != UIP_PROTO_HBHO) {
+    return UIP_MCAST6_PARENT_ANY_INSTANCE;
+  }
+
+  hbh = (struct uip_ext_hdr *)&uip_buf[UIP_LLH_LEN + UIP_IPH_LEN];
+  pos = UIP_LLH_LEN + UIP_IPH_LEN + 2;
+  end = UIP_LLH_LEN + UIP_IPH_LEN + ((hbh->len + 1) << 3);
+  if(end > UIP_LLH_LEN + uip_len || end > UIP_BUFSIZE) {
+    return UIP_MCAST6_PARENT_ANY_INSTANCE;
+  }
+
+  while(pos + 2 <= end) {
+    opt = (struct uip_ext_hdr_opt_rpl *)&uip_buf[pos];
+    if(opt->opt_type == UIP_EXT_HDR_OPT_PAD1) {
+      pos++;
+      continue;
+    }
+    if(opt->opt_type == UIP_EXT_HDR_OPT_RPL && pos + 4 <= end) {
+      return opt->instance;
+    }
+    pos += 2 + opt->opt_len;
+  }
+  return UIP_MCAST6_PARENT_ANY_INSTANCE;
+}
+/*---------------------------------------------------------------------------*/
+/* Our DODAG in the given RPL instance, NULL if we haven't joined one */
+static rpl_dag_t *
+dag_get(int16_t instance_id)
+{
+  rpl_instance_t *instance;
+
+  if(instance_id == UIP_MCAST6_PARENT_ANY_INSTANCE) {
+    return rpl_get_any_dag();
+  }
+  instance = rpl_get_instance(instance_id);
+  return instance == NULL ? NULL : instance->current_dag;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Our preferred parent in the given RPL instance. The LL address is looked up
+ * once and kept until the cache is flushed. NULL if we don't have a parent in
+ * that instance
+ */
+static struct uip_mcast6_parent *
+parent_get(struct uip_mcast6_parents *c, int16_t instance_id)
+{
+  struct uip_mcast6_parent *pc;
+  struct uip_mcast6_parent *free_pc;
+  rpl_dag_t *d;                 /* Our DODAG */
+  uip_ipaddr_t *parent_ipaddr;  /* Our pref. parent's IPv6 address */
+  const uip_lladdr_t *lladdr;   /* Our pref. parent's LL address */
+
+  free_pc = NULL;
+  for(pc = c->entries; pc < &c->entries[RPL_MAX_INSTANCES + 1]; pc++) {
+    if(!pc->valid) {
+      free_pc = pc;
+    } else if(pc->instance_id == instance_id) {
+      return pc;
+    }
+  }
+
+  /* Can't happen, there's room for every instance RPL may know */
+  if(free_pc == NULL) {
+    return NULL;
+  }
+
+  d = dag_get(instance_id);
+  if(!d) {
+    PRINTF("mcast6 parent: No DODAG for instance %d\n", instance_id);
+    return NULL;
+  }
+
+  parent_ipaddr = rpl_get_parent_ipaddr(d->preferred_parent);
+  lladdr = uip_ds6_nbr_lladdr_from_ipaddr(parent_ipaddr);
+  if(lladdr == NULL) {
+    PRINTF("mcast6 parent: No LL address for instance %d\n", instance_id);
+    return NULL;
+  }
+
+  memcpy(&free_pc->lladdr, lladdr, sizeof(free_pc->lladdr));
+  free_pc->dag = d;
+  free_pc->parent = d->preferred_parent;
+  free_pc->instance_id = instance_id;
+  free_pc->valid = 1;
+  if(c->refresh != NULL) {
+    (*c->refresh)++;
+  }
+  return free_pc;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * The datagram didn't come from pc's parent. If RPL switched parents or
+ * DODAGs without telling us, because RPL_CALLBACK_PARENT_SWITCH is taken, look
+ * our parent up again. Returns the fresh entry if the datagram came from our
+ * parent after all, NULL if it didn't
+ */
+static struct uip_mcast6_parent *
+parent_recheck(struct uip_mcast6_parents *c, struct uip_mcast6_parent *pc)
+{
+  int16_t instance_id;
+
+  if(dag_get(pc->instance_id) == pc->dag &&
+     pc->dag->preferred_parent == pc->parent) {
+    return NULL;
+  }
+
+  PRINTF("mcast6 parent: Missed a parent switch\n");
+  instance_id = pc->instance_id;
+  pc->valid = 0;
+  pc = parent_get(c, instance_id);
+  if(pc == NULL || memcmp(&pc->lladdr, packetbuf_addr(PACKETBUF_ADDR_SENDER),
+                          UIP_LLADDR_LEN)) {
+    return NULL;
+  }
+  return pc;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_mcast6_parent_init(struct uip_mcast6_parents *c,
+                       UIP_MCAST6_STATS_DATATYPE *refresh)
+{
+  uip_mcast6_parent_flush(c);
+  c->refresh = refresh;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_mcast6_parent_flush(struct uip_mcast6_parents *c)
+{
+  memset(c->entries, 0, sizeof(c->entries));
+}
+/*---------------------------------------------------------------------------*/
+struct uip_mcast6_parent *
+uip_mcast6_parent_in(struct uip_mcast6_parents *c)
+{
+  struct uip_mcast6_parent *pc;
+
+  pc = parent_get(c, rpl_hbh_instance());
+  if(pc == NULL) {
+    return NULL;
+  }
+
+  if(memcmp(&pc->lladdr, packetbuf_addr(PACKETBUF_ADDR_SENDER),
+            UIP_LLADDR_LEN)) {
+    return parent_recheck(c, pc);
+  }
+  return pc;
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2026, The Contiki Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * \addtogroup uip6-multicast
+ * @{
+ */
+/**
+ * \file
+ *    Header file for the cache of RPL preferred parents, used by SMRF and
+ *    ESMRF to accept datagrams from their parent only
+ *
+ *    There is an entry for each RPL instance a datagram arrived through,
+ *    as named by its RPL hop-by-hop option, and one for datagrams without
+ *    the option. An entry keeps the parent's link-layer address, looked up
+ *    once, until the engine flushes the cache on a parent switch. If RPL
+ *    switched without telling the engine, the first datagram from another
+ *    neighbour makes the cache check with RPL again
+ *
+ * \author
+ *    The Contiki Project
+ */
+#ifndef UIP_MCAST6_PARENT_H_
+#define UIP_MCAST6_PARENT_H_
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+#include "net/rpl/rpl.h"
+#include "net/ipv6/multicast/uip-mcast6-stats.h"
+
+#include <stdint.h>
+/*---------------------------------------------------------------------------*/
+/** Instance ID of the entry for datagrams without the RPL option */
+#define UIP_MCAST6_PARENT_ANY_INSTANCE  -1
+/*---------------------------------------------------------------------------*/
+/** \brief Our preferred parent in one RPL instance */
+struct uip_mcast6_parent {
+  uip_lladdr_t lladdr;
+  rpl_dag_t *dag;
+  rpl_parent_t *parent; /**< dag->preferred_parent when we cached it */
+  int16_t instance_id;  /**< _ANY_INSTANCE: rpl_get_any_dag() */
+  uint8_t valid;
+};
+
+/** \brief A parent cache, with room for every instance RPL may know */
+struct uip_mcast6_parents {
+  struct uip_mcast6_parent entries[RPL_MAX_INSTANCES + 1];
+
+  /** Incremented for each link-layer address lookup, if not NULL */
+  UIP_MCAST6_STATS_DATATYPE *refresh;
+};
+/*---------------------------------------------------------------------------*/
+/** \name Preferred Parent Cache */
+/** @{ */
+
+/**
+ * \brief Initialise a cache
+ * \param c The cache
+ * \param refresh The engine's counter of address lookups, or NULL
+ */
+void uip_mcast6_parent_init(struct uip_mcast6_parents *c,
+                            UIP_MCAST6_STATS_DATATYPE *refresh);
+
+/**
+ * \brief Forget all parents, e.g. because RPL switched one
+ */
+void uip_mcast6_parent_flush(struct uip_mcast6_parents *c);
+
+/**
+ * \brief Check that the datagram in uip_buf came from our preferred parent
+ * \param c The cache
+ * \return Our parent in the datagram's RPL instance, or NULL if the
+ *         datagram came from someone else or we have no parent there
+ */
+struct uip_mcast6_parent *uip_mcast6_parent_in(struct uip_mcast6_parents *c);
+/** @} */
+
+#endif /* UIP_MCAST6_PARENT_H_ */
+/** @} */
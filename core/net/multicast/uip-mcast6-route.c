@@ -62,13 +62,56 @@ MEMB(mcast_route_memb, uip_mcast6_route_t, UIP_MCAST6_ROUTE_ROUTES);
 
 static uip_mcast6_route_t *locmcastrt;
 /*---------------------------------------------------------------------------*/
+#if UIP_MCAST6_ROUTE_HASH
+static uip_mcast6_route_t *buckets[UIP_MCAST6_ROUTE_HASH_BUCKETS];
+/*---------------------------------------------------------------------------*/
+/*
+ * Hash a group address into a bucket index. We fold the scope byte and the
+ * last 32 bits of the group ID: That's where groups tend to differ in
+ * practice (e.g. FF1E::89:ABCD) and it's what IPHC carries inline anyway
+ */
+static uint8_t
+route_hash(const uip_ipaddr_t *group)
+{
+  uint8_t h;
+
+  h = group->u8[1];
+  h = ((h << 3) | (h >> 5)) ^ group->u8[12];
+  h = ((h << 3) | (h >> 5)) ^ group->u8[13];
+  h = ((h << 3) | (h >> 5)) ^ group->u8[14];
+  h = ((h << 3) | (h >> 5)) ^ group->u8[15];
+
+  return h & (UIP_MCAST6_ROUTE_HASH_BUCKETS - 1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+bucket_rm(uip_mcast6_route_t *route)
+{
+  uip_mcast6_route_t **prev;
+
+  for(prev = &buckets[route_hash(&route->group)]; *prev != NULL;
+      prev = &(*prev)->hnext) {
+    if(*prev == route) {
+      *prev = route->hnext;
+      return;
+    }
+  }
+}
+#endif /* UIP_MCAST6_ROUTE_HASH */
+/*---------------------------------------------------------------------------*/
 uip_mcast6_route_t *
 uip_mcast6_route_lookup(uip_ipaddr_t *group)
 {
   locmcastrt = NULL;
+#if UIP_MCAST6_ROUTE_HASH
+  for(locmcastrt = buckets[route_hash(group)];
+      locmcastrt != NULL;
+      locmcastrt = locmcastrt->hnext) {
+#else
   for(locmcastrt = list_head(mcast_route_list);
       locmcastrt != NULL;
       locmcastrt = list_item_next(locmcastrt)) {
+#endif
     if(uip_ipaddr_cmp(&locmcastrt->group, group)) {
       return locmcastrt;
     }
@@ -89,12 +132,20 @@ uip_mcast6_route_add(uip_ipaddr_t *group)
       return NULL;
     }
     list_add(mcast_route_list, locmcastrt);
+
+    uip_ipaddr_copy(&(locmcastrt->group), group);
+    locmcastrt->dag = NULL;
+#if UIP_MCAST6_GROUP_STATS
+    memset(&locmcastrt->stats, 0, sizeof(locmcastrt->stats));
+#endif
+#if UIP_MCAST6_ROUTE_HASH
+    locmcastrt->hnext = buckets[route_hash(group)];
+    buckets[route_hash(group)] = locmcastrt;
+#endif
   }
 
   /* Reaching here means we either found the prefix or allocated a new one */
 
-  uip_ipaddr_copy(&(locmcastrt->group), group);
-
   return locmcastrt;
 }
 /*---------------------------------------------------------------------------*/
@@ -106,6 +157,9 @@ uip_mcast6_route_rm(uip_mcast6_route_t *route)
       locmcastrt != NULL;
       locmcastrt = list_item_next(locmcastrt)) {
     if(locmcastrt == route) {
+#if UIP_MCAST6_ROUTE_HASH
+      bucket_rm(route);
+#endif
       list_remove(mcast_route_list, route);
       memb_free(&mcast_route_memb, route);
       return;
@@ -119,6 +173,16 @@ uip_mcast6_route_list_head(void)
   return list_head(mcast_route_list);
 }
 /*---------------------------------------------------------------------------*/
+#if UIP_MCAST6_GROUP_STATS
+void
+uip_mcast6_route_stats_snapshot(uip_mcast6_route_t *route,
+                                uip_mcast6_group_stats_t *snap)
+{
+  memcpy(snap, &route->stats, sizeof(route->stats));
+  memset(&route->stats, 0, sizeof(route->stats));
+}
+#endif
+/*---------------------------------------------------------------------------*/
 int
 uip_mcast6_route_count(void)
 {
@@ -130,6 +194,9 @@ uip_mcast6_route_init()
 {
   memb_init(&mcast_route_memb);
   list_init(mcast_route_list);
+#if UIP_MCAST6_ROUTE_HASH
+  memset(buckets, 0, sizeof(buckets));
+#endif
 }
 /*---------------------------------------------------------------------------*/
 /** @} */
@@ -44,17 +44,71 @@
 
 #include "contiki.h"
 #include "net/ip/uip.h"
+#include "net/ipv6/multicast/uip-mcast6-stats.h"
 
 #include <stdint.h>
 /*---------------------------------------------------------------------------*/
+/* Configuration */
+/*---------------------------------------------------------------------------*/
+/**
+ * Multicast routing table backend. When set to 0 (default), lookups walk the
+ * list of routes. When set to 1, routes are additionally indexed by a hash of
+ * the group ID so that lookups only visit the entries of a single bucket.
+ * The list (and thus uip_mcast6_route_list_head()) is maintained either way
+ */
+#ifdef UIP_MCAST6_ROUTE_CONF_HASH
+#define UIP_MCAST6_ROUTE_HASH UIP_MCAST6_ROUTE_CONF_HASH
+#else
+#define UIP_MCAST6_ROUTE_HASH 0
+#endif
+
+/**
+ * Number of hash buckets when UIP_MCAST6_ROUTE_HASH is enabled. Must be a
+ * power of two. For constant-time lookups, this should be at least equal to
+ * the number of routes
+ */
+#ifdef UIP_MCAST6_ROUTE_CONF_HASH_BUCKETS
+#define UIP_MCAST6_ROUTE_HASH_BUCKETS UIP_MCAST6_ROUTE_CONF_HASH_BUCKETS
+#else
+#define UIP_MCAST6_ROUTE_HASH_BUCKETS 8
+#endif
+
+#if UIP_MCAST6_ROUTE_HASH && \
+  (UIP_MCAST6_ROUTE_HASH_BUCKETS & (UIP_MCAST6_ROUTE_HASH_BUCKETS - 1))
+#error "UIP_MCAST6_ROUTE_CONF_HASH_BUCKETS must be a power of two"
+#endif
+/*---------------------------------------------------------------------------*/
 /** \brief An entry in the multicast routing table */
 typedef struct uip_mcast6_route {
   struct uip_mcast6_route *next; /**< Routes are arranged in a linked list */
   uip_ipaddr_t group; /**< The multicast group */
   uint32_t lifetime; /**< Entry lifetime seconds */
   void *dag; /**< Pointer to an rpl_dag_t struct */
+#if UIP_MCAST6_ROUTE_HASH
+  struct uip_mcast6_route *hnext; /**< Next route in the same hash bucket */
+#endif
+#if UIP_MCAST6_GROUP_STATS
+  uip_mcast6_group_stats_t stats; /**< Traffic seen for the group */
+#endif
 } uip_mcast6_route_t;
 /*---------------------------------------------------------------------------*/
+/*
+ * Per-group stats access. r is a route, which may be NULL: Datagrams for
+ * groups without a route are not counted. r is only evaluated if per-group
+ * stats are enabled
+ */
+#if UIP_MCAST6_GROUP_STATS
+#define UIP_MCAST6_ROUTE_STATS_ADD_N(r, x, n) do { \
+    uip_mcast6_route_t *stats_rt = (r); \
+    if(stats_rt != NULL) { \
+      stats_rt->stats.x += (n); \
+    } \
+  } while(0)
+#else
+#define UIP_MCAST6_ROUTE_STATS_ADD_N(r, x, n)
+#endif
+#define UIP_MCAST6_ROUTE_STATS_ADD(r, x) UIP_MCAST6_ROUTE_STATS_ADD_N(r, x, 1)
+/*---------------------------------------------------------------------------*/
 /** \name Multicast Routing Table Manipulation */
 /** @{ */
 
@@ -70,6 +124,10 @@ uip_mcast6_route_t *uip_mcast6_route_lookup(uip_ipaddr_t *group);
  * \brief Add a multicast route
  * \param group A pointer to the multicast group to be added
  * \return A pointer to the new route, or NULL if the route could not be added
+ *
+ *        If the table already has a route for the group, that route is
+ *        returned. A group has a single route, whichever RPL instances its
+ *        members joined through
  */
 uip_mcast6_route_t *uip_mcast6_route_add(uip_ipaddr_t *group);
 
@@ -92,6 +150,19 @@ int uip_mcast6_route_count(void);
  * If the multicast routes list is empty, this function will return NULL
  */
 uip_mcast6_route_t *uip_mcast6_route_list_head(void);
+
+#if UIP_MCAST6_GROUP_STATS
+/**
+ * \brief Take a snapshot of a route's per-group stats and reset them
+ * \param route A pointer to the route
+ * \param snap Where to copy the current values
+ *
+ *        A route's stats go away with the route. Walk the table with
+ *        uip_mcast6_route_list_head() to collect them all
+ */
+void uip_mcast6_route_stats_snapshot(uip_mcast6_route_t *route,
+                                     uip_mcast6_group_stats_t *snap);
+#endif
 /*---------------------------------------------------------------------------*/
 /**
  * \brief Multicast routing table init routine
@@ -43,6 +43,16 @@
 #include <string.h>
 /*---------------------------------------------------------------------------*/
 uip_mcast6_stats_t uip_mcast6_stats;
+
+static const struct uip_mcast6_stats_desc core_desc[] = {
+  UIP_MCAST6_STATS_DESC(uip_mcast6_stats, mcast_in_unique, 0),
+  UIP_MCAST6_STATS_DESC(uip_mcast6_stats, mcast_in_all, 0),
+  UIP_MCAST6_STATS_DESC(uip_mcast6_stats, mcast_in_ours, 0),
+  UIP_MCAST6_STATS_DESC(uip_mcast6_stats, mcast_fwd, 0),
+  UIP_MCAST6_STATS_DESC(uip_mcast6_stats, mcast_out, 0),
+  UIP_MCAST6_STATS_DESC(uip_mcast6_stats, mcast_bad, 0),
+  UIP_MCAST6_STATS_DESC(uip_mcast6_stats, mcast_dropped, 0),
+};
 /*---------------------------------------------------------------------------*/
 void
 uip_mcast6_stats_init(void *stats)
@@ -51,4 +61,48 @@ uip_mcast6_stats_init(void *stats)
   uip_mcast6_stats.engine_stats = stats;
 }
 /*---------------------------------------------------------------------------*/
+void
+uip_mcast6_stats_snapshot(uip_mcast6_stats_t *snap)
+{
+  memcpy(snap, &uip_mcast6_stats, sizeof(uip_mcast6_stats));
+  uip_mcast6_stats_init(snap->engine_stats);
+}
+/*---------------------------------------------------------------------------*/
+const struct uip_mcast6_stats_desc *
+uip_mcast6_stats_describe(uint8_t *n)
+{
+  *n = sizeof(core_desc) / sizeof(core_desc[0]);
+  return core_desc;
+}
+/*---------------------------------------------------------------------------*/
+uint32_t
+uip_mcast6_stats_value(const void *stats,
+                       const struct uip_mcast6_stats_desc *d)
+{
+  const uint8_t *p = (const uint8_t *)stats + d->offset;
+
+  switch(UIP_MCAST6_STATS_T_SIZE(d->type)) {
+  case UIP_MCAST6_STATS_T_U32:
+    return *(const uint32_t *)p;
+  case UIP_MCAST6_STATS_T_U16:
+    return *(const uint16_t *)p;
+  default:
+    return *p;
+  }
+}
+/*---------------------------------------------------------------------------*/
+#if UIP_MCAST6_STATS_LATENCY
+void
+uip_mcast6_stats_latency_add(uint8_t kind, uint32_t ticks)
+{
+  uint8_t b;
+
+  /* The bucket is the number of significant bits in ticks */
+  for(b = 0; ticks != 0 && b < UIP_MCAST6_LATENCY_BUCKETS - 1; b++) {
+    ticks >>= 1;
+  }
+  uip_mcast6_stats.latency[kind][b]++;
+}
+#endif
+/*---------------------------------------------------------------------------*/
 /** @} */
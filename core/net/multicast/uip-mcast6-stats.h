@@ -43,6 +43,7 @@
 /*---------------------------------------------------------------------------*/
 #include "contiki-conf.h"
 
+#include <stddef.h>
 #include <stdint.h>
 /*---------------------------------------------------------------------------*/
 /* The platform can override the stats datatype */
@@ -60,6 +61,43 @@
 
 #define ICMP6_ESMRF 150
 
+/**
+ * Per-group stats. When set, each entry in the multicast routing table
+ * keeps its own counters for its group, see uip_mcast6_group_stats_t. Only
+ * engines which use the routing table (SMRF, ESMRF) maintain them
+ */
+#ifdef UIP_MCAST6_CONF_GROUP_STATS
+#define UIP_MCAST6_GROUP_STATS UIP_MCAST6_CONF_GROUP_STATS
+#else
+#define UIP_MCAST6_GROUP_STATS 0
+#endif
+/**
+ * Forwarding latency histograms. When set (and stats are on), engines record
+ * how long each datagram they forward waited between reaching in() and its
+ * first trip to tcpip_output(), in clock ticks. This is mostly the delay the
+ * engines add on purpose. The gaps go into log2 buckets: Bucket 0 counts
+ * gaps of 0 ticks, bucket b counts gaps in [2^(b-1), 2^b) and the last one
+ * also counts everything longer
+ */
+#ifdef UIP_MCAST6_CONF_STATS_LATENCY
+#define UIP_MCAST6_STATS_LATENCY UIP_MCAST6_CONF_STATS_LATENCY
+#else
+#define UIP_MCAST6_STATS_LATENCY 0
+#endif
+
+/** Number of buckets in each latency histogram */
+#ifdef UIP_MCAST6_CONF_LATENCY_BUCKETS
+#define UIP_MCAST6_LATENCY_BUCKETS UIP_MCAST6_CONF_LATENCY_BUCKETS
+#else
+#define UIP_MCAST6_LATENCY_BUCKETS 12
+#endif
+
+/** \name Latency histograms, first index of uip_mcast6_stats_t latency */
+/** @{ */
+#define UIP_MCAST6_LATENCY_FWD       0 /**< Relayed datagrams */
+#define UIP_MCAST6_LATENCY_ON_BEHALF 1 /**< ESMRF root: Re-injected ones */
+#define UIP_MCAST6_LATENCY_KINDS     2
+/** @} */
 /*---------------------------------------------------------------------------*/
 /* Stats datatype */
 /*---------------------------------------------------------------------------*/
@@ -90,9 +128,72 @@ typedef struct uip_mcast6_stats {
   /** Count of multicast datagrams correclty formed but dropped by us */
   UIP_MCAST6_STATS_DATATYPE mcast_dropped;
 
+#if UIP_MCAST6_STATS_LATENCY
+  /** Forwarding latency histograms, see UIP_MCAST6_STATS_LATENCY */
+  UIP_MCAST6_STATS_DATATYPE
+    latency[UIP_MCAST6_LATENCY_KINDS][UIP_MCAST6_LATENCY_BUCKETS];
+#endif
+
   /** Opaque pointer to an engine's additional stats */
   void *engine_stats;
 } uip_mcast6_stats_t;
+
+/**
+ * \brief Stats for a single multicast group, kept in its routing entry
+ *
+ * These are always 32 bits wide, regardless of UIP_MCAST6_STATS_DATATYPE
+ */
+typedef struct uip_mcast6_group_stats {
+  /** Count of unique datagrams for the group received from our parent */
+  uint32_t in;
+
+  /** Count of datagrams for the group forwarded by us */
+  uint32_t fwd;
+
+  /** Count of datagrams for the group which we received but did not forward */
+  uint32_t dropped;
+
+  /** Sum of the lengths of the datagrams counted in 'in' */
+  uint32_t bytes;
+} uip_mcast6_group_stats_t;
+
+/** \name Stats descriptor types, see struct uip_mcast6_stats_desc */
+/** @{ */
+#define UIP_MCAST6_STATS_T_U8      0x01 /**< uint8_t */
+#define UIP_MCAST6_STATS_T_U16     0x02 /**< uint16_t */
+#define UIP_MCAST6_STATS_T_U32     0x04 /**< uint32_t */
+#define UIP_MCAST6_STATS_T_MAX     0x80 /**< Flag: High-water mark */
+/** @} */
+
+/** The width, in bytes, of a counter of type t */
+#define UIP_MCAST6_STATS_T_SIZE(t) ((t) & 0x0F)
+
+/**
+ * \brief Describes one counter in a stats struct
+ *
+ *        Engines return arrays of these through their driver's stats()
+ *        callback, so that generic code can list and read their counters.
+ *        Counters of type _MAX are high-water marks: Their value is
+ *        meaningful in itself, the difference between two readings is not
+ */
+struct uip_mcast6_stats_desc {
+  /** The counter's name, as in the stats struct */
+  const char *name;
+
+  /** Offset of the counter in the stats struct */
+  uint8_t offset;
+
+  /** One of UIP_MCAST6_STATS_T_U8/16/32, optionally | _MAX */
+  uint8_t type;
+};
+
+/**
+ * Initialiser for a struct uip_mcast6_stats_desc which describes member f
+ * of struct s. The type is worked out from the member's width, flags can
+ * add UIP_MCAST6_STATS_T_MAX
+ */
+#define UIP_MCAST6_STATS_DESC(s, f, flags) \
+  { #f, offsetof(struct s, f), sizeof(((struct s *)0)->f) | (flags) }
 /*---------------------------------------------------------------------------*/
 /* Access macros */
 /*---------------------------------------------------------------------------*/
@@ -108,12 +209,65 @@ extern uip_mcast6_stats_t uip_mcast6_stats;
 #define UIP_MCAST6_STATS_GET(x) 0
 #define UIP_MCAST6_STATS_INIT(s)
 #endif /* UIP_MCAST6_STATS */
+
+/* Record a forwarding latency of t ticks in histogram k. t is only evaluated
+ * if latency histograms are on */
+#if UIP_MCAST6_STATS && UIP_MCAST6_STATS_LATENCY
+#define UIP_MCAST6_STATS_LATENCY_ADD(k, t) uip_mcast6_stats_latency_add(k, t)
+#else
+#define UIP_MCAST6_STATS_LATENCY_ADD(k, t)
+#endif
 /*---------------------------------------------------------------------------*/
 /**
  * \brief Initialise multicast stats
  * \param stats A pointer to a struct holding an engine's additional statistics
  */
 void uip_mcast6_stats_init(void *stats);
+
+/**
+ * \brief Take a snapshot of the core multicast stats and reset them
+ * \param snap Where to copy the current values
+ *
+ *        Counters start from 0 again afterwards, so a collector which
+ *        polls often enough can compute rates without ever seeing them wrap.
+ *        The latency histograms are reset with them.
+ *
+ *        This does not reset the engine's own counters: snap->engine_stats
+ *        points at the live ones, not at a copy. Some of those are
+ *        high-water marks, which a reset would lose. Read them through
+ *        UIP_MCAST6.stats() and take the difference between two readings.
+ *        Per-group stats have their own uip_mcast6_route_stats_snapshot()
+ */
+void uip_mcast6_stats_snapshot(uip_mcast6_stats_t *snap);
+
+/**
+ * \brief Count a forwarding latency in one of the latency histograms
+ * \param kind The histogram, UIP_MCAST6_LATENCY_FWD or _ON_BEHALF
+ * \param ticks The latency, in clock ticks
+ *
+ *        Use UIP_MCAST6_STATS_LATENCY_ADD() instead, it compiles out when
+ *        latency histograms are off
+ */
+void uip_mcast6_stats_latency_add(uint8_t kind, uint32_t ticks);
+
+/**
+ * \brief Describe the counters in uip_mcast6_stats
+ * \param n Set to the number of entries returned
+ * \return The descriptors, in the order of the struct
+ *
+ *        The latency histograms and the engine's stats are not included.
+ *        For the latter, use UIP_MCAST6.stats()
+ */
+const struct uip_mcast6_stats_desc *uip_mcast6_stats_describe(uint8_t *n);
+
+/**
+ * \brief Read a counter described by a stats descriptor
+ * \param stats The stats struct, e.g. uip_mcast6_stats.engine_stats
+ * \param d The counter's descriptor
+ * \return The counter's value
+ */
+uint32_t uip_mcast6_stats_value(const void *stats,
+                                const struct uip_mcast6_stats_desc *d);
 /*---------------------------------------------------------------------------*/
 #endif /* UIP_MCAST6_STATS_H_ */
 /*---------------------------------------------------------------------------*/
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2026, The Contiki Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * \addtogroup uip6-multicast
+ * @{
+ */
+/**
+ * \file
+ *    Binary multicast stats telemetry over the serial line. The record
+ *    format is described in uip-mcast6-telemetry.h
+ *
+ * \author
+ *    The Contiki Project
+ */
+
+#include "contiki.h"
+#include "lib/crc16.h"
+#include "net/ipv6/multicast/uip-mcast6.h"
+#include "net/ipv6/multicast/uip-mcast6-stats.h"
+#include "net/ipv6/multicast/uip-mcast6-telemetry.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if UIP_MCAST6_TELEMETRY
+#if !UIP_MCAST6_STATS
+#error "Multicast telemetry requires UIP_MCAST6_CONF_STATS != 0"
+#endif
+/*---------------------------------------------------------------------------*/
+/* SLIP special characters */
+#define SLIP_END     0300
+#define SLIP_ESC     0333
+#define SLIP_ESC_END 0334
+#define SLIP_ESC_ESC 0335
+/*---------------------------------------------------------------------------*/
+static uint16_t crc;
+static uint8_t seq;
+/*---------------------------------------------------------------------------*/
+PROCESS(uip_mcast6_telemetry_process, "Multicast telemetry");
+/*---------------------------------------------------------------------------*/
+static void
+put_escaped(uint8_t b)
+{
+  if(b == SLIP_END) {
+    UIP_MCAST6_TELEMETRY_WRITEB(SLIP_ESC);
+    b = SLIP_ESC_END;
+  } else if(b == SLIP_ESC) {
+    UIP_MCAST6_TELEMETRY_WRITEB(SLIP_ESC);
+    b = SLIP_ESC_ESC;
+  }
+  UIP_MCAST6_TELEMETRY_WRITEB(b);
+}
+/*---------------------------------------------------------------------------*/
+static void
+put(uint8_t b)
+{
+  crc = crc16_add(b, crc);
+  put_escaped(b);
+}
+/*---------------------------------------------------------------------------*/
+static void
+put_varint(uint32_t v)
+{
+  while(v >= 0x80) {
+    put((v & 0x7F) | 0x80);
+    v >>= 7;
+  }
+  put(v);
+}
+/*---------------------------------------------------------------------------*/
+/* CRC-16 of the names in a stats descriptor table, NULs included */
+static uint16_t
+layout(const struct uip_mcast6_stats_desc *d, uint8_t n)
+{
+  uint16_t acc;
+
+  acc = 0;
+  for(; n > 0; n--, d++) {
+    acc = crc16_data((const unsigned char *)d->name, strlen(d->name) + 1,
+                     acc);
+  }
+  return acc;
+}
+/*---------------------------------------------------------------------------*/
+static void
+put_section(uint8_t id, const void *stats,
+            const struct uip_mcast6_stats_desc *d, uint8_t n)
+{
+  uint16_t l;
+
+  l = layout(d, n);
+  put(id);
+  put(n);
+  put(l >> 8);
+  put(l & 0xFF);
+  for(; n > 0; n--, d++) {
+    put_varint(uip_mcast6_stats_value(stats, d));
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_mcast6_telemetry_send(void)
+{
+  const struct uip_mcast6_stats_desc *d;
+  uint8_t n;
+#if UIP_MCAST6_STATS_LATENCY
+  const UIP_MCAST6_STATS_DATATYPE *l;
+  uint8_t i;
+#endif
+
+  crc = 0;
+  UIP_MCAST6_TELEMETRY_WRITEB(SLIP_END);
+
+  put(UIP_MCAST6_TELEMETRY_VERSION);
+  put(UIP_MCAST6_ENGINE);
+  put(seq++);
+  put_varint(clock_seconds());
+
+  d = uip_mcast6_stats_describe(&n);
+  put_section(UIP_MCAST6_TELEMETRY_CORE, &uip_mcast6_stats, d, n);
+
+#if UIP_MCAST6_STATS_LATENCY
+  put(UIP_MCAST6_TELEMETRY_LATENCY);
+  put(UIP_MCAST6_LATENCY_KINDS * UIP_MCAST6_LATENCY_BUCKETS);
+  l = &uip_mcast6_stats.latency[0][0];
+  for(i = 0; i < UIP_MCAST6_LATENCY_KINDS * UIP_MCAST6_LATENCY_BUCKETS; i++) {
+    put_varint(l[i]);
+  }
+#endif
+
+#if UIP_MCAST6_ENGINE
+  /* engine_stats is NULL until the engine's init() has run */
+  d = UIP_MCAST6.stats(&n);
+  if(d != NULL && uip_mcast6_stats.engine_stats != NULL) {
+    put_section(UIP_MCAST6_TELEMETRY_ENGINE, uip_mcast6_stats.engine_stats,
+                d, n);
+  }
+#endif
+
+  /* The CRC itself goes out MSB first and does not feed the CRC */
+  put_escaped(crc >> 8);
+  put_escaped(crc & 0xFF);
+  UIP_MCAST6_TELEMETRY_WRITEB(SLIP_END);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(uip_mcast6_telemetry_process, ev, data)
+{
+  static struct etimer et;
+
+  PROCESS_BEGIN();
+
+  etimer_set(&et, UIP_MCAST6_TELEMETRY_INTERVAL);
+
+  while(1) {
+    PROCESS_YIELD_UNTIL(etimer_expired(&et));
+    etimer_reset(&et);
+    uip_mcast6_telemetry_send();
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+#endif /* UIP_MCAST6_TELEMETRY */
+/** @} */
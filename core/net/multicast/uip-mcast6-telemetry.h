@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2026, The Contiki Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * \addtogroup uip6-multicast
+ * @{
+ */
+/**
+ * \file
+ *    Header file for the binary multicast stats telemetry process
+ *
+ *    When enabled, uip_mcast6_telemetry_process periodically writes the
+ *    multicast stats to the serial line as a compact binary record, so a
+ *    host-side collector can ingest numbers without parsing printf output.
+ *    tools/mcast6-telemetry/mcast6-telemetry.py decodes them.
+ *
+ *    Records are SLIP framed (RFC 1055): Each starts and ends with 0xC0, and
+ *    0xC0 / 0xDB in the record are escaped. Text printed to the same line
+ *    between records only costs the decoder a failed CRC. A record is:
+ *
+ *    - Version (1 byte, UIP_MCAST6_TELEMETRY_VERSION)
+ *    - Engine code (1 byte, see uip-mcast6-engines.h)
+ *    - Sequence number (1 byte, wraps) to detect lost records
+ *    - Uptime in seconds (varint)
+ *    - One or more sections: Section ID (1 byte), number of values (1 byte),
+ *      followed by that many varints. Counter sections put the layout of
+ *      their stats descriptor table (2 bytes, MSB first) before the values
+ *    - CRC-16 of all of the above (2 bytes, MSB first), as per lib/crc16.h
+ *
+ *    Varints are unsigned LEB128: 7 bits per byte, least significant group
+ *    first, MSB set on all bytes but the last. Counters below 128 thus take
+ *    a single byte, regardless of UIP_MCAST6_STATS_DATATYPE.
+ *
+ *    The layout is the CRC-16 of the counter names, in order, each with its
+ *    terminating NUL. The collector reads the names from the stats
+ *    descriptor tables in the sources, and the layout tells it which table
+ *    a section was built from, whatever engine and configuration.
+ *
+ *    Counters are sent as they are, they are not reset. The collector
+ *    computes deltas, modulo the width of the datatype
+ *
+ * \author
+ *    The Contiki Project
+ */
+#ifndef UIP_MCAST6_TELEMETRY_H_
+#define UIP_MCAST6_TELEMETRY_H_
+
+#include "contiki.h"
+
+#include <stdint.h>
+/*---------------------------------------------------------------------------*/
+/* Configuration */
+/*---------------------------------------------------------------------------*/
+/** Build the telemetry process. Requires UIP_MCAST6_CONF_STATS */
+#ifdef UIP_MCAST6_CONF_TELEMETRY
+#define UIP_MCAST6_TELEMETRY UIP_MCAST6_CONF_TELEMETRY
+#else
+#define UIP_MCAST6_TELEMETRY 0
+#endif
+
+/** Time between records, in clock ticks */
+#ifdef UIP_MCAST6_TELEMETRY_CONF_INTERVAL
+#define UIP_MCAST6_TELEMETRY_INTERVAL UIP_MCAST6_TELEMETRY_CONF_INTERVAL
+#else
+#define UIP_MCAST6_TELEMETRY_INTERVAL (60 * CLOCK_SECOND)
+#endif
+
+/**
+ * Function used to write a single byte to the serial line. Platforms whose
+ * putchar() translates '\n' into "\r\n" must point this at a raw UART
+ * write, e.g. uart1_writeb
+ */
+#ifdef UIP_MCAST6_TELEMETRY_CONF_WRITEB
+#define UIP_MCAST6_TELEMETRY_WRITEB UIP_MCAST6_TELEMETRY_CONF_WRITEB
+#else
+#define UIP_MCAST6_TELEMETRY_WRITEB putchar
+#endif
+/*---------------------------------------------------------------------------*/
+/* Record format */
+/*---------------------------------------------------------------------------*/
+#define UIP_MCAST6_TELEMETRY_VERSION    2
+
+/** \name Section IDs */
+/** @{ */
+#define UIP_MCAST6_TELEMETRY_CORE       1 /**< uip_mcast6_stats counters */
+#define UIP_MCAST6_TELEMETRY_LATENCY    2 /**< Latency histograms, in order */
+#define UIP_MCAST6_TELEMETRY_ENGINE     3 /**< UIP_MCAST6.stats() */
+/** @} */
+/*---------------------------------------------------------------------------*/
+#if UIP_MCAST6_TELEMETRY
+PROCESS_NAME(uip_mcast6_telemetry_process);
+
+/**
+ * \brief Write a telemetry record now
+ *
+ *        The process calls this every UIP_MCAST6_TELEMETRY_INTERVAL. Call
+ *        it directly to report at the end of an experiment
+ */
+void uip_mcast6_telemetry_send(void);
+#endif
+/*---------------------------------------------------------------------------*/
+#endif /* UIP_MCAST6_TELEMETRY_H_ */
+/*---------------------------------------------------------------------------*/
+/** @} */
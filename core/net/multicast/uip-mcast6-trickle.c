@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2026, The Contiki Project
+ * Portions copyright (c) 2010, Loughborough University - Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * \addtogroup uip6-multicast
+ * @{
+ */
+/**
+ * \file
+ *    Trickle timers and the packet arena, shared by ROLL TM and MPL
+ *
+ * \author
+ *    George Oikonomou - <oikonomou@users.sourceforge.net>
+ *    The Contiki Project
+ */
+
+#include "contiki.h"
+#include "contiki-lib.h"
+#include "contiki-net.h"
+#include "net/ipv6/multicast/uip-mcast6-trickle.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define DEBUG DEBUG_NONE
+#include "net/ip/uip-debug.h"
+
+#define TRICKLE_VERBOSE 0
+
+#if DEBUG && TRICKLE_VERBOSE
+#define VERBOSE_PRINTF(...) PRINTF(__VA_ARGS__)
+#else
+#define VERBOSE_PRINTF(...)
+#endif
+/*---------------------------------------------------------------------------*/
+static void handle_timer(void *ptr);
+/*---------------------------------------------------------------------------*/
+/* Trickle Timers */
+/*---------------------------------------------------------------------------*/
+clock_time_t
+uip_mcast6_trickle_random(clock_time_t i_min, uint8_t d)
+{
+  clock_time_t min = UIP_MCAST6_TRICKLE_TIME(i_min >> 1, d);
+
+  VERBOSE_PRINTF("mcast6 trickle: Random [%lu, %lu)\n", (unsigned long)min,
+                 (unsigned long)(UIP_MCAST6_TRICKLE_TIME(i_min, d)));
+
+  return min +
+         (random_rand() % (UIP_MCAST6_TRICKLE_TIME(i_min, d) - 1 - min));
+}
+/*---------------------------------------------------------------------------*/
+/* Called at the end of the current interval for timer ptr */
+static void
+double_interval(void *ptr)
+{
+  struct uip_mcast6_trickle *t = (struct uip_mcast6_trickle *)ptr;
+  int16_t offset;
+  clock_time_t next;
+
+  if(t->e < 0xFF) {
+    t->e++;
+  }
+  if(t->interval_end != NULL && !t->interval_end(t)) {
+    VERBOSE_PRINTF("mcast6 trickle: %p stopped\n", t);
+    return;
+  }
+
+  /*
+   * If we got called long past our expiration, store the offset and try to
+   * compensate this period
+   */
+  offset = (int16_t)(clock_time() - t->t_end);
+
+  /* Calculate next interval */
+  if(t->i_current < t->i_max) {
+    t->i_current++;
+  }
+
+  t->t_start = t->t_end;
+  t->t_end = t->t_start + UIP_MCAST6_TRICKLE_TIME(t->i_min, t->i_current);
+
+  next = uip_mcast6_trickle_random(t->i_min, t->i_current);
+  if((int32_t)next > offset) {
+    next -= offset;
+  } else {
+    next = 0;
+  }
+  t->t_next = next;
+  ctimer_set(&t->ct, t->t_next, handle_timer, (void *)t);
+
+  VERBOSE_PRINTF("mcast6 trickle: %p doubling at %lu (offset %d), Start %lu,"
+                 " End %lu, Periodic in %lu\n", t,
+                 (unsigned long)clock_time(), offset,
+                 (unsigned long)t->t_start, (unsigned long)t->t_end,
+                 (unsigned long)t->t_next);
+}
+/*---------------------------------------------------------------------------*/
+/* Called at a random point in [I/2,I) of the current interval for ptr */
+static void
+handle_timer(void *ptr)
+{
+  struct uip_mcast6_trickle *t = (struct uip_mcast6_trickle *)ptr;
+  clock_time_t now;
+
+  /* Bail out pronto if our uIPv6 stack is not ready to send messages */
+  if(uip_ds6_get_link_local(ADDR_PREFERRED) == NULL) {
+    VERBOSE_PRINTF("mcast6 trickle: Suppressing timer processing. "
+                   "Stack not ready\n");
+    uip_mcast6_trickle_reset(t);
+    return;
+  }
+
+  t->periodic(t);
+
+  now = clock_time();
+  if(now >= t->t_end) {
+    /* took us too long to process things, double interval asap */
+    t->t_next = 0;
+  } else {
+    t->t_next = t->t_end - now;
+  }
+  VERBOSE_PRINTF("mcast6 trickle: %p periodic at %lu, Interval End at %lu"
+                 " in %lu\n", t, (unsigned long)now,
+                 (unsigned long)t->t_end, (unsigned long)t->t_next);
+  ctimer_set(&t->ct, t->t_next, double_interval, (void *)t);
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_mcast6_trickle_reset(struct uip_mcast6_trickle *t)
+{
+  t->t_start = clock_time();
+  t->t_end = t->t_start + t->i_min;
+  t->i_current = 0;
+  t->c = 0;
+  t->e = 0;
+  t->t_next = uip_mcast6_trickle_random(t->i_min, t->i_current);
+
+  VERBOSE_PRINTF("mcast6 trickle: Reset %p at %lu, End %lu,"
+                 " New Interval %lu\n", t, (unsigned long)t->t_start,
+                 (unsigned long)t->t_end, (unsigned long)t->t_next);
+
+  ctimer_set(&t->ct, t->t_next, handle_timer, (void *)t);
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_mcast6_trickle_inconsistency(struct uip_mcast6_trickle *t)
+{
+  if(t->e > 0 || ctimer_expired(&t->ct)) {
+    uip_mcast6_trickle_reset(t);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Packet Arena */
+/*---------------------------------------------------------------------------*/
+/* Members of the descriptor d, at the offsets the engine gave us */
+#define DESC(a, i)       ((uint8_t *)(a)->descs + (i) * (a)->desc_size)
+#define DESC_NEXT(d)     (*(void **)(d))
+#define DESC_BUFF(a, d)  (*(uint8_t **)((uint8_t *)(d) + (a)->buff_offset))
+#define DESC_LEN(a, d)   (*(uint16_t *)((uint8_t *)(d) + (a)->len_offset))
+/*---------------------------------------------------------------------------*/
+void
+uip_mcast6_arena_init(struct uip_mcast6_arena *a, uint8_t (*reclaim)(void),
+                      UIP_MCAST6_STATS_DATATYPE *max)
+{
+  int i;
+
+  memset(a->descs, 0, a->desc_num * a->desc_size);
+  a->free = NULL;
+  a->used = 0;
+  a->reclaim = reclaim;
+  a->max = max;
+
+  /* The first descriptor ends up at the head of the free list */
+  for(i = a->desc_num - 1; i >= 0; i--) {
+    DESC_NEXT(DESC(a, i)) = a->free;
+    a->free = DESC(a, i);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Give d's arena space back, compacting the datagrams stored above it */
+static void
+arena_release(struct uip_mcast6_arena *a, void *d)
+{
+  uint8_t *buff = DESC_BUFF(a, d);
+  uint16_t len = UIP_MCAST6_ARENA_ALIGN(DESC_LEN(a, d));
+  uint8_t *end = (uint8_t *)a->mem + a->used;
+  uint8_t i;
+
+  memmove(buff, buff + len, end - (buff + len));
+  a->used -= len;
+
+  /* Free descriptors have a NULL buff */
+  for(i = 0; i < a->desc_num; i++) {
+    if(DESC_BUFF(a, DESC(a, i)) > buff) {
+      DESC_BUFF(a, DESC(a, i)) -= len;
+    }
+  }
+  DESC_BUFF(a, d) = NULL;
+}
+/*---------------------------------------------------------------------------*/
+void *
+uip_mcast6_arena_alloc(struct uip_mcast6_arena *a, uint16_t len)
+{
+  void *d;
+  uint16_t aligned = UIP_MCAST6_ARENA_ALIGN(len);
+
+  if(aligned > a->size) {
+    return NULL;
+  }
+
+  while(a->free == NULL || a->used + aligned > a->size) {
+    PRINTF("mcast6 arena: Buffer allocation failed, reclaiming\n");
+    if(!a->reclaim()) {
+      return NULL;
+    }
+  }
+
+  d = a->free;
+  a->free = DESC_NEXT(d);
+
+  memset(d, 0, a->desc_size);
+  DESC_BUFF(a, d) = (uint8_t *)a->mem + a->used;
+  DESC_LEN(a, d) = len;
+  a->used += aligned;
+  if(a->max != NULL && a->used > *a->max) {
+    *a->max = a->used;
+  }
+
+  return d;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_mcast6_arena_free(struct uip_mcast6_arena *a, void *d)
+{
+  if(DESC_BUFF(a, d) != NULL) {
+    arena_release(a, d);
+  }
+  DESC_NEXT(d) = a->free;
+  a->free = d;
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
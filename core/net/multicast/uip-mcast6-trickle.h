@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2026, The Contiki Project
+ * Portions copyright (c) 2010, Loughborough University - Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * \addtogroup uip6-multicast
+ * @{
+ */
+/**
+ * \file
+ *    Header file for the parts ROLL TM and MPL share: Trickle timers
+ *    (RFC 6206), sequence value comparisons (RFC 1982) and the packet arena
+ *    which holds buffered datagrams
+ *
+ * \author
+ *    The Contiki Project
+ */
+#ifndef UIP_MCAST6_TRICKLE_H_
+#define UIP_MCAST6_TRICKLE_H_
+
+#include "contiki.h"
+#include "net/ipv6/multicast/uip-mcast6-stats.h"
+
+#include <stddef.h>
+#include <stdint.h>
+/*---------------------------------------------------------------------------*/
+/** \name Trickle Timers */
+/** @{ */
+
+/** \brief A Trickle timer. Engines embed it first in their own timer */
+struct uip_mcast6_trickle {
+  clock_time_t i_min;   /**< Clock ticks */
+  clock_time_t t_start; /**< Start of the interval (absolute clock_time) */
+  clock_time_t t_end;   /**< End of the interval (absolute clock_time) */
+  clock_time_t t_next;  /**< Clock ticks, randomised in [I/2, I) */
+  struct ctimer ct;
+
+  /** Called at t_next of every interval, to transmit */
+  void (*periodic)(struct uip_mcast6_trickle *t);
+
+  /**
+   * Called at the end of every interval, before it doubles. Returns 0 to
+   * stop the timer until the next reset. NULL: Never stop
+   */
+  uint8_t (*interval_end)(struct uip_mcast6_trickle *t);
+  uint8_t i_current;    /**< Current doublings from i_min */
+  uint8_t i_max;        /**< Max number of doublings */
+  uint8_t k;            /**< Redundancy Constant */
+  uint8_t c;            /**< Consistency Counter. Engines clear it */
+  uint8_t e;            /**< Intervals since the last reset */
+};
+
+/**
+ * \brief Length of an interval of a timer with Imin m, doubled d times
+ * Careful of overflows
+ */
+#define UIP_MCAST6_TRICKLE_TIME(m, d) ((clock_time_t)((m) << (d)))
+
+/**
+ * \brief A random number of ticks in [I/2, I), for a timer with Imin
+ *        i_min when doubled d times
+ */
+clock_time_t uip_mcast6_trickle_random(clock_time_t i_min, uint8_t d);
+
+/**
+ * \brief Start a new interval at Imin
+ * \param t A timer with i_min, i_max, k and periodic set
+ */
+void uip_mcast6_trickle_reset(struct uip_mcast6_trickle *t);
+
+/**
+ * \brief We heard something inconsistent. As per RFC 6206, only reset if
+ *        the timer is past its first interval or has stopped
+ */
+void uip_mcast6_trickle_inconsistency(struct uip_mcast6_trickle *t);
+/** @} */
+/*---------------------------------------------------------------------------*/
+/** \name Sequence Values and Serial Number Arithmetic
+ *
+ * Sequence Number Comparisons as per RFC1982 "Serial Number Arithmetic", for
+ * a 'SERIAL_BITS' value of b
+ *
+ * NOTE: There can be pairs of sequence numbers s1 and s2 with an undefined
+ * ordering, at a distance of exactly 2 ^ (b - 1). All three comparisons
+ * evaluate as 0 for those. This is not a bug of this implementation, it's
+ * an RFC design choice
+ */
+/** @{ */
+#define UIP_MCAST6_SEQ_MASK(b) ((1UL << (b)) - 1)
+
+/** \brief s1 is said to be equal s2 iif UIP_MCAST6_SEQ_IS_EQ(s1, s2) == 1 */
+#define UIP_MCAST6_SEQ_IS_EQ(i1, i2) ((i1) == (i2))
+
+/** \brief s1 is said to be less than s2 iif UIP_MCAST6_SEQ_IS_LT() == 1 */
+#define UIP_MCAST6_SEQ_IS_LT(i1, i2, b) \
+  (((i1) != (i2)) && \
+   ((((i2) - (i1)) & UIP_MCAST6_SEQ_MASK(b)) < (1UL << ((b) - 1))))
+
+/** \brief s1 is said to be greater than s2 iif UIP_MCAST6_SEQ_IS_GT() == 1 */
+#define UIP_MCAST6_SEQ_IS_GT(i1, i2, b) UIP_MCAST6_SEQ_IS_LT(i2, i1, b)
+
+/** \brief (s + n) modulo (2 ^ b) */
+#define UIP_MCAST6_SEQ_ADD(s, n, b) (((s) + (n)) & UIP_MCAST6_SEQ_MASK(b))
+
+/** \brief Distance from base up to s: (s - base) modulo (2 ^ b) */
+#define UIP_MCAST6_SEQ_OFFSET(s, base, b) \
+  (((s) - (base)) & UIP_MCAST6_SEQ_MASK(b))
+/** @} */
+/*---------------------------------------------------------------------------*/
+/** \name Packet Arena */
+/** @{ */
+
+/**
+ * \brief Buffered datagrams, stored back to back from the start of the
+ *        arena in no particular order. Freeing one slides everything above
+ *        it down, so the free space is always a single block at the end
+ *
+ * Each datagram has an engine descriptor. Descriptors must start with their
+ * next pointer, as for list.h, and have a uint8_t *buff and a uint16_t
+ * buff_len. Free ones are chained through next. Declare with
+ * UIP_MCAST6_ARENA()
+ */
+struct uip_mcast6_arena {
+  uint32_t *mem;
+  void *descs;
+  void *free;           /**< Free descriptors */
+  uint16_t size;        /**< Bytes in mem */
+  uint16_t used;        /**< Bytes stored, from the start of mem */
+  uint16_t desc_size;
+  uint8_t desc_num;
+  uint8_t buff_offset;  /**< Of buff, within a descriptor */
+  uint8_t len_offset;   /**< Of buff_len, within a descriptor */
+
+  /** Free some datagram(s) to make room. Returns 0 if nothing could go */
+  uint8_t (*reclaim)(void);
+
+  /** High-water mark of used, if not NULL */
+  UIP_MCAST6_STATS_DATATYPE *max;
+};
+
+/** Arena space taken by a datagram of length l */
+#define UIP_MCAST6_ARENA_ALIGN(l) (((l) + 3) & ~3)
+
+/**
+ * Declare an arena called name, of bytes bytes, for the array of
+ * descriptors descs_array, each of the given type
+ */
+#define UIP_MCAST6_ARENA(name, bytes, type, descs_array) \
+  static uint32_t name##_mem[UIP_MCAST6_ARENA_ALIGN(bytes) / 4]; \
+  static struct uip_mcast6_arena name = { \
+    .mem = name##_mem, \
+    .descs = descs_array, \
+    .size = sizeof(name##_mem), \
+    .desc_size = sizeof(type), \
+    .desc_num = sizeof(descs_array) / sizeof(type), \
+    .buff_offset = offsetof(type, buff), \
+    .len_offset = offsetof(type, buff_len), \
+  }
+
+/**
+ * \brief Empty an arena. All descriptors are zeroed and free
+ * \param a The arena
+ * \param reclaim Called when out of descriptors or space
+ * \param max The engine's high-water mark counter, or NULL
+ */
+void uip_mcast6_arena_init(struct uip_mcast6_arena *a,
+                           uint8_t (*reclaim)(void),
+                           UIP_MCAST6_STATS_DATATYPE *max);
+
+/**
+ * \brief Get a descriptor and len bytes of arena space, reclaiming until
+ *        both are available
+ * \return A zeroed descriptor with buff and buff_len set, or NULL
+ */
+void *uip_mcast6_arena_alloc(struct uip_mcast6_arena *a, uint16_t len);
+
+/**
+ * \brief Give a descriptor's arena space back and return it to the free
+ *        list. The engine must have unlinked it already
+ */
+void uip_mcast6_arena_free(struct uip_mcast6_arena *a, void *desc);
+/** @} */
+
+#endif /* UIP_MCAST6_TRICKLE_H_ */
+/** @} */
@@ -36,13 +36,15 @@
 /**
  * \defgroup uip6-multicast IPv6 Multicast Forwarding
  *
- *   We currently support 2 engines:
+ *   We currently support 4 engines:
  *   - 'Stateless Multicast RPL Forwarding' (SMRF)
  *     RPL does group management as per the RPL docs, SMRF handles datagram
  *     forwarding
  *   - 'Multicast Forwarding with Trickle' according to the algorithm described
  *     in the internet draft:
  *     http://tools.ietf.org/html/draft-ietf-roll-trickle-mcast
+ *   - 'Enhanced Stateless Multicast RPL Forwarding' (ESMRF)
+ *   - 'Multicast Protocol for Low-Power and Lossy Networks' (MPL), RFC 7731
  *
  * @{
  */
@@ -62,9 +64,11 @@
 #include "contiki-conf.h"
 #include "net/ipv6/multicast/uip-mcast6-engines.h"
 #include "net/ipv6/multicast/uip-mcast6-route.h"
+#include "net/ipv6/multicast/uip-mcast6-stats.h"
 #include "net/ipv6/multicast/smrf.h"
 #include "net/ipv6/multicast/esmrf.h"
 #include "net/ipv6/multicast/roll-tm.h"
+#include "net/ipv6/multicast/mpl.h"
 
 #include <string.h>
 /*---------------------------------------------------------------------------*/
@@ -136,6 +140,19 @@ struct uip_mcast6_driver {
    *        stack.
    */
   uint8_t (* in)(void);
+
+  /**
+   * \brief Describe the engine's stats extension
+   * \param n Set to the number of entries returned
+   * \return Descriptors of the counters in the struct which the engine
+   *         passed to UIP_MCAST6_STATS_INIT(), or NULL if there are none
+   *
+   *        Read the counters with uip_mcast6_stats_value(), passing it
+   *        uip_mcast6_stats.engine_stats. This lets generic code dump and
+   *        diff any engine's stats. When stats are off, this returns NULL
+   *        and sets *n to 0
+   */
+  const struct uip_mcast6_stats_desc *(* stats)(uint8_t *n);
 };
 /*---------------------------------------------------------------------------*/
 /**
@@ -160,6 +177,7 @@ struct uip_mcast6_driver {
 #define RPL_WITH_MULTICAST     1
 
 #define UIP_MCAST6             smrf_driver
+#define UIP_MCAST6_PARENT_SWITCH smrf_parent_switch
 
 #elif UIP_MCAST6_ENGINE == UIP_MCAST6_ENGINE_ESMRF
 
@@ -167,6 +185,12 @@ struct uip_mcast6_driver {
 
 #define RPL_WITH_MULTICAST     1
 #define UIP_MCAST6             esmrf_driver
+#define UIP_MCAST6_PARENT_SWITCH esmrf_parent_switch
+
+#elif UIP_MCAST6_ENGINE == UIP_MCAST6_ENGINE_MPL
+#define RPL_WITH_MULTICAST     0        /* Not used by MPL */
+
+#define UIP_MCAST6             mpl_driver
 
 #else
 #error "Multicast Enabled with an Unknown Engine."
@@ -175,6 +199,16 @@ struct uip_mcast6_driver {
 #endif /* UIP_MCAST6_ENGINE */
 
 extern const struct uip_mcast6_driver UIP_MCAST6;
+
+/*
+ * Engines which only accept datagrams from their preferred parent cache its
+ * address and need to hear about parent switches. If the project has taken
+ * the callback, it should call UIP_MCAST6_PARENT_SWITCH from its own. If it
+ * doesn't, the engine still recovers, see smrf_parent_switch()
+ */
+#if defined(UIP_MCAST6_PARENT_SWITCH) && !defined(RPL_CALLBACK_PARENT_SWITCH)
+#define RPL_CALLBACK_PARENT_SWITCH UIP_MCAST6_PARENT_SWITCH
+#endif
 /*---------------------------------------------------------------------------*/
 /* Configuration Checks */
 /*---------------------------------------------------------------------------*/
@@ -0,0 +1,229 @@
+/*
+ * Contiki's list, memb and crc16 libraries, as used by the engines
+ */
+#include "lib/crc16.h"
+#include "lib/list.h"
+#include "lib/memb.h"
+
+#include <stddef.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+struct list {
+  struct list *next;
+};
+/*---------------------------------------------------------------------------*/
+void
+list_init(list_t list)
+{
+  *list = NULL;
+}
+/*---------------------------------------------------------------------------*/
+void *
+list_head(list_t list)
+{
+  return *list;
+}
+/*---------------------------------------------------------------------------*/
+void *
+list_tail(list_t list)
+{
+  struct list *l;
+
+  if(*list == NULL) {
+    return NULL;
+  }
+  for(l = *list; l->next != NULL; l = l->next);
+  return l;
+}
+/*---------------------------------------------------------------------------*/
+void
+list_remove(list_t list, void *item)
+{
+  struct list *l;
+  struct list *r;
+
+  r = NULL;
+  for(l = *list; l != NULL; l = l->next) {
+    if(l == item) {
+      if(r == NULL) {
+        *list = l->next;
+      } else {
+        r->next = l->next;
+      }
+      l->next = NULL;
+      return;
+    }
+    r = l;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+list_add(list_t list, void *item)
+{
+  struct list *l;
+
+  /* Make sure not to add the same element twice */
+  list_remove(list, item);
+  ((struct list *)item)->next = NULL;
+
+  l = list_tail(list);
+  if(l == NULL) {
+    *list = item;
+  } else {
+    l->next = item;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+list_push(list_t list, void *item)
+{
+  list_remove(list, item);
+  ((struct list *)item)->next = *list;
+  *list = item;
+}
+/*---------------------------------------------------------------------------*/
+void *
+list_pop(list_t list)
+{
+  struct list *l;
+
+  l = *list;
+  if(l != NULL) {
+    list_remove(list, l);
+  }
+  return l;
+}
+/*---------------------------------------------------------------------------*/
+void *
+list_chop(list_t list)
+{
+  void *t;
+
+  t = list_tail(list);
+  if(t != NULL) {
+    list_remove(list, t);
+  }
+  return t;
+}
+/*---------------------------------------------------------------------------*/
+int
+list_length(list_t list)
+{
+  struct list *l;
+  int n;
+
+  n = 0;
+  for(l = *list; l != NULL; l = l->next) {
+    n++;
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+void
+list_copy(list_t dest, list_t src)
+{
+  *dest = *src;
+}
+/*---------------------------------------------------------------------------*/
+void
+list_insert(list_t list, void *previtem, void *newitem)
+{
+  if(previtem == NULL) {
+    list_push(list, newitem);
+  } else {
+    ((struct list *)newitem)->next = ((struct list *)previtem)->next;
+    ((struct list *)previtem)->next = newitem;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void *
+list_item_next(void *item)
+{
+  return item == NULL ? NULL : ((struct list *)item)->next;
+}
+/*---------------------------------------------------------------------------*/
+void
+memb_init(struct memb *m)
+{
+  memset(m->count, 0, m->num);
+  memset(m->mem, 0, m->size * m->num);
+}
+/*---------------------------------------------------------------------------*/
+void *
+memb_alloc(struct memb *m)
+{
+  int i;
+
+  for(i = 0; i < m->num; i++) {
+    if(m->count[i] == 0) {
+      m->count[i]++;
+      return (char *)m->mem + (i * m->size);
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+char
+memb_free(struct memb *m, void *ptr)
+{
+  int i;
+  char *p;
+
+  p = m->mem;
+  for(i = 0; i < m->num; i++) {
+    if(p == (char *)ptr) {
+      if(m->count[i] > 0) {
+        m->count[i]--;
+      }
+      return m->count[i];
+    }
+    p += m->size;
+  }
+  return -1;
+}
+/*---------------------------------------------------------------------------*/
+int
+memb_inmemb(struct memb *m, void *ptr)
+{
+  return (char *)ptr >= (char *)m->mem &&
+         (char *)ptr < (char *)m->mem + (m->num * m->size);
+}
+/*---------------------------------------------------------------------------*/
+int
+memb_numfree(struct memb *m)
+{
+  int i;
+  int n;
+
+  n = 0;
+  for(i = 0; i < m->num; i++) {
+    if(m->count[i] == 0) {
+      n++;
+    }
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+unsigned short
+crc16_add(unsigned char b, unsigned short acc)
+{
+  acc ^= b;
+  acc = (acc >> 8) | (acc << 8);
+  acc ^= (acc & 0xff00) << 4;
+  acc ^= (acc >> 8) >> 4;
+  acc ^= (acc & 0xff00) >> 5;
+  return acc;
+}
+/*---------------------------------------------------------------------------*/
+unsigned short
+crc16_data(const unsigned char *data, int len, unsigned short acc)
+{
+  int i;
+
+  for(i = 0; i < len; ++i) {
+    acc = crc16_add(*data, acc);
+    ++data;
+  }
+  return acc;
+}
+/*---------------------------------------------------------------------------*/
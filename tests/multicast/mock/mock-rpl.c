@@ -0,0 +1,144 @@
+/*
+ * Mocked RPL and MAC layer: one DODAG in each of up to RPL_MAX_INSTANCES
+ * instances, the link-layer sender of the packet being processed and an
+ * RDC driver
+ */
+#include "mock.h"
+#include "net/netstack.h"
+#include "net/packetbuf.h"
+#include "net/rpl/rpl.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+unsigned short mock_channel_check_interval;
+
+static rpl_instance_t instances[RPL_MAX_INSTANCES];
+static linkaddr_t sender;
+
+/* Like RPL's neighbour table, each node has its own parent entry */
+#define MOCK_RPL_NODES 16
+static rpl_parent_t parents[MOCK_RPL_NODES];
+/*---------------------------------------------------------------------------*/
+void
+mock_rpl_init(void)
+{
+  mock_rpl_leave();
+  mock_set_sender(0);
+  mock_channel_check_interval = 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+mock_rpl_join_instance(uint8_t instance_id, uint8_t root, uint8_t parent_node)
+{
+  rpl_instance_t *instance;
+  rpl_dag_t *dag;
+  rpl_parent_t *parent;
+
+  instance = rpl_get_instance(instance_id);
+  if(instance == NULL) {
+    for(instance = instances; instance->used; instance++) {
+      if(instance == &instances[RPL_MAX_INSTANCES - 1]) {
+        printf("mock_rpl_join_instance: Out of instances\n");
+        exit(2);
+      }
+    }
+  }
+  memset(instance, 0, sizeof(*instance));
+
+  dag = &instance->dag_table[0];
+  instance->instance_id = instance_id;
+  instance->used = 1;
+  instance->mop = 3;
+  instance->current_dag = dag;
+
+  mock_addr(&dag->dag_id, 0xaaaa, root);
+  dag->used = 1;
+  dag->joined = 1;
+  dag->grounded = 1;
+  dag->instance = instance;
+
+  if(parent_node == 0) {
+    dag->rank = ROOT_RANK(instance);
+    dag->preferred_parent = NULL;
+  } else {
+    parent = &parents[parent_node % MOCK_RPL_NODES];
+    mock_addr(&parent->addr, 0xfe80, parent_node);
+    parent->dag = dag;
+    parent->rank = ROOT_RANK(instance);
+    dag->rank = 2 * ROOT_RANK(instance);
+    dag->preferred_parent = parent;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+mock_rpl_join(uint8_t root, uint8_t parent_node)
+{
+  mock_rpl_leave();
+  mock_rpl_join_instance(MOCK_RPL_INSTANCE_ID, root, parent_node);
+}
+/*---------------------------------------------------------------------------*/
+void
+mock_rpl_leave(void)
+{
+  memset(instances, 0, sizeof(instances));
+  memset(parents, 0, sizeof(parents));
+}
+/*---------------------------------------------------------------------------*/
+rpl_dag_t *
+rpl_get_any_dag(void)
+{
+  int i;
+
+  for(i = 0; i < RPL_MAX_INSTANCES; i++) {
+    if(instances[i].used) {
+      return instances[i].current_dag;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+rpl_instance_t *
+rpl_get_instance(uint8_t instance_id)
+{
+  int i;
+
+  for(i = 0; i < RPL_MAX_INSTANCES; i++) {
+    if(instances[i].used && instances[i].instance_id == instance_id) {
+      return &instances[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+uip_ipaddr_t *
+rpl_get_parent_ipaddr(rpl_parent_t *p)
+{
+  return p == NULL ? NULL : &p->addr;
+}
+/*---------------------------------------------------------------------------*/
+void
+mock_set_sender(uint8_t node)
+{
+  memset(&sender, 0, sizeof(sender));
+  sender.u8[sizeof(sender.u8) - 1] = node;
+}
+/*---------------------------------------------------------------------------*/
+const linkaddr_t *
+packetbuf_addr(uint8_t type)
+{
+  return &sender;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned short
+channel_check_interval(void)
+{
+  return mock_channel_check_interval;
+}
+/*---------------------------------------------------------------------------*/
+const struct rdc_driver mock_rdc_driver = {
+  "mock",
+  channel_check_interval,
+};
+/*---------------------------------------------------------------------------*/
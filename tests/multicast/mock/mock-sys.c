@@ -0,0 +1,324 @@
+/*
+ * Mocked Contiki system services: a virtual clock with ctimers, etimers,
+ * rtimer and random, and a serial line. Also the test case, stats and
+ * benchmark helpers
+ */
+#include "mock.h"
+#include "sys/ctimer.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+/*---------------------------------------------------------------------------*/
+/* The engine's name, and the Makefile's configuration name for variants */
+#ifdef MOCK_CONFIG
+#define ENGINE "%s (" MOCK_CONFIG ")"
+#else
+#define ENGINE "%s"
+#endif
+
+/* More than any engine needs. ctimer_set() complains if we run out */
+#define MOCK_CTIMERS 64
+/*---------------------------------------------------------------------------*/
+clock_time_t mock_now;
+int mock_failed;
+struct mock_serial mock_serial;
+
+static struct ctimer *ctimers[MOCK_CTIMERS];
+static unsigned long rand_state;
+static int tests;
+static int tests_failed;
+/*---------------------------------------------------------------------------*/
+void
+mock_init(void)
+{
+  mock_now = 0;
+  memset(ctimers, 0, sizeof(ctimers));
+  memset(&mock_serial, 0, sizeof(mock_serial));
+  random_init(1);
+  mock_uip_init();
+  mock_rpl_init();
+}
+/*---------------------------------------------------------------------------*/
+clock_time_t
+clock_time(void)
+{
+  return mock_now;
+}
+/*---------------------------------------------------------------------------*/
+unsigned long
+clock_seconds(void)
+{
+  return mock_now / CLOCK_SECOND;
+}
+/*---------------------------------------------------------------------------*/
+rtimer_clock_t
+rtimer_arch_now(void)
+{
+  return (rtimer_clock_t)(mock_now * (RTIMER_SECOND / CLOCK_SECOND));
+}
+/*---------------------------------------------------------------------------*/
+void
+random_init(unsigned short seed)
+{
+  rand_state = seed;
+}
+/*---------------------------------------------------------------------------*/
+unsigned short
+random_rand(void)
+{
+  rand_state = rand_state * 1103515245UL + 12345;
+  return (rand_state >> 16) & 0xFFFF;
+}
+/*---------------------------------------------------------------------------*/
+void
+ctimer_set(struct ctimer *c, clock_time_t t, void (*f)(void *), void *ptr)
+{
+  struct ctimer **slot;
+  struct ctimer **free_slot;
+
+  c->start = mock_now;
+  c->interval = t;
+  c->f = f;
+  c->ptr = ptr;
+  c->active = 1;
+
+  free_slot = NULL;
+  for(slot = ctimers; slot < &ctimers[MOCK_CTIMERS]; slot++) {
+    if(*slot == c) {
+      return;
+    }
+    if(*slot == NULL && free_slot == NULL) {
+      free_slot = slot;
+    }
+  }
+  if(free_slot == NULL) {
+    printf("ctimer_set: Out of slots, raise MOCK_CTIMERS\n");
+    exit(2);
+  }
+  *free_slot = c;
+}
+/*---------------------------------------------------------------------------*/
+void
+ctimer_reset(struct ctimer *c)
+{
+  c->start += c->interval;
+  c->active = 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+ctimer_restart(struct ctimer *c)
+{
+  c->start = mock_now;
+  c->active = 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+ctimer_stop(struct ctimer *c)
+{
+  c->active = 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+ctimer_expired(struct ctimer *c)
+{
+  return !c->active;
+}
+/*---------------------------------------------------------------------------*/
+void
+etimer_set(struct etimer *et, clock_time_t interval)
+{
+  et->start = mock_now;
+  et->interval = interval;
+}
+/*---------------------------------------------------------------------------*/
+void
+etimer_reset(struct etimer *et)
+{
+  et->start += et->interval;
+}
+/*---------------------------------------------------------------------------*/
+int
+etimer_expired(struct etimer *et)
+{
+  return mock_now - et->start >= et->interval;
+}
+/*---------------------------------------------------------------------------*/
+int
+mock_serial_writeb(unsigned char c)
+{
+  if(mock_serial.len == sizeof(mock_serial.buf)) {
+    printf("mock_serial_writeb: Out of room\n");
+    exit(2);
+  }
+  mock_serial.buf[mock_serial.len++] = c;
+  return c;
+}
+/*---------------------------------------------------------------------------*/
+int
+mock_serial_save(const char *path)
+{
+  FILE *f;
+  size_t n;
+
+  f = fopen(path, "wb");
+  if(f == NULL) {
+    return 0;
+  }
+  n = fwrite(mock_serial.buf, 1, mock_serial.len, f);
+  return fclose(f) == 0 && n == mock_serial.len;
+}
+/*---------------------------------------------------------------------------*/
+void
+mock_run(clock_time_t ticks)
+{
+  struct ctimer **slot;
+  struct ctimer *c;
+  clock_time_t end;
+  clock_time_t next;
+  int pending;
+
+  end = mock_now + ticks;
+  for(;;) {
+    /* Jump straight to the earliest deadline, if there is one before end */
+    pending = 0;
+    next = end;
+    for(slot = ctimers; slot < &ctimers[MOCK_CTIMERS]; slot++) {
+      c = *slot;
+      if(c != NULL && c->active && c->start + c->interval <= next) {
+        next = c->start + c->interval;
+        pending = 1;
+      }
+    }
+    if(!pending) {
+      break;
+    }
+    if(next > mock_now) {
+      mock_now = next;
+    }
+
+    /* Callbacks may set any timer, including their own */
+    for(slot = ctimers; slot < &ctimers[MOCK_CTIMERS]; slot++) {
+      c = *slot;
+      if(c != NULL && c->active && c->start + c->interval <= mock_now) {
+        c->active = 0;
+        /* Timers fire between packets, once uip_process() is done with it */
+        uip_clear_buf();
+        c->f(c->ptr);
+      }
+    }
+  }
+  mock_now = end;
+}
+/*---------------------------------------------------------------------------*/
+#if UIP_MCAST6_STATS
+static const struct uip_mcast6_stats_desc *
+stat_find(const struct uip_mcast6_stats_desc *d, uint8_t n, const char *name)
+{
+  for(; d != NULL && n > 0; d++, n--) {
+    if(strcmp(d->name, name) == 0) {
+      return d;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+uint32_t
+mock_stat(const char *name)
+{
+  const struct uip_mcast6_stats_desc *d;
+  uint8_t n;
+
+  d = uip_mcast6_stats_describe(&n);
+  d = stat_find(d, n, name);
+  if(d != NULL) {
+    return uip_mcast6_stats_value(&uip_mcast6_stats, d);
+  }
+  d = UIP_MCAST6.stats(&n);
+  d = stat_find(d, n, name);
+  if(d != NULL) {
+    return uip_mcast6_stats_value(uip_mcast6_stats.engine_stats, d);
+  }
+  printf("mock_stat: %s has no counter called %s\n", UIP_MCAST6.name, name);
+  exit(2);
+}
+#endif
+/*---------------------------------------------------------------------------*/
+#if UIP_MCAST6_STATS && UIP_MCAST6_STATS_LATENCY
+uint32_t
+mock_latency(uint8_t kind, clock_time_t ticks)
+{
+  uint8_t b;
+
+  /* Bucket b > 0 holds [2^(b-1), 2^b) */
+  b = 0;
+  while(b < UIP_MCAST6_LATENCY_BUCKETS - 1 && ticks >= (1UL << b)) {
+    b++;
+  }
+  return uip_mcast6_stats.latency[kind][b];
+}
+/*---------------------------------------------------------------------------*/
+uint32_t
+mock_latency_total(uint8_t kind)
+{
+  uint32_t total;
+  uint8_t b;
+
+  total = 0;
+  for(b = 0; b < UIP_MCAST6_LATENCY_BUCKETS; b++) {
+    total += uip_mcast6_stats.latency[kind][b];
+  }
+  return total;
+}
+#endif
+/*---------------------------------------------------------------------------*/
+void
+mock_test(const char *name, void (*fn)(void))
+{
+  int failed;
+
+  failed = mock_failed;
+  mock_init();
+  fn();
+  tests++;
+  if(mock_failed != failed) {
+    tests_failed++;
+    printf(ENGINE ": %s: FAILED\n", UIP_MCAST6.name, name);
+  } else {
+    printf(ENGINE ": %s: ok\n", UIP_MCAST6.name, name);
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+mock_report(void)
+{
+  printf(ENGINE ": %d/%d passed\n", UIP_MCAST6.name, tests - tests_failed,
+         tests);
+  return tests_failed ? 1 : 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+mock_bench(const char *name, void (*fn)(void), unsigned long n)
+{
+  struct timespec start;
+  struct timespec end;
+  unsigned long i;
+  double ns;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(i = 0; i < n; i++) {
+    fn();
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+  printf(ENGINE ": %s: %lu calls, %.1f ns/call\n", UIP_MCAST6.name, name, n,
+         ns / n);
+}
+/*---------------------------------------------------------------------------*/
+int
+mock_bench_mode(int argc, char **argv)
+{
+  return argc > 1 && strcmp(argv[1], "--bench") == 0;
+}
+/*---------------------------------------------------------------------------*/
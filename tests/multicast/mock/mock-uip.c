@@ -0,0 +1,393 @@
+/*
+ * Mocked uIP: the buffer, ds6, ICMPv6 dispatch, tcpip output and a little
+ * bit of uip_process()
+ */
+#include "mock.h"
+#include "net/ip/tcpip.h"
+#include "net/ip/udp-stub.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/uip-icmp6.h"
+
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#define UIP_IP_BUF  ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+#define UIP_UDP_BUF ((struct uip_udp_hdr *)&uip_buf[UIP_LLIPH_LEN])
+#define UIP_ICMP_BUF ((struct uip_icmp_hdr *)&uip_buf[uip_l2_l3_hdr_len])
+/*---------------------------------------------------------------------------*/
+uip_buf_t uip_aligned_buf;
+uint16_t uip_len;
+uint16_t uip_slen;
+uint8_t uip_ext_len;
+void *uip_appdata;
+uip_lladdr_t uip_lladdr;
+struct uip_udp_conn *uip_udp_conn;
+
+struct mock_out mock_out;
+void (*mock_output_tap)(void);
+int mock_delivered;
+int mock_member;
+
+static uip_ds6_addr_t link_local;
+static uip_ds6_addr_t global;
+static uip_ds6_maddr_t maddr;
+static uip_lladdr_t nbr_lladdr;
+static struct uip_udp_conn udp_conn;
+static uip_icmp6_input_handler_t *handlers;
+/*---------------------------------------------------------------------------*/
+void
+mock_uip_init(void)
+{
+  memset(&uip_aligned_buf, 0, sizeof(uip_aligned_buf));
+  uip_len = 0;
+  uip_slen = 0;
+  uip_ext_len = 0;
+  uip_udp_conn = NULL;
+  memset(&uip_lladdr, 0, sizeof(uip_lladdr));
+  uip_lladdr.addr[UIP_LLADDR_LEN - 1] = 1;
+
+  memset(&mock_out, 0, sizeof(mock_out));
+  mock_output_tap = NULL;
+  mock_delivered = 0;
+  mock_member = 1;
+
+  link_local.isused = 1;
+  link_local.state = ADDR_PREFERRED;
+  mock_addr(&link_local.ipaddr, 0xfe80, 1);
+  global.isused = 1;
+  global.state = ADDR_PREFERRED;
+  mock_addr(&global.ipaddr, 0xaaaa, 1);
+
+  /* Engines register their handler again from init() */
+  handlers = NULL;
+}
+/*---------------------------------------------------------------------------*/
+void
+mock_addr(uip_ipaddr_t *a, uint16_t prefix, uint8_t node)
+{
+  uip_ip6addr(a, prefix, 0, 0, 0, 0, 0, 0, node);
+}
+/*---------------------------------------------------------------------------*/
+void
+mock_ip(const uip_ipaddr_t *src, const uip_ipaddr_t *dst, uint8_t proto,
+        uint8_t ttl)
+{
+  memset(uip_buf, 0, UIP_IPH_LEN);
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->proto = proto;
+  UIP_IP_BUF->ttl = ttl;
+  uip_ipaddr_copy(&UIP_IP_BUF->srcipaddr, src);
+  uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, dst);
+  uip_len = UIP_IPH_LEN;
+  uip_ext_len = 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+mock_append(const void *data, uint16_t len)
+{
+  if(uip_len + len > UIP_BUFSIZE) {
+    printf("mock_append: %u + %u bytes don't fit\n", uip_len, len);
+    mock_failed++;
+    return;
+  }
+  memcpy(&uip_buf[uip_len], data, len);
+  uip_len += len;
+  UIP_IP_BUF->len[0] = (uip_len - UIP_IPH_LEN) >> 8;
+  UIP_IP_BUF->len[1] = (uip_len - UIP_IPH_LEN) & 0xff;
+}
+/*---------------------------------------------------------------------------*/
+/* Ones' complement sum, as in uip6.c */
+static uint16_t
+chksum(uint16_t sum, const uint8_t *data, uint16_t len)
+{
+  uint16_t t;
+
+  for(; len > 1; data += 2, len -= 2) {
+    t = (data[0] << 8) + data[1];
+    sum += t;
+    if(sum < t) {
+      sum++;
+    }
+  }
+  if(len == 1) {
+    t = data[0] << 8;
+    sum += t;
+    if(sum < t) {
+      sum++;
+    }
+  }
+  return sum;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * The duplicate filter tells datagrams apart by their UDP checksum, so it
+ * must be right. uip_udpchksum() can't do it here: uip_ext_len isn't set yet
+ */
+void
+mock_udp(const void *payload, uint16_t len)
+{
+  struct uip_udp_hdr *udp;
+  uint16_t udp_len;
+  uint16_t sum;
+
+  udp = (struct uip_udp_hdr *)&uip_buf[uip_len];
+  udp_len = UIP_UDPH_LEN + len;
+  if(uip_len + udp_len > UIP_BUFSIZE) {
+    printf("mock_udp: %u + %u bytes don't fit\n", uip_len, udp_len);
+    mock_failed++;
+    return;
+  }
+  udp->srcport = UIP_HTONS(MOCK_UDP_PORT);
+  udp->destport = UIP_HTONS(MOCK_UDP_PORT);
+  udp->udplen = UIP_HTONS(udp_len);
+  udp->udpchksum = 0;
+  uip_len += UIP_UDPH_LEN;
+  mock_append(payload, len);
+
+  /* Pseudo-header, then the UDP header and payload */
+  sum = udp_len + UIP_PROTO_UDP;
+  sum = chksum(sum, UIP_IP_BUF->srcipaddr.u8, 2 * sizeof(uip_ipaddr_t));
+  sum = chksum(sum, (uint8_t *)udp, udp_len);
+  sum = ~sum;
+  udp->udpchksum = UIP_HTONS(sum == 0 ? 0xffff : sum);
+}
+/*---------------------------------------------------------------------------*/
+void
+mock_icmp6_input(void)
+{
+  uip_icmp6_input_handler_t *h;
+
+  /* Like uip_process(), the handlers expect uip_ext_len to be set */
+  uip_ext_len = 0;
+  if(UIP_IP_BUF->proto == UIP_PROTO_HBHO) {
+    uip_ext_len = (uip_buf[UIP_IPH_LEN + 1] + 1) << 3;
+  }
+
+  for(h = handlers; h != NULL; h = h->next) {
+    if(h->type == UIP_ICMP_BUF->type &&
+       (h->icode == UIP_ICMP6_HANDLER_CODE_ANY ||
+        h->icode == UIP_ICMP_BUF->icode)) {
+      h->handler();
+      return;
+    }
+  }
+  printf("mock_icmp6_input: No handler for type %u\n", UIP_ICMP_BUF->type);
+  mock_failed++;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_icmp6_register_input_handler(uip_icmp6_input_handler_t *handler)
+{
+  uip_icmp6_input_handler_t *h;
+
+  for(h = handlers; h != NULL; h = h->next) {
+    if(h == handler) {
+      return;
+    }
+  }
+  handler->next = handlers;
+  handlers = handler;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+uip_htons(uint16_t val)
+{
+  return UIP_HTONS(val);
+}
+/*---------------------------------------------------------------------------*/
+uint32_t
+uip_htonl(uint32_t val)
+{
+  return UIP_HTONL(val);
+}
+/*---------------------------------------------------------------------------*/
+/* As in uip6.c, over the upper-layer header after any extension headers */
+static uint16_t
+upper_layer_chksum(uint8_t proto)
+{
+  uint16_t upper_layer_len;
+  uint16_t sum;
+
+  upper_layer_len = ((UIP_IP_BUF->len[0] << 8) + UIP_IP_BUF->len[1]) -
+    uip_ext_len;
+  sum = upper_layer_len + proto;
+  sum = chksum(sum, UIP_IP_BUF->srcipaddr.u8, 2 * sizeof(uip_ipaddr_t));
+  sum = chksum(sum, &uip_buf[UIP_LLIPH_LEN + uip_ext_len], upper_layer_len);
+  return sum == 0 ? 0xffff : UIP_HTONS(sum);
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+uip_icmp6chksum(void)
+{
+  return upper_layer_chksum(UIP_PROTO_ICMP6);
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+uip_udpchksum(void)
+{
+  return upper_layer_chksum(UIP_PROTO_UDP);
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+uip_ipchksum(void)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* esmrf.c brings its own */
+__attribute__((weak)) void
+uip_clear_buf(void)
+{
+  uip_len = 0;
+  uip_ext_len = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* As in uip6.c, this leaves the IPv6 Next Header alone */
+int
+remove_ext_hdr(void)
+{
+  if(uip_ext_len == 0) {
+    return 0;
+  }
+  memmove(&uip_buf[UIP_IPH_LEN], &uip_buf[UIP_IPH_LEN + uip_ext_len],
+          uip_len - UIP_IPH_LEN - uip_ext_len);
+  uip_len -= uip_ext_len;
+  UIP_IP_BUF->len[0] = (uip_len - UIP_IPH_LEN) >> 8;
+  UIP_IP_BUF->len[1] = (uip_len - UIP_IPH_LEN) & 0xff;
+  uip_ext_len = 0;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Whatever the engine sends, we keep a copy of */
+static void
+capture(void)
+{
+  mock_out.len = uip_len;
+  memcpy(mock_out.buf, uip_buf, uip_len);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+tcpip_output(const uip_lladdr_t *a)
+{
+  mock_out.count++;
+  capture();
+  mock_out.bcast_len = uip_len;
+  memcpy(mock_out.bcast_buf, uip_buf, uip_len);
+  if(mock_output_tap != NULL) {
+    mock_output_tap();
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+tcpip_ipv6_output(void)
+{
+  mock_out.ipv6_count++;
+  capture();
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_process(uint8_t flag)
+{
+  /*
+   * Only datagrams without extension headers get their UDP checksum checked.
+   * Like uip6.c, we accept a checksum of 0
+   */
+  if(flag == UIP_DATA) {
+    if(UIP_IP_BUF->proto == UIP_PROTO_UDP && UIP_UDP_BUF->udpchksum != 0 &&
+       uip_udpchksum() != 0xffff) {
+      printf("uip_process: Bad UDP checksum, dropped\n");
+      return;
+    }
+    mock_delivered++;
+    return;
+  }
+
+  if(flag == UIP_UDP_SEND_CONN && uip_udp_conn != NULL) {
+    memset(uip_buf, 0, UIP_IPUDPH_LEN);
+    UIP_IP_BUF->vtc = 0x60;
+    UIP_IP_BUF->proto = UIP_PROTO_UDP;
+    UIP_IP_BUF->ttl = uip_udp_conn->ttl;
+    uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, &uip_udp_conn->ripaddr);
+    uip_ds6_select_src(&UIP_IP_BUF->srcipaddr, &UIP_IP_BUF->destipaddr);
+    uip_len = UIP_IPUDPH_LEN + uip_slen;
+    UIP_IP_BUF->len[0] = (uip_len - UIP_IPH_LEN) >> 8;
+    UIP_IP_BUF->len[1] = (uip_len - UIP_IPH_LEN) & 0xff;
+    UIP_UDP_BUF->srcport = uip_udp_conn->lport;
+    UIP_UDP_BUF->destport = uip_udp_conn->rport;
+    UIP_UDP_BUF->udplen = UIP_HTONS(uip_len - UIP_IPH_LEN);
+    UIP_UDP_BUF->udpchksum = 0;
+#if UIP_UDP_CHECKSUMS
+    UIP_UDP_BUF->udpchksum = ~(uip_udpchksum());
+    if(UIP_UDP_BUF->udpchksum == 0) {
+      UIP_UDP_BUF->udpchksum = 0xffff;
+    }
+#endif
+    uip_slen = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+struct uip_udp_conn *
+udp_new(const uip_ipaddr_t *ripaddr, uint16_t port, void *appstate)
+{
+  memset(&udp_conn, 0, sizeof(udp_conn));
+  if(ripaddr != NULL) {
+    uip_ipaddr_copy(&udp_conn.ripaddr, ripaddr);
+  }
+  udp_conn.rport = port;
+  udp_conn.lport = UIP_HTONS(0xC001);
+  udp_conn.ttl = 64;
+  udp_conn.appstate = appstate;
+  return &udp_conn;
+}
+/*---------------------------------------------------------------------------*/
+uip_ds6_addr_t *
+uip_ds6_get_link_local(int8_t state)
+{
+  return &link_local;
+}
+/*---------------------------------------------------------------------------*/
+uip_ds6_addr_t *
+uip_ds6_get_global(int8_t state)
+{
+  return &global;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_select_src(uip_ipaddr_t *src, uip_ipaddr_t *dst)
+{
+  if(uip_is_addr_linklocal(dst) || uip_is_addr_mcast_non_routable(dst)) {
+    uip_ipaddr_copy(src, &link_local.ipaddr);
+  } else {
+    uip_ipaddr_copy(src, &global.ipaddr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+uip_ds6_maddr_t *
+uip_ds6_maddr_add(const uip_ipaddr_t *ipaddr)
+{
+  return &maddr;
+}
+/*---------------------------------------------------------------------------*/
+uip_ds6_maddr_t *
+uip_ds6_maddr_lookup(const uip_ipaddr_t *ipaddr)
+{
+  return mock_member ? &maddr : NULL;
+}
+/*---------------------------------------------------------------------------*/
+const uip_lladdr_t *
+uip_ds6_nbr_lladdr_from_ipaddr(const uip_ipaddr_t *ipaddr)
+{
+  if(ipaddr == NULL || !uip_is_addr_linklocal(ipaddr)) {
+    return NULL;
+  }
+  memset(&nbr_lladdr, 0, sizeof(nbr_lladdr));
+  nbr_lladdr.addr[UIP_LLADDR_LEN - 1] = ipaddr->u8[15];
+  return &nbr_lladdr;
+}
+/*---------------------------------------------------------------------------*/
+int
+uip_ds6_nbr_num(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,169 @@
+/*
+ * A mocked uIP core for running multicast engines on the host.
+ *
+ * The engine under test is linked as is. Everything it calls into (uip_buf,
+ * tcpip_output(), ctimers, clock_time(), RPL, ds6) lives in mock/ and is
+ * fully deterministic: time only moves when a test calls mock_run() and
+ * random_rand() restarts the same sequence on every mock_init().
+ *
+ * Our node is ::1 (fe80::1 and aaaa::1). Node n's link-layer address is
+ * 00:00:00:00:00:00:00:n.
+ */
+#ifndef MOCK_H_
+#define MOCK_H_
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+#include "net/ipv6/multicast/uip-mcast6.h"
+
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+/* Virtual time */
+/*---------------------------------------------------------------------------*/
+extern clock_time_t mock_now;
+
+/* Move time forward, firing ctimers at their deadlines as we go */
+void mock_run(clock_time_t ticks);
+
+/* Back to t=0 with no timers, no output, a fresh random sequence */
+void mock_init(void);
+
+/* The parts of mock_init() that live in mock-uip.c and mock-rpl.c */
+void mock_uip_init(void);
+void mock_rpl_init(void);
+/*---------------------------------------------------------------------------*/
+/* What the engine did */
+/*---------------------------------------------------------------------------*/
+struct mock_out {
+  int count;                    /* tcpip_output() calls (link-local bcast) */
+  int ipv6_count;               /* tcpip_ipv6_output() calls */
+  uint16_t len;                 /* Copy of the last datagram sent */
+  uint8_t buf[UIP_BUFSIZE];
+  uint16_t bcast_len;           /* Copy of the last one to tcpip_output() */
+  uint8_t bcast_buf[UIP_BUFSIZE];
+};
+extern struct mock_out mock_out;
+
+/*
+ * Called by tcpip_output() for every datagram, once it is in mock_out. For
+ * checking each of several datagrams sent in one go. mock_init() clears it
+ */
+extern void (*mock_output_tap)(void);
+
+/*
+ * uip_process(UIP_DATA) calls, i.e. datagrams handed to our own stack. Not
+ * counted if the UDP checksum is wrong
+ */
+extern int mock_delivered;
+
+/*
+ * The serial line: Bytes written with mock_serial_writeb(). Point a
+ * UIP_MCAST6_TELEMETRY_CONF_WRITEB at it. mock_init() clears it
+ */
+struct mock_serial {
+  uint16_t len;
+  uint8_t buf[512];
+};
+extern struct mock_serial mock_serial;
+
+int mock_serial_writeb(unsigned char c);
+
+/* Write everything on the serial line to a file. Returns 0 on failure */
+int mock_serial_save(const char *path);
+/*---------------------------------------------------------------------------*/
+/* The world around us */
+/*---------------------------------------------------------------------------*/
+/* Are we a member of every group? Default 1 */
+extern int mock_member;
+
+/* NETSTACK_RDC.channel_check_interval(). Default 0 */
+extern unsigned short mock_channel_check_interval;
+
+/* Join a DODAG rooted at aaaa::root via fe80::parent. parent 0: we're root */
+void mock_rpl_join(uint8_t root, uint8_t parent);
+
+/*
+ * The same in another instance, leaving the ones we're in alone. Parent
+ * entries are per node, so give each instance its own parent
+ */
+#define MOCK_RPL_INSTANCE_ID 0x1E
+void mock_rpl_join_instance(uint8_t instance_id, uint8_t root,
+                            uint8_t parent);
+void mock_rpl_leave(void);
+
+/* The link-layer sender of the next datagram */
+void mock_set_sender(uint8_t node);
+/*---------------------------------------------------------------------------*/
+/* Crafting input */
+/*---------------------------------------------------------------------------*/
+/* prefix::node, e.g. mock_addr(&a, 0xfe80, 2) is fe80::2 */
+void mock_addr(uip_ipaddr_t *a, uint16_t prefix, uint8_t node);
+
+/* Start a new datagram in uip_buf, an IPv6 header and nothing else */
+void mock_ip(const uip_ipaddr_t *src, const uip_ipaddr_t *dst, uint8_t proto,
+             uint8_t ttl);
+
+/* Append to the datagram in uip_buf and update the payload length */
+void mock_append(const void *data, uint16_t len);
+
+/* Append a UDP header, to port MOCK_UDP_PORT, and the payload */
+#define MOCK_UDP_PORT 3001
+void mock_udp(const void *payload, uint16_t len);
+
+/* Pass the datagram in uip_buf to the matching ICMPv6 input handler */
+void mock_icmp6_input(void);
+/*---------------------------------------------------------------------------*/
+/* Stats */
+/*---------------------------------------------------------------------------*/
+#if UIP_MCAST6_STATS
+/*
+ * Read a counter by name, core counters first and then the engine's, through
+ * the stats descriptors. Aborts the test if there is no such counter
+ */
+uint32_t mock_stat(const char *name);
+
+#define CHECK_STAT(name, v) CHECK(mock_stat(name) == (v))
+#else
+/* Built without stats: There is nothing to check */
+#define CHECK_STAT(name, v) do { } while(0)
+#endif
+
+#if UIP_MCAST6_STATS && UIP_MCAST6_STATS_LATENCY
+/*
+ * Latency histogram kind (UIP_MCAST6_LATENCY_FWD, _ON_BEHALF): The count in
+ * the bucket a latency of ticks goes into, and the count in all of them
+ */
+uint32_t mock_latency(uint8_t kind, clock_time_t ticks);
+uint32_t mock_latency_total(uint8_t kind);
+
+/* Exactly v datagrams recorded in kind, all of them in ticks' bucket */
+#define CHECK_LATENCY(kind, ticks, v) do { \
+  CHECK(mock_latency(kind, ticks) == (v)); \
+  CHECK(mock_latency_total(kind) == (v)); \
+} while(0)
+#endif
+/*---------------------------------------------------------------------------*/
+/* Checks and benchmarks */
+/*---------------------------------------------------------------------------*/
+extern int mock_failed;
+
+#define CHECK(c) do { \
+  if(!(c)) { \
+    printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #c); \
+    mock_failed++; \
+  } \
+} while(0)
+
+/* Run a test case: mock_init(), then fn(). Prints its name and outcome */
+void mock_test(const char *name, void (*fn)(void));
+
+/* Print a summary. The return value is main()'s exit status */
+int mock_report(void);
+
+/* Call fn() n times and print the wall clock time per call */
+void mock_bench(const char *name, void (*fn)(void), unsigned long n);
+
+/* Was the program started with --bench? */
+int mock_bench_mode(int argc, char **argv);
+/*---------------------------------------------------------------------------*/
+#endif /* MOCK_H_ */
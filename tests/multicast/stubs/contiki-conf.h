@@ -0,0 +1,40 @@
+/*
+ * Host test stubs: Just enough of the Contiki API for the multicast engines
+ * to build and run natively. See ../mock/mock.h for the test-facing side
+ */
+#ifndef CONTIKI_CONF_H_
+#define CONTIKI_CONF_H_
+
+#include <stdint.h>
+
+typedef unsigned long clock_time_t;
+typedef unsigned short rtimer_clock_t;
+
+#define CLOCK_CONF_SECOND        128
+#define UIP_CONF_BUFFER_SIZE     240
+#define UIP_CONF_IPV6_RPL        1
+#define UIP_CONF_IPV6_CHECKS     1
+#define UIP_CONF_ROUTER          1
+#define NETSTACK_CONF_WITH_IPV6  1
+
+/* Enough routes for groups that share a hash bucket */
+#define UIP_MCAST6_ROUTE_CONF_ROUTES 4
+
+/* Tests read counters. CFLAGS_EXTRA=-DUIP_MCAST6_CONF_STATS=0 builds without */
+#ifndef UIP_MCAST6_CONF_STATS
+#define UIP_MCAST6_CONF_STATS    1
+#endif
+
+/* Telemetry requires stats. Without, its test case checks nothing */
+#if !UIP_MCAST6_CONF_STATS
+#undef UIP_MCAST6_CONF_TELEMETRY
+#endif
+
+/* A serial line for UIP_MCAST6_TELEMETRY_CONF_WRITEB, in mock-sys.c */
+int mock_serial_writeb(unsigned char c);
+
+#ifdef PROJECT_CONF_H
+#include PROJECT_CONF_H
+#endif
+
+#endif /* CONTIKI_CONF_H_ */
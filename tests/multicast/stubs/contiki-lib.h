@@ -0,0 +1,8 @@
+#ifndef CONTIKI_LIB_H_
+#define CONTIKI_LIB_H_
+
+#include "lib/list.h"
+#include "lib/memb.h"
+#include "lib/random.h"
+
+#endif /* CONTIKI_LIB_H_ */
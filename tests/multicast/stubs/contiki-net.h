@@ -0,0 +1,12 @@
+#ifndef CONTIKI_NET_H_
+#define CONTIKI_NET_H_
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+#include "net/ip/tcpip.h"
+#include "net/ip/udp-stub.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/uip-icmp6.h"
+#include "net/packetbuf.h"
+
+#endif /* CONTIKI_NET_H_ */
@@ -0,0 +1,12 @@
+#ifndef CONTIKI_H_
+#define CONTIKI_H_
+
+#include "contiki-conf.h"
+#include "sys/clock.h"
+#include "sys/ctimer.h"
+#include "sys/etimer.h"
+#include "sys/process.h"
+#include "sys/rtimer.h"
+#include "lib/random.h"
+
+#endif /* CONTIKI_H_ */
@@ -0,0 +1,6 @@
+#ifndef WATCHDOG_H_
+#define WATCHDOG_H_
+
+static inline void watchdog_periodic(void) {}
+
+#endif /* WATCHDOG_H_ */
@@ -0,0 +1,9 @@
+#ifndef CRC16_H_
+#define CRC16_H_
+
+/* As in Contiki's lib/crc16.c, which mock-lib.c copies */
+unsigned short crc16_add(unsigned char b, unsigned short crc);
+unsigned short crc16_data(const unsigned char *data, int datalen,
+                          unsigned short crc);
+
+#endif /* CRC16_H_ */
@@ -0,0 +1,27 @@
+#ifndef MEMB_H_
+#define MEMB_H_
+
+#define CC_CONCAT2(s1, s2) s1##s2
+#define CC_CONCAT(s1, s2) CC_CONCAT2(s1, s2)
+
+#define MEMB(name, structure, num) \
+  static char CC_CONCAT(name, _memb_count)[num]; \
+  static structure CC_CONCAT(name, _memb_mem)[num]; \
+  static struct memb name = { sizeof(structure), num, \
+                              CC_CONCAT(name, _memb_count), \
+                              (void *)CC_CONCAT(name, _memb_mem) }
+
+struct memb {
+  unsigned short size;
+  unsigned short num;
+  char *count;
+  void *mem;
+};
+
+void memb_init(struct memb *m);
+void *memb_alloc(struct memb *m);
+char memb_free(struct memb *m, void *ptr);
+int memb_inmemb(struct memb *m, void *ptr);
+int memb_numfree(struct memb *m);
+
+#endif /* MEMB_H_ */
@@ -0,0 +1,10 @@
+#ifndef RANDOM_H_
+#define RANDOM_H_
+
+/* Deterministic: mock_init() always restarts the same sequence */
+unsigned short random_rand(void);
+void random_init(unsigned short seed);
+
+#define RANDOM_RAND_MAX 65535U
+
+#endif /* RANDOM_H_ */
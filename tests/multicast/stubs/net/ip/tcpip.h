@@ -0,0 +1,10 @@
+#ifndef TCPIP_H_
+#define TCPIP_H_
+
+#include "net/ip/uip.h"
+
+/* Both record what they send in mock_out */
+uint8_t tcpip_output(const uip_lladdr_t *a);
+void tcpip_ipv6_output(void);
+
+#endif /* TCPIP_H_ */
@@ -0,0 +1,10 @@
+#ifndef UDP_STUB_H_
+#define UDP_STUB_H_
+
+#include "net/ip/uip.h"
+
+struct uip_udp_conn *udp_new(const uip_ipaddr_t *ripaddr, uint16_t port,
+                             void *appstate);
+#define udp_bind(conn, port) (conn)->lport = port
+
+#endif /* UDP_STUB_H_ */
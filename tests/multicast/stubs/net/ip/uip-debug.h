@@ -0,0 +1,29 @@
+#ifndef UIP_DEBUG_H_
+#define UIP_DEBUG_H_
+
+#include "net/ip/uip.h"
+
+#include <stdio.h>
+
+void uip_debug_ipaddr_print(const uip_ipaddr_t *addr);
+void uip_debug_lladdr_print(const uip_lladdr_t *addr);
+
+#define DEBUG_NONE      0
+#define DEBUG_PRINT     1
+#define DEBUG_ANNOTATE  2
+#define DEBUG_FULL      DEBUG_ANNOTATE | DEBUG_PRINT
+#endif /* UIP_DEBUG_H_ */
+
+/* Like the real one, this part is evaluated on every inclusion */
+#undef PRINTF
+#undef PRINT6ADDR
+#undef PRINTLLADDR
+#if (DEBUG) & DEBUG_PRINT
+#define PRINTF(...) printf(__VA_ARGS__)
+#define PRINT6ADDR(addr) uip_debug_ipaddr_print(addr)
+#define PRINTLLADDR(lladdr) uip_debug_lladdr_print(lladdr)
+#else
+#define PRINTF(...)
+#define PRINT6ADDR(addr)
+#define PRINTLLADDR(lladdr)
+#endif
@@ -0,0 +1,191 @@
+#ifndef UIP_H_
+#define UIP_H_
+
+#include "contiki-conf.h"
+
+#include <stdint.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#ifdef UIP_CONF_BUFFER_SIZE
+#define UIP_BUFSIZE UIP_CONF_BUFFER_SIZE
+#else
+#define UIP_BUFSIZE 1280
+#endif
+
+#define UIP_LLH_LEN     0
+#define UIP_IPH_LEN     40
+#define UIP_UDPH_LEN    8
+#define UIP_ICMPH_LEN   4
+#define UIP_IPUDPH_LEN  (UIP_UDPH_LEN + UIP_IPH_LEN)
+#define UIP_IPICMPH_LEN (UIP_IPH_LEN + UIP_ICMPH_LEN)
+#define UIP_LLIPH_LEN   (UIP_LLH_LEN + UIP_IPH_LEN)
+
+#define UIP_PROTO_HBHO  0
+#define UIP_PROTO_UDP   17
+#define UIP_PROTO_ICMP6 58
+
+#ifdef UIP_CONF_UDP_CHECKSUMS
+#define UIP_UDP_CHECKSUMS (UIP_CONF_UDP_CHECKSUMS)
+#else
+#define UIP_UDP_CHECKSUMS (NETSTACK_CONF_WITH_IPV6)
+#endif
+
+#define UIP_EXT_HDR_OPT_PAD1 0
+#define UIP_EXT_HDR_OPT_PADN 1
+#define UIP_EXT_HDR_OPT_RPL  0x63
+
+/* uip_process() flags */
+#define UIP_DATA          1
+#define UIP_TIMER         2
+#define UIP_UDP_SEND_CONN 4
+/*---------------------------------------------------------------------------*/
+typedef union uip_ip6addr_t {
+  uint8_t u8[16];
+  uint16_t u16[8];
+} uip_ip6addr_t;
+typedef uip_ip6addr_t uip_ipaddr_t;
+
+#define UIP_LLADDR_LEN 8
+typedef struct uip_802154_longaddr {
+  uint8_t addr[UIP_LLADDR_LEN];
+} uip_802154_longaddr;
+typedef uip_802154_longaddr uip_lladdr_t;
+
+typedef union {
+  uint32_t u32[(UIP_BUFSIZE + 3) / 4];
+  uint8_t u8[UIP_BUFSIZE];
+} uip_buf_t;
+/*---------------------------------------------------------------------------*/
+struct uip_ip_hdr {
+  uint8_t vtc;
+  uint8_t tcflow;
+  uint16_t flow;
+  uint8_t len[2];
+  uint8_t proto, ttl;
+  uip_ip6addr_t srcipaddr, destipaddr;
+};
+
+struct uip_udp_hdr {
+  uint16_t srcport;
+  uint16_t destport;
+  uint16_t udplen;
+  uint16_t udpchksum;
+};
+
+struct uip_icmp_hdr {
+  uint8_t type, icode;
+  uint16_t icmpchksum;
+};
+
+struct uip_ext_hdr {
+  uint8_t next;
+  uint8_t len;
+};
+
+struct uip_hbho_hdr {
+  uint8_t next;
+  uint8_t len;
+};
+
+struct uip_ext_hdr_opt {
+  uint8_t type;
+  uint8_t len;
+};
+
+struct uip_ext_hdr_opt_padn {
+  uint8_t opt_type;
+  uint8_t opt_len;
+};
+
+struct uip_ext_hdr_opt_rpl {
+  uint8_t opt_type;
+  uint8_t opt_len;
+  uint8_t flags;
+  uint8_t instance;
+  uint16_t senderrank;
+};
+
+struct uip_udp_conn {
+  uip_ipaddr_t ripaddr;
+  uint16_t lport;
+  uint16_t rport;
+  uint8_t ttl;
+  void *appstate;
+};
+/*---------------------------------------------------------------------------*/
+extern uip_buf_t uip_aligned_buf;
+#define uip_buf (uip_aligned_buf.u8)
+
+extern uint16_t uip_len;
+extern uint16_t uip_slen;
+extern uint8_t uip_ext_len;
+extern void *uip_appdata;
+extern uip_lladdr_t uip_lladdr;
+extern struct uip_udp_conn *uip_udp_conn;
+
+#define uip_l2_l3_hdr_len (UIP_LLH_LEN + UIP_IPH_LEN + uip_ext_len)
+#define uip_l2_l3_icmp_hdr_len \
+  (UIP_LLH_LEN + UIP_IPH_LEN + uip_ext_len + UIP_ICMPH_LEN)
+#define uip_l3_hdr_len (UIP_IPH_LEN + uip_ext_len)
+/*---------------------------------------------------------------------------*/
+#define UIP_HTONS(n) \
+  (uint16_t)((((uint16_t)(n)) << 8) | (((uint16_t)(n)) >> 8))
+#define UIP_HTONL(n) \
+  (((uint32_t)UIP_HTONS(n) << 16) | UIP_HTONS((uint32_t)(n) >> 16))
+uint16_t uip_htons(uint16_t val);
+uint32_t uip_htonl(uint32_t val);
+#define uip_ntohs uip_htons
+#define uip_ntohl uip_htonl
+/*---------------------------------------------------------------------------*/
+#define uip_ipaddr_copy(dest, src) (*(dest) = *(src))
+#define uip_ip6addr_copy(dest, src) \
+  (*((uip_ip6addr_t *)dest) = *((uip_ip6addr_t *)src))
+#define uip_ipaddr_cmp(a, b) (memcmp(a, b, sizeof(uip_ip6addr_t)) == 0)
+#define uip_ip6addr_cmp(a, b) (memcmp(a, b, sizeof(uip_ip6addr_t)) == 0)
+
+#define uip_ip6addr(addr, a0, a1, a2, a3, a4, a5, a6, a7) do { \
+  (addr)->u16[0] = UIP_HTONS(a0); \
+  (addr)->u16[1] = UIP_HTONS(a1); \
+  (addr)->u16[2] = UIP_HTONS(a2); \
+  (addr)->u16[3] = UIP_HTONS(a3); \
+  (addr)->u16[4] = UIP_HTONS(a4); \
+  (addr)->u16[5] = UIP_HTONS(a5); \
+  (addr)->u16[6] = UIP_HTONS(a6); \
+  (addr)->u16[7] = UIP_HTONS(a7); \
+} while(0)
+
+#define uip_is_addr_unspecified(a) \
+  ((a)->u16[0] == 0 && (a)->u16[1] == 0 && (a)->u16[2] == 0 && \
+   (a)->u16[3] == 0 && (a)->u16[4] == 0 && (a)->u16[5] == 0 && \
+   (a)->u16[6] == 0 && (a)->u16[7] == 0)
+#define uip_is_addr_linklocal(a) ((a)->u8[0] == 0xfe && (a)->u8[1] == 0x80)
+#define uip_is_addr_mcast(a) ((a)->u8[0] == 0xFF)
+#define uip_is_addr_mcast_routable(a) \
+  ((a)->u8[0] == 0xFF && ((a)->u8[1] & 0x0F) > 0x02)
+#define uip_is_addr_mcast_non_routable(a) \
+  ((a)->u8[0] == 0xFF && ((a)->u8[1] & 0x0F) <= 0x02)
+
+#define uip_is_addr_linklocal_mcast(a, last) \
+  ((a)->u8[0] == 0xff && (a)->u8[1] == 0x02 && (a)->u16[1] == 0 && \
+   (a)->u16[2] == 0 && (a)->u16[3] == 0 && (a)->u16[4] == 0 && \
+   (a)->u16[5] == 0 && (a)->u16[6] == 0 && (a)->u8[14] == 0 && \
+   (a)->u8[15] == (last))
+#define uip_is_addr_linklocal_allnodes_mcast(a) \
+  uip_is_addr_linklocal_mcast(a, 0x01)
+#define uip_is_addr_linklocal_allrouters_mcast(a) \
+  uip_is_addr_linklocal_mcast(a, 0x02)
+#define uip_create_linklocal_allnodes_mcast(a) \
+  uip_ip6addr(a, 0xff02, 0, 0, 0, 0, 0, 0, 0x0001)
+#define uip_create_linklocal_allrouters_mcast(a) \
+  uip_ip6addr(a, 0xff02, 0, 0, 0, 0, 0, 0, 0x0002)
+/*---------------------------------------------------------------------------*/
+/* Checksums are not verified on the host, these return 0 */
+uint16_t uip_icmp6chksum(void);
+uint16_t uip_udpchksum(void);
+uint16_t uip_ipchksum(void);
+
+/* UIP_DATA: Count a local delivery. UIP_UDP_SEND_CONN: Build the datagram */
+void uip_process(uint8_t flag);
+void uip_clear_buf(void);
+/*---------------------------------------------------------------------------*/
+#endif /* UIP_H_ */
@@ -0,0 +1,38 @@
+#ifndef UIP_DS6_H_
+#define UIP_DS6_H_
+
+#include "net/ip/uip.h"
+
+#define ADDR_TENTATIVE  0
+#define ADDR_PREFERRED  1
+#define ADDR_DEPRECATED 2
+
+#define ADDR_ANYTYPE    0
+#define ADDR_AUTOCONF   1
+
+typedef struct uip_ds6_addr {
+  uint8_t isused;
+  uip_ipaddr_t ipaddr;
+  uint8_t state;
+  uint8_t type;
+} uip_ds6_addr_t;
+
+typedef struct uip_ds6_maddr {
+  uint8_t isused;
+  uip_ipaddr_t ipaddr;
+} uip_ds6_maddr_t;
+
+uip_ds6_addr_t *uip_ds6_get_link_local(int8_t state);
+uip_ds6_addr_t *uip_ds6_get_global(int8_t state);
+void uip_ds6_select_src(uip_ipaddr_t *src, uip_ipaddr_t *dst);
+
+/* Group membership follows mock_member */
+uip_ds6_maddr_t *uip_ds6_maddr_add(const uip_ipaddr_t *ipaddr);
+uip_ds6_maddr_t *uip_ds6_maddr_lookup(const uip_ipaddr_t *ipaddr);
+#define uip_ds6_is_my_maddr(addr) (uip_ds6_maddr_lookup(addr) != NULL)
+
+/* Every fe80::n is a neighbour, with LL address 00:..:00:n */
+const uip_lladdr_t *uip_ds6_nbr_lladdr_from_ipaddr(const uip_ipaddr_t *ip);
+int uip_ds6_nbr_num(void);
+
+#endif /* UIP_DS6_H_ */
@@ -0,0 +1,23 @@
+#ifndef ICMP6_H_
+#define ICMP6_H_
+
+#include "net/ip/uip.h"
+
+#define ICMP6_ROLL_TM 155
+
+typedef struct uip_icmp6_input_handler {
+  struct uip_icmp6_input_handler *next;
+  uint8_t type;
+  uint8_t icode;
+  void (*handler)(void);
+} uip_icmp6_input_handler_t;
+
+#define UIP_ICMP6_HANDLER_CODE_ANY 0xFF
+
+#define UIP_ICMP6_HANDLER(name, type, code, func) \
+  static uip_icmp6_input_handler_t name = { NULL, type, code, func }
+
+/* mock_icmp6_input() dispatches to these */
+void uip_icmp6_register_input_handler(uip_icmp6_input_handler_t *handler);
+
+#endif /* ICMP6_H_ */
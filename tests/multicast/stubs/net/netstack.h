@@ -0,0 +1,13 @@
+#ifndef NETSTACK_H_
+#define NETSTACK_H_
+
+struct rdc_driver {
+  char *name;
+  unsigned short (* channel_check_interval)(void);
+};
+
+/* Its channel check interval is mock_channel_check_interval */
+extern const struct rdc_driver mock_rdc_driver;
+#define NETSTACK_RDC mock_rdc_driver
+
+#endif /* NETSTACK_H_ */
@@ -0,0 +1,17 @@
+#ifndef PACKETBUF_H_
+#define PACKETBUF_H_
+
+#include <stdint.h>
+
+typedef union {
+  unsigned char u8[8];
+  uint16_t u16;
+} linkaddr_t;
+
+#define PACKETBUF_ADDR_SENDER   0
+#define PACKETBUF_ADDR_RECEIVER 1
+
+/* The sender is whoever mock_set_sender() says */
+const linkaddr_t *packetbuf_addr(uint8_t type);
+
+#endif /* PACKETBUF_H_ */
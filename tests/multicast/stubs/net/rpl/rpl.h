@@ -0,0 +1,49 @@
+#ifndef RPL_H_
+#define RPL_H_
+
+#include "net/ip/uip.h"
+
+typedef uint16_t rpl_rank_t;
+
+#define ROOT_RANK(instance)      256
+#define RPL_MAX_INSTANCES        2
+#define RPL_MAX_DAG_PER_INSTANCE 1
+
+struct rpl_instance;
+
+struct rpl_parent {
+  struct rpl_dag *dag;
+  rpl_rank_t rank;
+  uip_ipaddr_t addr;
+};
+typedef struct rpl_parent rpl_parent_t;
+
+struct rpl_dag {
+  uip_ipaddr_t dag_id;
+  rpl_rank_t min_rank;
+  uint8_t version;
+  uint8_t grounded;
+  uint8_t preference;
+  uint8_t used;
+  uint8_t joined;
+  rpl_parent_t *preferred_parent;
+  rpl_rank_t rank;
+  struct rpl_instance *instance;
+};
+typedef struct rpl_dag rpl_dag_t;
+
+struct rpl_instance {
+  rpl_dag_t dag_table[RPL_MAX_DAG_PER_INSTANCE];
+  rpl_dag_t *current_dag;
+  uint8_t instance_id;
+  uint8_t used;
+  uint8_t mop;
+};
+typedef struct rpl_instance rpl_instance_t;
+
+/* A single DODAG, set up with mock_rpl_join() */
+rpl_dag_t *rpl_get_any_dag(void);
+rpl_instance_t *rpl_get_instance(uint8_t instance_id);
+uip_ipaddr_t *rpl_get_parent_ipaddr(rpl_parent_t *p);
+
+#endif /* RPL_H_ */
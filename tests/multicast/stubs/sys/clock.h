@@ -0,0 +1,12 @@
+#ifndef CLOCK_H_
+#define CLOCK_H_
+
+#include "contiki-conf.h"
+
+#define CLOCK_SECOND CLOCK_CONF_SECOND
+
+/* Virtual time, advanced by mock_run() */
+clock_time_t clock_time(void);
+unsigned long clock_seconds(void);
+
+#endif /* CLOCK_H_ */
@@ -0,0 +1,22 @@
+#ifndef CTIMER_H_
+#define CTIMER_H_
+
+#include "sys/clock.h"
+
+struct ctimer {
+  clock_time_t start;
+  clock_time_t interval;
+  void (*f)(void *);
+  void *ptr;
+  int active;
+};
+
+/* Callbacks run from mock_run() */
+void ctimer_set(struct ctimer *c, clock_time_t t, void (*f)(void *),
+                void *ptr);
+void ctimer_reset(struct ctimer *c);
+void ctimer_restart(struct ctimer *c);
+void ctimer_stop(struct ctimer *c);
+int ctimer_expired(struct ctimer *c);
+
+#endif /* CTIMER_H_ */
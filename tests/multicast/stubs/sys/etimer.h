@@ -0,0 +1,16 @@
+#ifndef ETIMER_H_
+#define ETIMER_H_
+
+#include "sys/clock.h"
+
+/* Polled against virtual time. No events: Processes don't run in tests */
+struct etimer {
+  clock_time_t start;
+  clock_time_t interval;
+};
+
+void etimer_set(struct etimer *et, clock_time_t interval);
+void etimer_reset(struct etimer *et);
+int etimer_expired(struct etimer *et);
+
+#endif /* ETIMER_H_ */
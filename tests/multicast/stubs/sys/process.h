@@ -0,0 +1,48 @@
+#ifndef PROCESS_H_
+#define PROCESS_H_
+
+/*
+ * Enough of Contiki's processes for the multicast core's to build: A thread
+ * is a function with a switch-based local continuation, like lc-switch.h.
+ * Nothing starts or schedules them, tests call into their code directly
+ */
+typedef unsigned char process_event_t;
+typedef void *process_data_t;
+
+struct pt {
+  unsigned short lc;
+};
+
+struct process {
+  const char *name;
+  char (*thread)(struct pt *, process_event_t, process_data_t);
+  struct pt pt;
+};
+
+#define PT_YIELDED 1
+#define PT_ENDED   3
+
+#define PROCESS_NAME(name) extern struct process name
+
+#define PROCESS_THREAD(name, ev, data) \
+  static char process_thread_##name(struct pt *process_pt, \
+                                    process_event_t ev, process_data_t data)
+
+#define PROCESS(name, strname) \
+  PROCESS_THREAD(name, ev, data); \
+  struct process name = { strname, process_thread_##name, { 0 } }
+
+#define PROCESS_BEGIN() switch(process_pt->lc) { case 0:
+#define PROCESS_END() } process_pt->lc = 0; return PT_ENDED
+
+/* Yields at least once, like Contiki's */
+#define PROCESS_YIELD_UNTIL(c) do { \
+  process_pt->lc = __LINE__; \
+  return PT_YIELDED; \
+  case __LINE__: \
+  if(!(c)) { \
+    return PT_YIELDED; \
+  } \
+} while(0)
+
+#endif /* PROCESS_H_ */
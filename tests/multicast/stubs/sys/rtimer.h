@@ -0,0 +1,12 @@
+#ifndef RTIMER_H_
+#define RTIMER_H_
+
+#include "contiki-conf.h"
+
+#define RTIMER_SECOND 32768
+#define RTIMER_NOW() rtimer_arch_now()
+
+/* Follows the virtual clock */
+rtimer_clock_t rtimer_arch_now(void);
+
+#endif /* RTIMER_H_ */
@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+"""Decode the serial output of test-smrf-telemetry with the host collector.
+
+test_telemetry() in test-smrf.c writes some text, then a single telemetry
+record, to a file. This reads it back with
+tools/mcast6-telemetry/mcast6-telemetry.py: The text must be skipped, the
+record's CRC must check out, its layouts must match the descriptor tables
+in the sources and its varints must decode to the counters the test set.
+
+    ./telemetry-check.py build/smrf-telemetry.serial
+"""
+
+import importlib.util
+import os
+import sys
+
+TOOL = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                    "..", "..", "tools", "mcast6-telemetry",
+                    "mcast6-telemetry.py")
+
+# As set by test_telemetry()
+CORE = {
+    "mcast_in_unique": 0,
+    "mcast_in_all": 127,
+    "mcast_in_ours": 128,
+    "mcast_fwd": 300,
+    "mcast_out": 0xC0,
+    "mcast_bad": 0xDB,
+    "mcast_dropped": 0xFFFF,
+}
+ENGINE = {
+    "fwd_queue_full": 0,
+    "fwd_queue_max": 1,
+    "parent_refresh": 1,
+    "adapt_backoff": 0,
+}
+UPTIME = 200
+
+failed = 0
+
+
+def check(cond, what):
+    global failed
+    if not cond:
+        print("telemetry-check: %s" % what)
+        failed += 1
+
+
+def main():
+    spec = importlib.util.spec_from_file_location("mcast6_telemetry", TOOL)
+    tool = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(tool)
+
+    names_by_layout = tool.tables(tool.SRC_DIR)
+    with open(sys.argv[1], "rb") as f:
+        frames = list(tool.frames(f))
+
+    # The text before the record is a frame of its own, which doesn't decode
+    check(len(frames) == 2, "%u frames, expected 2" % len(frames))
+    try:
+        tool.decode(frames[0], names_by_layout)
+        check(False, "text decoded as a record")
+    except tool.DecodeError:
+        pass
+
+    rec = tool.decode(frames[-1], names_by_layout)
+    check("unknown_layouts" not in rec,
+          "layouts %s not in the sources" % rec.get("unknown_layouts"))
+    check(rec["engine"] == "smrf", "engine %s" % rec["engine"])
+    check(rec["seq"] == 0, "seq %u" % rec["seq"])
+    check(rec["uptime"] == UPTIME, "uptime %u" % rec["uptime"])
+    check(rec.get("core") == CORE, "core %s" % rec.get("core"))
+    check(rec.get("engine_stats") == ENGINE,
+          "engine_stats %s" % rec.get("engine_stats"))
+    if "latency" in rec:
+        fwd = rec["latency"]["fwd"]
+        check(fwd == list(range(len(fwd))), "latency fwd %s" % fwd)
+        check(not any(rec["latency"]["on_behalf"]), "latency on_behalf %s" %
+              rec["latency"]["on_behalf"])
+
+    # Any flipped bit fails the CRC
+    bad = bytearray(frames[-1])
+    bad[len(bad) // 2] ^= 0x10
+    try:
+        tool.decode(bytes(bad), names_by_layout)
+        check(False, "corrupted record decoded")
+    except tool.DecodeError:
+        pass
+
+    print("Telemetry: %s" % ("FAILED" if failed else "ok"))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
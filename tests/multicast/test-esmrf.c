@@ -0,0 +1,552 @@
+/*
+ * ESMRF. As a node with a preferred parent, fe80::2 in the DODAG rooted at
+ * aaaa::9, we relay datagrams down the tree and send our own datagrams up
+ * to the root on our behalf. As the root, we turn on-behalf messages back
+ * into multicast datagrams
+ */
+#include "mock.h"
+#include "net/ipv6/multicast/uip-mcast6-adapt.h"
+
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#define ROOT    9
+#define PARENT  2
+#define OTHER   3
+#define SENDER  5
+/*---------------------------------------------------------------------------*/
+static uip_ipaddr_t group;
+static uint32_t seq;
+static struct uip_udp_conn conn;
+
+/* On-behalf payloads: seq, then padding up to whatever length we need */
+static uint8_t payload[UIP_BUFSIZE];
+
+/* The largest payload an on-behalf message with a full header can carry */
+#define PAYLOAD_MAX (UIP_BUFSIZE - UIP_LLH_LEN - UIP_IPICMPH_LEN - 2 - 16)
+/*---------------------------------------------------------------------------*/
+/* A UDP datagram from the root to the group, as if it came from sender */
+static void
+datagram(uint8_t sender, uint8_t ttl)
+{
+  uip_ipaddr_t src;
+
+  mock_addr(&src, 0xaaaa, ROOT);
+  mock_ip(&src, &group, UIP_PROTO_UDP, ttl);
+  mock_udp(&seq, sizeof(seq));
+  mock_set_sender(sender);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * A datagram of our own, as uip_process() has it when it calls out(). The
+ * payload is seq, padded to len bytes
+ */
+static void
+datagram_ours(uint16_t len)
+{
+  uip_ipaddr_t src;
+
+  mock_addr(&src, 0xaaaa, 1);
+  mock_ip(&src, &group, UIP_PROTO_UDP, 64);
+  memcpy(payload, &seq, sizeof(seq));
+  mock_udp(payload, len);
+  uip_slen = len;
+  uip_udp_conn = &conn;
+}
+/*---------------------------------------------------------------------------*/
+/* An on-behalf message from aaaa::5, with a body of len bytes */
+static void
+icmp(uint8_t code, uint8_t ttl, uint16_t len)
+{
+  uip_ipaddr_t src;
+  uip_ipaddr_t dst;
+  uint8_t hdr[UIP_ICMPH_LEN] = { ICMP6_ESMRF };
+  uint8_t mob[2 + 16];
+
+  hdr[1] = code;
+  mock_addr(&src, 0xaaaa, SENDER);
+  mock_addr(&dst, 0xaaaa, 1);
+  mock_ip(&src, &dst, UIP_PROTO_ICMP6, ttl);
+  mock_append(hdr, sizeof(hdr));
+
+  mob[0] = MOCK_UDP_PORT >> 8;
+  mob[1] = MOCK_UDP_PORT & 0xFF;
+  memcpy(&mob[2], &group, sizeof(group));
+  if(len < sizeof(mob)) {
+    mock_append(mob, len);
+    return;
+  }
+  mock_append(mob, sizeof(mob));
+  memcpy(payload, &seq, sizeof(seq));
+  mock_append(payload, len - sizeof(mob));
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * The multicast datagram we sent last: To the group, with seq in it and a
+ * UDP checksum that downstream nodes can check and tell datagrams apart by
+ */
+static int
+out_is_datagram(const uip_ipaddr_t *src)
+{
+  struct uip_ip_hdr *ip;
+  struct uip_udp_hdr *udp;
+
+  ip = (struct uip_ip_hdr *)mock_out.buf;
+  udp = (struct uip_udp_hdr *)&mock_out.buf[UIP_IPH_LEN];
+  memcpy(uip_buf, mock_out.buf, mock_out.len);
+  uip_ext_len = 0;
+  return mock_out.len == UIP_IPUDPH_LEN + sizeof(seq) &&
+         udp->udpchksum != 0 && uip_udpchksum() == 0xffff &&
+         ip->proto == UIP_PROTO_UDP &&
+         uip_ipaddr_cmp(&ip->srcipaddr, src) &&
+         uip_ipaddr_cmp(&ip->destipaddr, &group) &&
+         udp->destport == UIP_HTONS(MOCK_UDP_PORT) &&
+         memcmp(&mock_out.buf[UIP_IPUDPH_LEN], &seq, sizeof(seq)) == 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+setup(void)
+{
+  uip_ip6addr(&group, 0xff1e, 0, 0, 0, 0, 0, 0x89, 0xabcd);
+  seq = 0;
+  memset(&conn, 0, sizeof(conn));
+  conn.rport = UIP_HTONS(MOCK_UDP_PORT);
+  mock_rpl_join(ROOT, PARENT);
+  UIP_MCAST6.init();
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_accept_from_parent(void)
+{
+  setup();
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  CHECK_STAT("mcast_in_unique", 1);
+  CHECK_STAT("mcast_in_ours", 1);
+
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  CHECK_STAT("mcast_in_all", 2);
+  CHECK_STAT("mcast_in_unique", 1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_drop(void)
+{
+  setup();
+  datagram(OTHER, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  datagram(PARENT, 1);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  CHECK_STAT("mcast_dropped", 2);
+  CHECK_STAT("mcast_in_all", 0);
+}
+/*---------------------------------------------------------------------------*/
+/* RPL switched parents, but RPL_CALLBACK_PARENT_SWITCH didn't reach us */
+static void
+test_parent_switch_missed(void)
+{
+  setup();
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+
+  mock_rpl_join(ROOT, OTHER);
+  seq++;
+  datagram(OTHER, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  seq++;
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  CHECK_STAT("parent_refresh", 2);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_forward(void)
+{
+  uip_ipaddr_t src;
+
+  setup();
+  uip_mcast6_route_add(&group);
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  CHECK_STAT("mcast_fwd", 1);
+
+#if ESMRF_MIN_FWD_DELAY
+  CHECK(mock_out.count == 0);
+  mock_run(ESMRF_MIN_FWD_DELAY - 1);
+  CHECK(mock_out.count == 0);
+  mock_run(ESMRF_MIN_FWD_DELAY * ESMRF_MAX_SPREAD);
+#endif
+  CHECK(mock_out.count == 1);
+
+  mock_addr(&src, 0xaaaa, ROOT);
+  CHECK(out_is_datagram(&src));
+  CHECK(((struct uip_ip_hdr *)mock_out.buf)->ttl == 63);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_out(void)
+{
+  struct uip_ip_hdr *ip;
+  uint8_t *icmp;
+  uip_ipaddr_t a;
+
+  setup();
+  datagram_ours(sizeof(seq));
+  UIP_MCAST6.out();
+#if ESMRF_BATCH
+  /* Held back for a while, in case more follow */
+  CHECK(mock_out.ipv6_count == 0);
+  mock_run(ESMRF_BATCH_HOLD);
+#endif
+  CHECK(mock_out.ipv6_count == 1);
+  CHECK(mock_out.count == 0);
+  CHECK(uip_slen == 0);
+  CHECK_STAT("icmp_out", 1);
+
+  /* To the root, from our global address */
+  ip = (struct uip_ip_hdr *)mock_out.buf;
+  CHECK(ip->proto == UIP_PROTO_ICMP6);
+  CHECK(ip->ttl == ESMRF_IP_HOP_LIMIT);
+  mock_addr(&a, 0xaaaa, ROOT);
+  CHECK(uip_ipaddr_cmp(&ip->destipaddr, &a));
+  mock_addr(&a, 0xaaaa, 1);
+  CHECK(uip_ipaddr_cmp(&ip->srcipaddr, &a));
+
+  icmp = &mock_out.buf[UIP_IPH_LEN];
+  CHECK(icmp[0] == ICMP6_ESMRF);
+#if !ESMRF_BATCH && !ESMRF_COMPACT_MOB
+  /* Port, group, then our payload as is */
+  CHECK(icmp[1] == ESMRF_ICMP_CODE);
+  CHECK(mock_out.len == UIP_IPICMPH_LEN + 2 + 16 + sizeof(seq));
+  CHECK(icmp[UIP_ICMPH_LEN] == MOCK_UDP_PORT >> 8);
+  CHECK(icmp[UIP_ICMPH_LEN + 1] == (MOCK_UDP_PORT & 0xFF));
+  CHECK(memcmp(&icmp[UIP_ICMPH_LEN + 2], &group, sizeof(group)) == 0);
+  CHECK(memcmp(&icmp[UIP_ICMPH_LEN + 2 + 16], &seq, sizeof(seq)) == 0);
+#elif ESMRF_COMPACT_MOB && !ESMRF_BATCH
+  /* Flags, port, no more of the group than it takes, then our payload */
+  CHECK(icmp[1] == ESMRF_ICMP_CODE_COMPACT);
+  CHECK(mock_out.len < UIP_IPICMPH_LEN + 2 + 16 + sizeof(seq));
+  CHECK(icmp[UIP_ICMPH_LEN + 1] == MOCK_UDP_PORT >> 8);
+  CHECK(icmp[UIP_ICMPH_LEN + 2] == (MOCK_UDP_PORT & 0xFF));
+  CHECK(memcmp(&mock_out.buf[mock_out.len - sizeof(seq)], &seq,
+               sizeof(seq)) == 0);
+#if ESMRF_GROUP_CONTEXTS && defined(ESMRF_CONF_GROUP_CONTEXT_0)
+  /* Group context 0: Nothing of the group inline */
+  CHECK(icmp[UIP_ICMPH_LEN] == 4 << 5);
+  CHECK(mock_out.len == UIP_IPICMPH_LEN + 3 + sizeof(seq));
+#endif
+#endif
+}
+/*---------------------------------------------------------------------------*/
+/* Datagrams that don't fit in the pending batch must not overtake it */
+static void
+test_batch_order(void)
+{
+#if ESMRF_BATCH
+  uint8_t *icmp;
+  uint32_t last;
+  int n;
+
+  setup();
+  icmp = &mock_out.buf[UIP_IPH_LEN];
+
+  /* Fill the batch until one doesn't fit. The batch goes, it starts anew */
+  for(n = 0; mock_out.ipv6_count == 0; n++) {
+    seq = n;
+    datagram_ours(sizeof(seq));
+    UIP_MCAST6.out();
+  }
+  CHECK(n > 1);
+  CHECK(icmp[1] == ESMRF_ICMP_CODE_BATCH);
+  CHECK(mock_out.len > UIP_IPICMPH_LEN + (n - 1) * sizeof(seq));
+  last = n - 2;
+  CHECK(memcmp(&mock_out.buf[mock_out.len - sizeof(seq)], &last,
+               sizeof(seq)) == 0);
+
+  mock_run(ESMRF_BATCH_HOLD);
+  CHECK(mock_out.ipv6_count == 2);
+  CHECK(icmp[1] == ESMRF_ICMP_CODE_BATCH);
+  CHECK(memcmp(&mock_out.buf[mock_out.len - sizeof(seq)], &seq,
+               sizeof(seq)) == 0);
+
+  /* Too large to batch at all. It goes out on its own, after the batch */
+  seq++;
+  datagram_ours(sizeof(seq));
+  UIP_MCAST6.out();
+  seq++;
+  datagram_ours(ESMRF_BATCH_BUDGET + 1);
+  UIP_MCAST6.out();
+  CHECK(mock_out.ipv6_count == 4);
+  CHECK_STAT("batch_out", 3);
+  CHECK(icmp[1] != ESMRF_ICMP_CODE_BATCH);
+  CHECK(memcmp(&mock_out.buf[mock_out.len - ESMRF_BATCH_BUDGET - 1], &seq,
+               sizeof(seq)) == 0);
+
+  /* Nothing left behind */
+  mock_run(CLOCK_SECOND);
+  CHECK(mock_out.ipv6_count == 4);
+#endif
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_out_root(void)
+{
+  setup();
+  mock_rpl_join(1, 0);
+  datagram_ours(sizeof(seq));
+  UIP_MCAST6.out();
+  mock_run(CLOCK_SECOND);
+  CHECK(mock_out.ipv6_count == 0);
+  CHECK(uip_slen == sizeof(seq));
+
+  mock_rpl_leave();
+  UIP_MCAST6.out();
+  mock_run(CLOCK_SECOND);
+  CHECK(mock_out.ipv6_count == 0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_reinject(void)
+{
+  setup();
+  mock_rpl_join(1, 0);
+  icmp(ESMRF_ICMP_CODE, 64, 2 + 16 + sizeof(seq));
+  mock_icmp6_input();
+  CHECK_STAT("icmp_in", 1);
+  CHECK_STAT("reinject", 1);
+  CHECK(mock_delivered == 1);
+  CHECK(uip_len == 0);
+
+  /* No route, so nobody down the tree wants it */
+  mock_run(CLOCK_SECOND);
+  CHECK(mock_out.count + mock_out.ipv6_count == 0);
+}
+/*---------------------------------------------------------------------------*/
+/* Our own datagram up to the root and from there down the DODAG */
+static void
+test_roundtrip(void)
+{
+  uip_ipaddr_t src;
+
+  setup();
+  datagram_ours(sizeof(seq));
+  UIP_MCAST6.out();
+  mock_run(CLOCK_SECOND);
+  CHECK(mock_out.ipv6_count == 1);
+
+  /* Now we're the root, and the message arrives from ourselves */
+  mock_rpl_join(1, 0);
+  uip_mcast6_route_add(&group);
+  memcpy(uip_buf, mock_out.buf, mock_out.len);
+  uip_len = mock_out.len;
+  memset(&mock_out, 0, sizeof(mock_out));
+  mock_icmp6_input();
+  mock_run(CLOCK_SECOND);
+
+  CHECK_STAT("reinject", 1);
+  CHECK(mock_delivered == 1);
+  CHECK(mock_out.count + mock_out.ipv6_count == 1);
+  mock_addr(&src, 0xaaaa, 1);
+  CHECK(out_is_datagram(&src));
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_icmp_bad(void)
+{
+  setup();
+  mock_rpl_join(1, 0);
+  icmp(7, 64, 2 + 16 + sizeof(seq));
+  mock_icmp6_input();
+  icmp(ESMRF_ICMP_CODE, 1, 2 + 16 + sizeof(seq));
+  mock_icmp6_input();
+  icmp(ESMRF_ICMP_CODE, 64, 4);
+  mock_icmp6_input();
+  CHECK_STAT("icmp_bad", 3);
+  CHECK_STAT("icmp_in", 0);
+  CHECK(mock_delivered == 0);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * A compact header naming a group context is shorter than the UDP header the
+ * root puts in its place. The largest such message must not fit
+ */
+static void
+test_icmp_too_long(void)
+{
+#if ESMRF_GROUP_CONTEXTS && defined(ESMRF_CONF_GROUP_CONTEXT_0)
+  uip_ipaddr_t src;
+  uip_ipaddr_t dst;
+  uint8_t hdr[UIP_ICMPH_LEN] = { ICMP6_ESMRF, ESMRF_ICMP_CODE_COMPACT };
+  uint8_t mob[3] = { 4 << 5, MOCK_UDP_PORT >> 8, MOCK_UDP_PORT & 0xFF };
+  uint16_t len;
+
+  setup();
+  mock_rpl_join(1, 0);
+  mock_addr(&src, 0xaaaa, SENDER);
+  mock_addr(&dst, 0xaaaa, 1);
+
+  /* The largest payload that fits after the UDP header, then one more */
+  for(len = UIP_BUFSIZE - UIP_IPUDPH_LEN;
+      len <= UIP_BUFSIZE - UIP_IPUDPH_LEN + 1; len++) {
+    mock_ip(&src, &dst, UIP_PROTO_ICMP6, 64);
+    mock_append(hdr, sizeof(hdr));
+    mock_append(mob, sizeof(mob));
+    mock_append(payload, len);
+    mock_icmp6_input();
+  }
+  CHECK_STAT("reinject", 1);
+  CHECK_STAT("icmp_bad", 1);
+  CHECK(mock_delivered == 1);
+#endif
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Per-group counters for datagrams relayed down the tree and for on-behalf
+ * messages we forward as the root. The latter only count as forwarded
+ */
+static void
+test_group_stats(void)
+{
+#if UIP_MCAST6_GROUP_STATS
+  uip_mcast6_route_t *rt;
+  uip_mcast6_group_stats_t snap;
+
+  setup();
+  rt = uip_mcast6_route_add(&group);
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  CHECK(rt->stats.in == 1);
+  CHECK(rt->stats.fwd == 1);
+  CHECK(rt->stats.dropped == 1);
+  CHECK(rt->stats.bytes == UIP_IPUDPH_LEN + sizeof(seq));
+
+  uip_mcast6_route_stats_snapshot(rt, &snap);
+  CHECK(snap.in == 1 && snap.fwd == 1 && snap.dropped == 1);
+  CHECK(snap.bytes == UIP_IPUDPH_LEN + sizeof(seq));
+  CHECK(rt->stats.in == 0 && rt->stats.fwd == 0);
+  CHECK(rt->stats.dropped == 0 && rt->stats.bytes == 0);
+
+  mock_run(CLOCK_SECOND);
+  mock_rpl_join(1, 0);
+  seq++;
+  icmp(ESMRF_ICMP_CODE, 64, 2 + 16 + sizeof(seq));
+  mock_icmp6_input();
+  mock_run(CLOCK_SECOND);
+  CHECK(rt->stats.fwd == 1);
+  CHECK(rt->stats.in == 0 && rt->stats.dropped == 0);
+#endif
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Relayed datagrams wait for the forwarding delay. As the root, we send an
+ * on-behalf message's datagram down the tree as soon as we get it: 0 ticks
+ */
+static void
+test_latency(void)
+{
+#if UIP_MCAST6_STATS && UIP_MCAST6_STATS_LATENCY
+  clock_time_t start;
+
+  setup();
+  uip_mcast6_route_add(&group);
+  datagram(PARENT, 64);
+  start = mock_now;
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  while(mock_out.count == 0 && mock_now - start < CLOCK_SECOND) {
+    mock_run(1);
+  }
+  CHECK(mock_out.count == 1);
+  CHECK(mock_now - start >= ESMRF_MIN_FWD_DELAY);
+  CHECK_LATENCY(UIP_MCAST6_LATENCY_FWD, mock_now - start, 1);
+  CHECK(mock_latency_total(UIP_MCAST6_LATENCY_ON_BEHALF) == 0);
+
+  mock_rpl_join(1, 0);
+  seq++;
+  icmp(ESMRF_ICMP_CODE, 64, 2 + 16 + sizeof(seq));
+  mock_icmp6_input();
+  mock_run(0);
+  CHECK(mock_out.count + mock_out.ipv6_count == 2);
+  CHECK_LATENCY(UIP_MCAST6_LATENCY_ON_BEHALF, 0, 1);
+  CHECK_LATENCY(UIP_MCAST6_LATENCY_FWD, mock_now - start, 1);
+#endif
+}
+/*---------------------------------------------------------------------------*/
+/* Nothing but duplicates: The delay floor backs off up to its bound */
+static void
+test_adaptive(void)
+{
+#if ESMRF_ADAPTIVE && UIP_MCAST6_STATS
+  uint32_t backoffs;
+  int i;
+
+  setup();
+  for(i = 0; i < 8 * UIP_MCAST6_ADAPT_WINDOW; i++) {
+    datagram(PARENT, 64);
+    UIP_MCAST6.in();
+  }
+  backoffs = mock_stat("adapt_backoff");
+  CHECK(backoffs > 0);
+
+  /* At the bound: No more backing off, and nothing to count */
+  for(i = 0; i < 2 * UIP_MCAST6_ADAPT_WINDOW; i++) {
+    datagram(PARENT, 64);
+    UIP_MCAST6.in();
+  }
+  CHECK_STAT("adapt_backoff", backoffs);
+#endif
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Benchmarks: Relaying a fresh datagram. Re-injecting one at the root and
+ * forwarding it down the DODAG, with a payload as large as it gets so that
+ * the copies show. Build with ESMRF_CONF_REINJECT_COPY=1 to compare
+ */
+static void
+bench_in(void)
+{
+  seq++;
+  datagram(PARENT, 64);
+  UIP_MCAST6.in();
+}
+/*---------------------------------------------------------------------------*/
+static void
+bench_reinject(void)
+{
+  seq++;
+  icmp(ESMRF_ICMP_CODE, 64, 2 + 16 + PAYLOAD_MAX);
+  mock_icmp6_input();
+  mock_run(0);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  if(mock_bench_mode(argc, argv)) {
+    mock_init();
+    setup();
+    mock_bench("in, unique", bench_in, 1000000);
+    mock_rpl_join(1, 0);
+    uip_mcast6_route_add(&group);
+    mock_bench("ICMPv6 in, reinject, fwd", bench_reinject, 1000000);
+    return 0;
+  }
+
+  mock_test("accept from parent", test_accept_from_parent);
+  mock_test("drop", test_drop);
+  mock_test("parent switch, missed", test_parent_switch_missed);
+  mock_test("forward", test_forward);
+  mock_test("out", test_out);
+  mock_test("batch order", test_batch_order);
+  mock_test("out at the root", test_out_root);
+  mock_test("reinject", test_reinject);
+  mock_test("roundtrip", test_roundtrip);
+  mock_test("bad ICMPv6", test_icmp_bad);
+  mock_test("ICMPv6 too long", test_icmp_too_long);
+  mock_test("group stats", test_group_stats);
+  mock_test("latency", test_latency);
+  mock_test("adaptive", test_adaptive);
+  return mock_report();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,518 @@
+/*
+ * MPL, with Data Messages from the seed aaaa::9 and Control Messages from
+ * our neighbour fe80::2
+ */
+#include "mock.h"
+#include "net/ipv6/uip-icmp6.h"
+
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#define SEED      9
+#define NEIGHBOUR 2
+/*---------------------------------------------------------------------------*/
+#define HBHO_OPT_TYPE_MPL 0x6D
+#define HBH_M_BIT         0x20
+#define HBH_V_BIT         0x10
+
+/* The HBH header out() adds, for our Seed ID type */
+#define OUT_HBHO_LEN \
+  (MPL_SEED_ID_TYPE == 3 ? 24 : (MPL_SEED_ID_TYPE == 2 ? 16 : 8))
+
+/* Where the UDP payload starts in the datagrams we forward */
+#define OUT_PAYLOAD (UIP_IPUDPH_LEN + 8)
+
+/* Seed Info for aaaa::9: min-seqno, bm-len | S, Seed ID, a 1-byte bitmap */
+#define SEED_INFO_LEN (2 + 16 + 1)
+
+/* Data Message Trickle timer, in clock ticks */
+#define DATA_IMAX   (MPL_DATA_MESSAGE_IMIN << MPL_DATA_MESSAGE_IMAX)
+#define DATA_ACTIVE (DATA_IMAX * MPL_DATA_MESSAGE_TIMER_EXPIRATIONS)
+/*---------------------------------------------------------------------------*/
+static uip_ipaddr_t group;
+static uip_ipaddr_t all_forwarders;
+static uint16_t payload;
+
+/* Payloads of datagram_from(): seq, then padding */
+static uint8_t body[UIP_BUFSIZE];
+/*---------------------------------------------------------------------------*/
+/*
+ * A Data Message as seed sends it: IPv6, HBH with an MPL Option that elides
+ * the Seed ID, UDP. The payload is seq, padded to len bytes
+ */
+static void
+datagram_from(uint8_t seed, uint8_t seq, uint16_t len)
+{
+  uip_ipaddr_t src;
+  uint8_t hbh[8] = { UIP_PROTO_UDP, 0, HBHO_OPT_TYPE_MPL, 2, HBH_M_BIT, 0,
+                     UIP_EXT_HDR_OPT_PADN, 0 };
+
+  hbh[5] = seq;
+  mock_addr(&src, 0xaaaa, seed);
+  mock_ip(&src, &group, UIP_PROTO_HBHO, 64);
+  mock_append(hbh, sizeof(hbh));
+  memset(body, seq, len);
+  body[0] = seq;
+  mock_udp(body, len);
+  uip_ext_len = sizeof(hbh);
+}
+/*---------------------------------------------------------------------------*/
+static void
+datagram(uint8_t seq)
+{
+  datagram_from(SEED, seq, sizeof(payload));
+}
+/*---------------------------------------------------------------------------*/
+/* A Control Message from our neighbour, with len bytes of Seed Info */
+static void
+control(const uint8_t *info, uint16_t len)
+{
+  uip_ipaddr_t src;
+  uint8_t hdr[UIP_ICMPH_LEN] = { ICMP6_MPL, MPL_ICMP_CODE };
+
+  mock_addr(&src, 0xfe80, NEIGHBOUR);
+  mock_ip(&src, &all_forwarders, UIP_PROTO_ICMP6, MPL_IP_HOP_LIMIT);
+  mock_append(hdr, sizeof(hdr));
+  mock_append(info, len);
+}
+/*---------------------------------------------------------------------------*/
+/* Seed Info listing the seqs in bm for the seed, starting at min */
+static void
+seed_info(uint8_t *info, uint8_t min, uint8_t bm)
+{
+  info[0] = min;
+  info[1] = (1 << 2) | 3;
+  mock_addr((uip_ipaddr_t *)&info[2], 0xaaaa, SEED);
+  info[2 + 16] = bm;
+}
+/*---------------------------------------------------------------------------*/
+/* The MPL Option of the last datagram we sent */
+static uint8_t *
+out_opt(void)
+{
+  return &mock_out.bcast_buf[UIP_IPH_LEN + 2];
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+out_seq(void)
+{
+  return out_opt()[3];
+}
+/*---------------------------------------------------------------------------*/
+/* Is the last datagram we sent the one datagram_from() built for its seq? */
+static int
+out_intact(uint16_t len)
+{
+  uint16_t i;
+
+  if(mock_out.bcast_len != OUT_PAYLOAD + len) {
+    return 0;
+  }
+  for(i = 0; i < len; i++) {
+    if(mock_out.bcast_buf[OUT_PAYLOAD + i] != out_seq()) {
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Run the clock until we send a Control Message. 0 if none within ticks */
+static int
+run_until_control(clock_time_t ticks)
+{
+  int count;
+
+  for(; ticks > 0; ticks--) {
+    count = mock_out.ipv6_count;
+    mock_run(1);
+    if(mock_out.ipv6_count != count &&
+       ((struct uip_ip_hdr *)mock_out.buf)->proto == UIP_PROTO_ICMP6) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+setup(void)
+{
+  uip_ip6addr(&group, 0xff1e, 0, 0, 0, 0, 0, 0x89, 0xabcd);
+  uip_ip6addr(&all_forwarders, 0xff02, 0, 0, 0, 0, 0, 0, 0x00fc);
+  UIP_MCAST6.init();
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_accept(void)
+{
+  setup();
+  datagram(1);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  CHECK_STAT("mcast_in_all", 1);
+  CHECK_STAT("mcast_in_unique", 1);
+  CHECK_STAT("mcast_in_ours", 1);
+
+  /* Seen before */
+  datagram(1);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  CHECK_STAT("mcast_dropped", 1);
+
+  /* Not a member: Buffered and forwarded, but not delivered */
+  mock_member = 0;
+  datagram(2);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  CHECK_STAT("mcast_in_unique", 2);
+  CHECK_STAT("mcast_in_ours", 1);
+  CHECK_STAT("mcast_dropped", 1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_bad(void)
+{
+  uip_ipaddr_t src;
+
+  setup();
+
+  /* No HBH */
+  mock_addr(&src, 0xaaaa, SEED);
+  mock_ip(&src, &group, UIP_PROTO_UDP, 64);
+  mock_udp(&payload, sizeof(payload));
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+
+  /* Some other option */
+  datagram(1);
+  uip_buf[UIP_IPH_LEN + 2] = UIP_EXT_HDR_OPT_RPL;
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+
+  /* A later version of the protocol */
+  datagram(1);
+  uip_buf[UIP_IPH_LEN + 4] |= HBH_V_BIT;
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+
+  /* Too short for a 16-bit Seed ID */
+  datagram(1);
+  uip_buf[UIP_IPH_LEN + 4] |= 1 << 6;
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+
+  /* Link-local scope */
+  datagram(1);
+  uip_create_linklocal_allnodes_mcast(
+    &((struct uip_ip_hdr *)uip_buf)->destipaddr);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+
+  CHECK_STAT("mcast_bad", 5);
+  CHECK_STAT("mcast_in_all", 0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_too_old(void)
+{
+  setup();
+  datagram(5);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  datagram(4);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  datagram(6);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  CHECK_STAT("mcast_dropped", 1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_forward(void)
+{
+  int count;
+
+  setup();
+  datagram(1);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+
+#if MPL_PROACTIVE_FORWARDING
+  /* Forwarded within the first interval, with one less hop */
+  CHECK(mock_out.count == 0);
+  mock_run(MPL_DATA_MESSAGE_IMIN);
+  CHECK(mock_out.count == 1);
+  CHECK(((struct uip_ip_hdr *)mock_out.bcast_buf)->ttl == 63);
+  CHECK(out_seq() == 1);
+  CHECK_STAT("mcast_fwd", 1);
+#else
+  /* Not until a Control Message tells us someone misses it */
+  mock_run(MPL_DATA_MESSAGE_IMIN);
+  CHECK(mock_out.count == 0);
+#endif
+
+  /* Quiet once the data timer has run its course */
+  mock_run(DATA_ACTIVE);
+  count = mock_out.count;
+  mock_run(DATA_ACTIVE);
+  CHECK(mock_out.count == count);
+}
+/*---------------------------------------------------------------------------*/
+/* Heard again before our turn: k = 1 is enough, we keep quiet */
+static void
+test_suppression(void)
+{
+  setup();
+  datagram(1);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  datagram(1);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  mock_run(MPL_DATA_MESSAGE_IMIN);
+  CHECK(mock_out.count == 0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_control_out(void)
+{
+  struct uip_ip_hdr *ip;
+  uint8_t info[SEED_INFO_LEN];
+  uint8_t *icmp;
+
+  setup();
+  datagram(1);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  datagram(3);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+
+  /* A new message resets the Control Message timer */
+  CHECK(run_until_control(MPL_CONTROL_MESSAGE_IMIN));
+  CHECK_STAT("icmp_out", 1);
+
+  ip = (struct uip_ip_hdr *)mock_out.buf;
+  CHECK(uip_ipaddr_cmp(&ip->destipaddr, &all_forwarders));
+  CHECK(ip->ttl == MPL_IP_HOP_LIMIT);
+  icmp = &mock_out.buf[UIP_IPH_LEN];
+  CHECK(icmp[0] == ICMP6_MPL);
+  CHECK(icmp[1] == MPL_ICMP_CODE);
+
+  /* Seqs 1 and 3 from seq 1 on, with the full Seed ID */
+  seed_info(info, 1, 0xA0);
+  CHECK(mock_out.len == UIP_IPICMPH_LEN + SEED_INFO_LEN);
+  CHECK(memcmp(&icmp[UIP_ICMPH_LEN], info, sizeof(info)) == 0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_control_in(void)
+{
+  uint8_t info[SEED_INFO_LEN];
+  int count;
+
+  setup();
+  datagram(1);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  mock_run(2 * DATA_ACTIVE);
+
+  /* The neighbour has it too: Nothing to do */
+  count = mock_out.count;
+  seed_info(info, 1, 0x80);
+  control(info, sizeof(info));
+  mock_icmp6_input();
+  CHECK_STAT("icmp_in", 1);
+  mock_run(DATA_IMAX);
+  CHECK(mock_out.count == count);
+
+  /* The neighbour doesn't have it: Send it again */
+  seed_info(info, 1, 0x00);
+  control(info, sizeof(info));
+  mock_icmp6_input();
+  mock_run(MPL_DATA_MESSAGE_IMIN);
+  CHECK(mock_out.count == count + 1);
+  CHECK(out_seq() == 1);
+
+  /* Nor does one that doesn't list the seed at all */
+  mock_run(2 * DATA_ACTIVE);
+  count = mock_out.count;
+  control(NULL, 0);
+  mock_icmp6_input();
+  mock_run(MPL_DATA_MESSAGE_IMIN);
+  CHECK(mock_out.count == count + 1);
+
+  /* The neighbour has seq 2, which we miss: Tell everyone what we have */
+  mock_run(2 * DATA_ACTIVE);
+  count = mock_out.ipv6_count;
+  seed_info(info, 1, 0xC0);
+  control(info, sizeof(info));
+  mock_icmp6_input();
+  CHECK(run_until_control(MPL_CONTROL_MESSAGE_IMIN));
+  CHECK_STAT("icmp_in", 4);
+  CHECK_STAT("icmp_bad", 0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_control_bad(void)
+{
+  uip_ipaddr_t src;
+  uint8_t info[SEED_INFO_LEN];
+
+  setup();
+  seed_info(info, 1, 0x80);
+
+  /* Wrong code */
+  control(info, sizeof(info));
+  uip_buf[UIP_IPH_LEN + 1] = 1;
+  mock_icmp6_input();
+
+  /* Wrong hop limit */
+  control(info, sizeof(info));
+  ((struct uip_ip_hdr *)uip_buf)->ttl = 64;
+  mock_icmp6_input();
+
+  /* Not from a link-local address */
+  control(info, sizeof(info));
+  mock_addr(&src, 0xaaaa, NEIGHBOUR);
+  uip_ipaddr_copy(&((struct uip_ip_hdr *)uip_buf)->srcipaddr, &src);
+  mock_icmp6_input();
+
+  /* The bitmap runs past the end */
+  control(info, sizeof(info) - 1);
+  mock_icmp6_input();
+
+  CHECK_STAT("icmp_bad", 4);
+  CHECK_STAT("icmp_in", 1);
+  CHECK(uip_len == 0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_out(void)
+{
+  uip_ipaddr_t src;
+  struct uip_ip_hdr *ip;
+
+  setup();
+  mock_addr(&src, 0xaaaa, 1);
+  mock_ip(&src, &group, UIP_PROTO_UDP, 64);
+  mock_udp(&payload, sizeof(payload));
+  UIP_MCAST6.out();
+
+  /* Sent right away with our MPL Option. Nothing left for the core to send */
+  CHECK(uip_len == 0);
+  CHECK(mock_out.count == 1);
+  CHECK_STAT("mcast_out", 1);
+
+  ip = (struct uip_ip_hdr *)mock_out.bcast_buf;
+  CHECK(ip->proto == UIP_PROTO_HBHO);
+  CHECK(mock_out.bcast_buf[UIP_IPH_LEN] == UIP_PROTO_UDP);
+  CHECK(out_opt()[0] == HBHO_OPT_TYPE_MPL);
+  CHECK(out_opt()[2] == ((MPL_SEED_ID_TYPE << 6) | HBH_M_BIT));
+  CHECK(out_seq() == 1);
+  CHECK(mock_out.bcast_len == UIP_IPUDPH_LEN + OUT_HBHO_LEN + sizeof(payload));
+  CHECK(((ip->len[0] << 8) | ip->len[1]) == mock_out.bcast_len - UIP_IPH_LEN);
+
+  mock_ip(&src, &group, UIP_PROTO_UDP, 64);
+  mock_udp(&payload, sizeof(payload));
+  UIP_MCAST6.out();
+  CHECK(mock_out.count == 2);
+  CHECK(out_seq() == 2);
+}
+/*---------------------------------------------------------------------------*/
+/* Datagrams sent by test_reclaim(), each checked as it goes */
+static int sent;
+
+static void
+reclaim_tap(void)
+{
+  sent++;
+  CHECK(out_seq() >= 2);
+  CHECK(out_intact(4 * out_seq() + 2));
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * One message more than we have room for. The oldest goes, and everything
+ * stored above it in the arena moves down. What we send afterwards must
+ * still be what we received. Lengths differ, so that nothing lands where it
+ * was by chance
+ */
+static void
+test_reclaim(void)
+{
+  uint8_t seq;
+
+  setup();
+  for(seq = 1; seq <= MPL_BUFFERED_MESSAGE_SET_SIZE + 1; seq++) {
+    datagram_from(SEED, seq, 4 * seq + 2);
+    CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  }
+  datagram(1);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  datagram(2);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+
+  /* Everything is news to a neighbour that doesn't list the seed */
+  control(NULL, 0);
+  mock_icmp6_input();
+
+  sent = 0;
+  mock_output_tap = reclaim_tap;
+  mock_run(DATA_ACTIVE);
+  CHECK(sent >= MPL_BUFFERED_MESSAGE_SET_SIZE);
+}
+/*---------------------------------------------------------------------------*/
+/* A full Seed Set only takes a new seed once an old one expires */
+static void
+test_seed_set(void)
+{
+  uint8_t seed;
+
+  setup();
+  for(seed = 1; seed <= MPL_SEED_SET_SIZE; seed++) {
+    datagram_from(seed, 1, sizeof(payload));
+    CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  }
+  datagram_from(seed, 1, sizeof(payload));
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  CHECK_STAT("seed_expired", 0);
+
+  mock_run(MPL_SEED_SET_ENTRY_LIFETIME * CLOCK_SECOND);
+  datagram_from(seed, 1, sizeof(payload));
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  CHECK_STAT("seed_expired", MPL_SEED_SET_SIZE);
+
+  /* Expired seeds start over */
+  datagram_from(1, 1, sizeof(payload));
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+}
+/*---------------------------------------------------------------------------*/
+/* Benchmarks */
+static uint8_t bench_seq;
+/*---------------------------------------------------------------------------*/
+static void
+bench_in(void)
+{
+  /* The buffer fills up, then each new message reclaims the oldest */
+  bench_seq++;
+  datagram(bench_seq);
+  UIP_MCAST6.in();
+}
+/*---------------------------------------------------------------------------*/
+static void
+bench_control(void)
+{
+  uint8_t info[SEED_INFO_LEN];
+
+  seed_info(info, bench_seq - 5, 0xFC);
+  control(info, sizeof(info));
+  mock_icmp6_input();
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  if(mock_bench_mode(argc, argv)) {
+    mock_init();
+    setup();
+    mock_bench("in, new seq", bench_in, 1000000);
+    mock_bench("Control Message in", bench_control, 1000000);
+    return 0;
+  }
+
+  mock_test("accept", test_accept);
+  mock_test("bad datagrams", test_bad);
+  mock_test("too old", test_too_old);
+  mock_test("forward", test_forward);
+  mock_test("suppression", test_suppression);
+  mock_test("Control Message out", test_control_out);
+  mock_test("Control Message in", test_control_in);
+  mock_test("bad Control Messages", test_control_bad);
+  mock_test("out", test_out);
+  mock_test("reclaim", test_reclaim);
+  mock_test("Seed Set", test_seed_set);
+  return mock_report();
+}
+/*---------------------------------------------------------------------------*/
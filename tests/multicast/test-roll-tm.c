@@ -0,0 +1,690 @@
+/*
+ * ROLL TM, with datagrams from the seed aaaa::9 and ICMPv6 sequence lists
+ * from our neighbour fe80::2
+ */
+#include "mock.h"
+#include "net/ipv6/uip-icmp6.h"
+
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#define SEED      9
+#define NEIGHBOUR 2
+/*---------------------------------------------------------------------------*/
+#define HBHO_OPT_TYPE_TRICKLE 0x0C
+#define SEQ_LIST_M_BIT        0x40
+#define SEQ_LIST_S_BIT        0x80
+
+/* Trickle parametrization for M = 0, in clock ticks */
+#define IMAX_0   (ROLL_TM_IMIN_0 << ROLL_TM_IMAX_0)
+#define ACTIVE_0 (IMAX_0 * ROLL_TM_T_ACTIVE_0)
+#define DWELL_0  (IMAX_0 * ROLL_TM_T_DWELL_0)
+/* Sequence list header: Flags, length, Seed ID */
+#define SEQ_LIST_HDR_LEN (2 + (ROLL_TM_SHORT_SEEDS ? 2 : 16))
+
+/* Where the UDP payload starts in the datagrams we send */
+#define OUT_PAYLOAD (UIP_IPUDPH_LEN + ROLL_TM_HBHO_LEN)
+/*---------------------------------------------------------------------------*/
+static uip_ipaddr_t group;
+static uint16_t payload;
+
+/* Payloads of datagram_from(): seq, then padding */
+static uint8_t body[UIP_BUFSIZE];
+/*---------------------------------------------------------------------------*/
+/*
+ * A datagram as seed sends it: IPv6, HBH with the trickle option, UDP. The
+ * payload is seq, padded to len bytes
+ */
+static void
+datagram_from(uint8_t seed, uint16_t seq, uint8_t m, uint16_t len)
+{
+  uip_ipaddr_t src;
+  uint8_t hbh[8] = { UIP_PROTO_UDP, 0, HBHO_OPT_TYPE_TRICKLE };
+
+#if ROLL_TM_SHORT_SEEDS
+  hbh[3] = 4;
+  hbh[5] = seed;
+  hbh[6] = (m ? 0x80 : 0) | (seq >> 8);
+  hbh[7] = seq & 0xFF;
+#else
+  hbh[3] = 2;
+  hbh[4] = (m ? 0x80 : 0) | (seq >> 8);
+  hbh[5] = seq & 0xFF;
+  hbh[6] = UIP_EXT_HDR_OPT_PADN;
+  hbh[7] = 0;
+#endif
+
+  mock_addr(&src, 0xaaaa, seed);
+  mock_ip(&src, &group, UIP_PROTO_HBHO, 64);
+  mock_append(hbh, sizeof(hbh));
+  memset(body, seq & 0xFF, len);
+  memcpy(body, &seq, sizeof(seq));
+  mock_udp(body, len);
+  uip_ext_len = sizeof(hbh);
+}
+/*---------------------------------------------------------------------------*/
+static void
+datagram(uint16_t seq, uint8_t m)
+{
+  datagram_from(SEED, seq, m, sizeof(payload));
+}
+/*---------------------------------------------------------------------------*/
+/* An ICMPv6 message from our neighbour, listing seqs for the seed */
+static void
+icmp(uint8_t m, const uint16_t *seqs, uint8_t n)
+{
+  uip_ipaddr_t src;
+  uip_ipaddr_t dst;
+  uint8_t hdr[UIP_ICMPH_LEN] = { ICMP6_ROLL_TM, ROLL_TM_ICMP_CODE };
+  uint8_t list[4 + 16];
+  uint8_t s[2];
+  uint8_t i;
+
+  mock_addr(&src, 0xfe80, NEIGHBOUR);
+  uip_create_linklocal_allnodes_mcast(&dst);
+  mock_ip(&src, &dst, UIP_PROTO_ICMP6, ROLL_TM_IP_HOP_LIMIT);
+  mock_append(hdr, sizeof(hdr));
+
+  memset(list, 0, sizeof(list));
+  list[0] = m ? SEQ_LIST_M_BIT : 0;
+  list[1] = n;
+#if ROLL_TM_SHORT_SEEDS
+  list[0] |= SEQ_LIST_S_BIT;
+  list[3] = SEED;
+  mock_append(list, 4);
+#else
+  mock_addr((uip_ipaddr_t *)&list[2], 0xaaaa, SEED);
+  mock_append(list, 2 + 16);
+#endif
+
+  for(i = 0; i < n; i++) {
+    s[0] = seqs[i] >> 8;
+    s[1] = seqs[i] & 0xFF;
+    mock_append(s, sizeof(s));
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* The HBH option of the last datagram we sent */
+static uint8_t *
+out_hbh(void)
+{
+  return &mock_out.bcast_buf[UIP_IPH_LEN + 2];
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+out_seq(void)
+{
+#if ROLL_TM_SHORT_SEEDS
+  return ((out_hbh()[4] & 0x7F) << 8) | out_hbh()[5];
+#else
+  return ((out_hbh()[2] & 0x7F) << 8) | out_hbh()[3];
+#endif
+}
+/*---------------------------------------------------------------------------*/
+/* Is the last datagram we sent the one datagram_from() built for its seq? */
+static int
+out_intact(uint16_t len)
+{
+  uint16_t seq;
+  uint16_t i;
+
+  seq = out_seq();
+  if(mock_out.bcast_len != OUT_PAYLOAD + len ||
+     memcmp(&mock_out.bcast_buf[OUT_PAYLOAD], &seq, sizeof(seq)) != 0) {
+    return 0;
+  }
+  for(i = sizeof(seq); i < len; i++) {
+    if(mock_out.bcast_buf[OUT_PAYLOAD + i] != (seq & 0xFF)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Run the clock until we send an ICMPv6 message. 0 if none within ticks */
+static int
+run_until_icmp(clock_time_t ticks)
+{
+  int count;
+
+  for(; ticks > 0; ticks--) {
+    count = mock_out.ipv6_count;
+    mock_run(1);
+    if(mock_out.ipv6_count != count &&
+       ((struct uip_ip_hdr *)mock_out.buf)->proto == UIP_PROTO_ICMP6) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * The number of sequence lists in the last ICMPv6 message we sent. values
+ * gets the number of sequence values they hold between them
+ */
+static uint8_t
+out_icmp_lists(uint8_t *values)
+{
+  uint8_t *p;
+  uint8_t *end;
+  uint8_t lists;
+  uint8_t len;
+  uint8_t b;
+
+  p = &mock_out.buf[UIP_IPICMPH_LEN];
+  end = &mock_out.buf[mock_out.len];
+  lists = 0;
+  *values = 0;
+  while(p < end) {
+    lists++;
+    len = p[1];
+    p += SEQ_LIST_HDR_LEN;
+    if(mock_out.buf[UIP_IPH_LEN + 1] == ROLL_TM_ICMP_CODE_BITMAP) {
+      /* Base, then one bit per value */
+      for(p += 2; len > 0; len--, p++) {
+        for(b = *p; b != 0; b &= b - 1) {
+          (*values)++;
+        }
+      }
+    } else {
+      *values += len;
+      p += 2 * len;
+    }
+  }
+  return lists;
+}
+/*---------------------------------------------------------------------------*/
+static void
+setup(void)
+{
+  uip_ip6addr(&group, 0xff1e, 0, 0, 0, 0, 0, 0x89, 0xabcd);
+  UIP_MCAST6.init();
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_accept(void)
+{
+  setup();
+  datagram(1, 0);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  CHECK_STAT("mcast_in_all", 1);
+  CHECK_STAT("mcast_in_ours", 1);
+
+  /* Seen before */
+  datagram(1, 0);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  CHECK_STAT("mcast_dropped", 1);
+
+  /* Not a member: Cached and forwarded, but not delivered */
+  mock_member = 0;
+  datagram(2, 0);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  CHECK_STAT("mcast_in_all", 3);
+  CHECK_STAT("mcast_in_ours", 1);
+  CHECK_STAT("mcast_dropped", 1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_bad(void)
+{
+  uip_ipaddr_t src;
+
+  setup();
+
+  /* No HBH */
+  mock_addr(&src, 0xaaaa, SEED);
+  mock_ip(&src, &group, UIP_PROTO_UDP, 64);
+  mock_udp(&payload, sizeof(payload));
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+
+  /* Some other option */
+  datagram(1, 0);
+  uip_buf[UIP_IPH_LEN + 2] = UIP_EXT_HDR_OPT_RPL;
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+
+  /* The wrong option length for our seed ID length */
+  datagram(1, 0);
+  uip_buf[UIP_IPH_LEN + 3] ^= 6;
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+
+  /* Link-local scope */
+  datagram(1, 0);
+  uip_create_linklocal_allnodes_mcast(
+    &((struct uip_ip_hdr *)uip_buf)->destipaddr);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+
+  CHECK_STAT("mcast_bad", 4);
+  CHECK_STAT("mcast_in_all", 0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_too_old(void)
+{
+  setup();
+  datagram(5, 0);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  datagram(4, 0);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  datagram(6, 0);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  CHECK_STAT("mcast_dropped", 1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_forward(void)
+{
+  int count;
+
+  setup();
+  datagram(1, 0);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+
+  /* Forwarded within the first interval, with one less hop */
+  CHECK(mock_out.count == 0);
+  mock_run(ROLL_TM_IMIN_0);
+  CHECK(mock_out.count >= 1);
+  CHECK(((struct uip_ip_hdr *)mock_out.bcast_buf)->ttl == 63);
+  CHECK(out_seq() == 1);
+
+  /* The neighbour has it too: Goes quiet once T_active is up */
+  mock_run(ACTIVE_0);
+  count = mock_out.count;
+  mock_run(DWELL_0);
+  CHECK(mock_out.count == count);
+
+  /* Gone after T_dwell, which makes seq 1 new again */
+  datagram(1, 0);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+}
+/*---------------------------------------------------------------------------*/
+/* From accept() to the first transmission, once: Not for retransmissions */
+static void
+test_latency(void)
+{
+#if UIP_MCAST6_STATS && UIP_MCAST6_STATS_LATENCY
+  clock_time_t start;
+
+  setup();
+  datagram(1, 0);
+  start = mock_now;
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  while(mock_out.count == 0 && mock_now - start < ROLL_TM_IMIN_0) {
+    mock_run(1);
+  }
+  CHECK(mock_out.count == 1);
+  CHECK_LATENCY(UIP_MCAST6_LATENCY_FWD, mock_now - start, 1);
+
+  mock_run(ACTIVE_0);
+  CHECK(mock_out.count > 1);
+  CHECK(mock_latency_total(UIP_MCAST6_LATENCY_FWD) == 1);
+  CHECK(mock_latency_total(UIP_MCAST6_LATENCY_ON_BEHALF) == 0);
+#endif
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_icmp_in(void)
+{
+  static const uint16_t seqs[] = { 1 };
+  int count;
+
+  setup();
+  datagram(1, 0);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  mock_run(IMAX_0);
+
+  /* The neighbour doesn't have seq 1 and it is still active: Send it again */
+  count = mock_out.count;
+  icmp(0, seqs, 0);
+  mock_icmp6_input();
+  CHECK_STAT("icmp_in", 1);
+  mock_run(ROLL_TM_IMIN_0);
+  CHECK(mock_out.count > count);
+  CHECK(out_seq() == 1);
+
+  /* Quiet after T_active, and a neighbour that has it doesn't change that */
+  mock_run(ACTIVE_0);
+  count = mock_out.count;
+  icmp(0, seqs, 1);
+  mock_icmp6_input();
+  CHECK_STAT("icmp_in", 2);
+  mock_run(IMAX_0);
+  CHECK(mock_out.count == count);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_icmp_bad(void)
+{
+  static const uint16_t seqs[] = { 1 };
+  uip_ipaddr_t src;
+
+  setup();
+
+  /* Not link-local */
+  icmp(0, seqs, 1);
+  mock_addr(&src, 0xaaaa, NEIGHBOUR);
+  uip_ipaddr_copy(&((struct uip_ip_hdr *)uip_buf)->srcipaddr, &src);
+  mock_icmp6_input();
+
+  /* Forwarded */
+  icmp(0, seqs, 1);
+  ((struct uip_ip_hdr *)uip_buf)->ttl--;
+  mock_icmp6_input();
+
+  /* Unknown code */
+  icmp(0, seqs, 1);
+  uip_buf[UIP_IPH_LEN + 1] = 0x7F;
+  mock_icmp6_input();
+
+  CHECK_STAT("icmp_bad", 3);
+  CHECK_STAT("icmp_in", 0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_out(void)
+{
+  uip_ipaddr_t src;
+  struct uip_ip_hdr *ip;
+
+  setup();
+  mock_addr(&src, 0xaaaa, 1);
+  mock_ip(&src, &group, UIP_PROTO_UDP, 64);
+  mock_udp(&payload, sizeof(payload));
+  UIP_MCAST6.out();
+
+  /* Sent right away with our HBH option. Nothing left for the core to send */
+  CHECK(uip_len == 0);
+  CHECK(mock_out.count == 1);
+  CHECK_STAT("mcast_out", 1);
+  CHECK_STAT("out_moved", 1);
+
+  ip = (struct uip_ip_hdr *)mock_out.buf;
+  CHECK(ip->proto == UIP_PROTO_HBHO);
+  CHECK(mock_out.buf[UIP_IPH_LEN] == UIP_PROTO_UDP);
+  CHECK(out_hbh()[0] == HBHO_OPT_TYPE_TRICKLE);
+  CHECK(mock_out.len == UIP_IPUDPH_LEN + ROLL_TM_HBHO_LEN + sizeof(payload));
+  CHECK(((ip->len[0] << 8) | ip->len[1]) == mock_out.len - UIP_IPH_LEN);
+#if ROLL_TM_SET_M_BIT
+  CHECK(out_hbh()[ROLL_TM_SHORT_SEEDS ? 4 : 2] & 0x80);
+#endif
+  CHECK(out_seq() == 1);
+
+  /* Headroom left by the send path: The option goes in place */
+  mock_ip(&src, &group, UIP_PROTO_UDP, 64);
+  roll_tm_hbho_reserve(UIP_PROTO_UDP);
+  CHECK(uip_len == UIP_IPH_LEN + ROLL_TM_HBHO_LEN);
+  mock_udp(&payload, sizeof(payload));
+  UIP_MCAST6.out();
+  CHECK(mock_out.count == 2);
+  CHECK_STAT("out_moved", 1);
+  CHECK(mock_out.len == UIP_IPUDPH_LEN + ROLL_TM_HBHO_LEN + sizeof(payload));
+  CHECK(mock_out.buf[UIP_IPH_LEN] == UIP_PROTO_UDP);
+  CHECK(out_hbh()[0] == HBHO_OPT_TYPE_TRICKLE);
+  CHECK(out_seq() == 2);
+}
+/*---------------------------------------------------------------------------*/
+/* The neighbour advertises seq 2 as a bitmap. We understand it regardless */
+static void
+test_icmp_bitmap_in(void)
+{
+  uint8_t hdr[UIP_ICMPH_LEN] = { ICMP6_ROLL_TM, ROLL_TM_ICMP_CODE_BITMAP };
+  uint8_t list[SEQ_LIST_HDR_LEN + 3];
+  uip_ipaddr_t src;
+  uip_ipaddr_t dst;
+  int count;
+
+  setup();
+  datagram(1, 0);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  mock_run(IMAX_0);
+
+  mock_addr(&src, 0xfe80, NEIGHBOUR);
+  uip_create_linklocal_allnodes_mcast(&dst);
+  mock_ip(&src, &dst, UIP_PROTO_ICMP6, ROLL_TM_IP_HOP_LIMIT);
+  mock_append(hdr, sizeof(hdr));
+  memset(list, 0, sizeof(list));
+  list[1] = 1;
+#if ROLL_TM_SHORT_SEEDS
+  list[0] = SEQ_LIST_S_BIT;
+  list[3] = SEED;
+#else
+  mock_addr((uip_ipaddr_t *)&list[2], 0xaaaa, SEED);
+#endif
+  list[SEQ_LIST_HDR_LEN + 1] = 2;
+  list[SEQ_LIST_HDR_LEN + 2] = 0x80;
+  mock_append(list, sizeof(list));
+
+  /* They don't have seq 1: Send it again */
+  count = mock_out.count;
+  mock_icmp6_input();
+  CHECK_STAT("icmp_in", 1);
+  CHECK_STAT("icmp_bad", 0);
+  mock_run(ROLL_TM_IMIN_0);
+  CHECK(mock_out.count > count);
+  CHECK(out_seq() == 1);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Our own ICMPv6 messages, for six messages from one seed. Only M = 1
+ * suppresses transmissions, so only M = 1 advertises
+ */
+static void
+test_icmp_out(void)
+{
+  uint8_t values;
+  uint16_t seq;
+
+  setup();
+  for(seq = 1; seq <= 6; seq++) {
+    datagram(seq, 1);
+    CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  }
+  CHECK(run_until_icmp(ROLL_TM_IMIN_1));
+  CHECK(out_icmp_lists(&values) == 1);
+  CHECK(values == 6);
+#if ROLL_TM_ICMP_BITMAP
+  /* A base and one byte, rather than 12 bytes of values */
+  CHECK(mock_out.buf[UIP_IPH_LEN + 1] == ROLL_TM_ICMP_CODE_BITMAP);
+  CHECK(mock_out.len == UIP_IPICMPH_LEN + SEQ_LIST_HDR_LEN + 2 + 1);
+#else
+  CHECK(mock_out.buf[UIP_IPH_LEN + 1] == ROLL_TM_ICMP_CODE);
+  CHECK(mock_out.len == UIP_IPICMPH_LEN + SEQ_LIST_HDR_LEN + 2 * 6);
+#endif
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Two seeds. With a Trickle timer per seed, each ICMPv6 message lists a
+ * single one of them. Otherwise, both go in every message
+ */
+static void
+test_two_seeds(void)
+{
+  uint8_t values;
+  uint8_t lists;
+  int i;
+
+  setup();
+  datagram_from(SEED, 1, 1, sizeof(payload));
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  datagram_from(SEED - 1, 1, 1, sizeof(payload));
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+
+  /* The first interval's periodic, or each window's */
+  for(i = 0; i < (ROLL_TM_SEED_TRICKLE ? 2 : 1); i++) {
+    CHECK(run_until_icmp(ROLL_TM_IMIN_1));
+    lists = out_icmp_lists(&values);
+    CHECK(lists == values);
+#if ROLL_TM_SEED_TRICKLE
+    CHECK(lists == 1);
+#else
+    CHECK(lists == 2);
+#endif
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* One message more than we have room for: The policy picks what goes */
+static void
+test_reclaim(void)
+{
+  uint16_t seq;
+
+  setup();
+  for(seq = 1; seq <= ROLL_TM_BUFF_NUM; seq++) {
+    datagram(seq, 0);
+    CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+    mock_run(1);
+  }
+#if ROLL_TM_RECLAIM_POLICY == ROLL_TM_RECLAIM_SPENT
+  /* Past T_active: We won't send any of them again */
+  mock_run(ACTIVE_0 + IMAX_0);
+#endif
+
+  datagram(seq, 0);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+#if ROLL_TM_RECLAIM_POLICY == ROLL_TM_RECLAIM_OLDEST
+  CHECK_STAT("reclaim_oldest", 1);
+#elif ROLL_TM_RECLAIM_POLICY == ROLL_TM_RECLAIM_ADVERTISED
+  CHECK_STAT("reclaim_advertised", 1);
+#elif ROLL_TM_RECLAIM_POLICY == ROLL_TM_RECLAIM_SPENT
+  CHECK_STAT("reclaim_spent", 1);
+#endif
+#if ROLL_TM_RECLAIM_POLICY == ROLL_TM_RECLAIM_LARGEST
+  CHECK_STAT("reclaim_largest", 1);
+#else
+  CHECK_STAT("reclaim_largest", 0);
+#endif
+  CHECK_STAT("reclaim_failed", 0);
+
+  /* Kept, and the lowest one went */
+  datagram(seq, 0);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  datagram(1, 0);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  datagram(2, 0);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  CHECK_STAT("mcast_in_unique", ROLL_TM_BUFF_NUM + 1);
+}
+/*---------------------------------------------------------------------------*/
+/* Datagrams sent by test_arena_compaction(), each checked as it goes */
+static int sent;
+
+static void
+compaction_tap(void)
+{
+  sent++;
+  CHECK(out_intact(4 * out_seq() + 2));
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Reclaiming the first message stored moves all others down the arena. What
+ * we send afterwards must still be what we received. Lengths differ, so that
+ * nothing lands where it was by chance. A tick apart, so that every policy
+ * picks the first one
+ */
+static void
+test_arena_compaction(void)
+{
+  uint16_t seq;
+
+  setup();
+  for(seq = 1; seq <= ROLL_TM_BUFF_NUM + 1; seq++) {
+    datagram_from(SEED, seq, 0, 4 * seq + 2);
+    CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+    mock_run(1);
+  }
+
+  sent = 0;
+  mock_output_tap = compaction_tap;
+  mock_run(IMAX_0);
+  CHECK(sent >= ROLL_TM_BUFF_NUM);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * More seeds than windows. A new seed only gets one once an old seed's
+ * messages are past T_active. Until they are past T_dwell too, the old
+ * seed's tombstone still drops them
+ */
+static void
+test_window_reaping(void)
+{
+  uint8_t seed;
+
+  setup();
+  for(seed = 1; seed <= ROLL_TM_WINS; seed++) {
+    datagram_from(seed, 1, 0, sizeof(payload));
+    CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  }
+  datagram_from(seed, 1, 0, sizeof(payload));
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  CHECK_STAT("win_reaped", 0);
+
+  mock_run(ACTIVE_0 + IMAX_0);
+  datagram_from(seed, 1, 0, sizeof(payload));
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  CHECK_STAT("win_reaped", 1);
+
+  /* Seed 1 went first. Its old message is still a duplicate */
+  datagram_from(1, 1, 0, sizeof(payload));
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+
+  /* A new one isn't. It takes over seed 2's window */
+  datagram_from(1, 2, 0, sizeof(payload));
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  CHECK_STAT("win_reaped", 2);
+  datagram_from(2, 1, 0, sizeof(payload));
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+
+  /* Past T_dwell, the message would have expired anyway */
+  mock_run(DWELL_0 + IMAX_0);
+  datagram_from(2, 1, 0, sizeof(payload));
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  CHECK_STAT("win_reaped", 2);
+}
+/*---------------------------------------------------------------------------*/
+/* Benchmarks */
+static uint16_t bench_seq;
+/*---------------------------------------------------------------------------*/
+static void
+bench_in(void)
+{
+  /* Alternate between M=0 and M=1, the buffer fills up either way */
+  bench_seq++;
+  datagram(bench_seq & 0x7FFF, bench_seq & 1);
+  UIP_MCAST6.in();
+}
+/*---------------------------------------------------------------------------*/
+static void
+bench_icmp(void)
+{
+  static const uint16_t seqs[] = { 1, 2, 3, 4, 5, 6 };
+
+  icmp(0, seqs, 6);
+  mock_icmp6_input();
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  if(mock_bench_mode(argc, argv)) {
+    mock_init();
+    setup();
+    mock_bench("in, new seq", bench_in, 1000000);
+    mock_bench("ICMPv6 in", bench_icmp, 1000000);
+    return 0;
+  }
+
+  mock_test("accept", test_accept);
+  mock_test("bad datagrams", test_bad);
+  mock_test("too old", test_too_old);
+  mock_test("forward", test_forward);
+  mock_test("latency", test_latency);
+  mock_test("ICMPv6 in", test_icmp_in);
+  mock_test("bad ICMPv6", test_icmp_bad);
+  mock_test("out", test_out);
+  mock_test("ICMPv6 bitmap in", test_icmp_bitmap_in);
+  mock_test("ICMPv6 out", test_icmp_out);
+  mock_test("two seeds", test_two_seeds);
+  mock_test("reclaim", test_reclaim);
+  mock_test("arena compaction", test_arena_compaction);
+  mock_test("window reaping", test_window_reaping);
+  return mock_report();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,566 @@
+/*
+ * SMRF on a node with a preferred parent: fe80::2 in the DODAG rooted at
+ * aaaa::9, which also sources the datagrams
+ */
+#include "mock.h"
+#include "net/ipv6/multicast/uip-mcast6-adapt.h"
+#include "net/ipv6/multicast/uip-mcast6-telemetry.h"
+#include "net/rpl/rpl.h"
+
+#include <stdio.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#define ROOT    9
+#define PARENT  2
+#define OTHER   3
+/*---------------------------------------------------------------------------*/
+#define UIP_UDP_BUF ((struct uip_udp_hdr *)&uip_buf[UIP_LLIPH_LEN])
+/*---------------------------------------------------------------------------*/
+static uip_ipaddr_t group;
+static uint32_t seq;
+/*---------------------------------------------------------------------------*/
+/* A UDP datagram from the root to the group, as if it came from sender */
+static void
+datagram(uint8_t sender, uint8_t ttl)
+{
+  uip_ipaddr_t src;
+
+  mock_addr(&src, 0xaaaa, ROOT);
+  mock_ip(&src, &group, UIP_PROTO_UDP, ttl);
+  mock_udp(&seq, sizeof(seq));
+  mock_set_sender(sender);
+}
+/*---------------------------------------------------------------------------*/
+/* The same, after an RPL HBH option for the given instance */
+static void
+datagram_rpl(uint8_t sender, uint8_t instance_id)
+{
+  uip_ipaddr_t src;
+  uint8_t hbh[8] = { UIP_PROTO_UDP, 0, UIP_EXT_HDR_OPT_RPL, 4 };
+
+  hbh[5] = instance_id;
+  mock_addr(&src, 0xaaaa, ROOT);
+  mock_ip(&src, &group, UIP_PROTO_HBHO, 64);
+  mock_append(hbh, sizeof(hbh));
+  mock_udp(&seq, sizeof(seq));
+  mock_set_sender(sender);
+}
+/*---------------------------------------------------------------------------*/
+static void
+setup(void)
+{
+  uip_ip6addr(&group, 0xff1e, 0, 0, 0, 0, 0, 0x89, 0xabcd);
+  seq = 0;
+  mock_rpl_join(ROOT, PARENT);
+  UIP_MCAST6.init();
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_no_dodag(void)
+{
+  setup();
+  mock_rpl_leave();
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  CHECK_STAT("mcast_dropped", 1);
+  CHECK_STAT("parent_refresh", 0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_accept_from_parent(void)
+{
+  setup();
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  CHECK_STAT("mcast_in_all", 1);
+  CHECK_STAT("mcast_in_unique", 1);
+  CHECK_STAT("mcast_in_ours", 1);
+  CHECK_STAT("parent_refresh", 1);
+
+  /* Not a member: Not delivered, but still counted */
+  mock_member = 0;
+  seq++;
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  CHECK_STAT("mcast_in_unique", 2);
+  CHECK_STAT("mcast_in_ours", 1);
+
+  /* The parent's LL address is only looked up once */
+  CHECK_STAT("parent_refresh", 1);
+
+  /* No route, nothing to forward */
+  mock_run(CLOCK_SECOND);
+  CHECK(mock_out.count == 0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_drop_not_parent(void)
+{
+  setup();
+  datagram(OTHER, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  CHECK_STAT("mcast_dropped", 1);
+  CHECK_STAT("mcast_in_all", 0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_drop_ttl(void)
+{
+  setup();
+  datagram(PARENT, 1);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  CHECK_STAT("mcast_dropped", 1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_duplicate(void)
+{
+  setup();
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  CHECK_STAT("mcast_in_all", 2);
+  CHECK_STAT("mcast_in_unique", 1);
+  CHECK_STAT("mcast_dropped", 1);
+}
+/*---------------------------------------------------------------------------*/
+/* Without a UDP checksum, there's nothing to tell datagrams apart by */
+static void
+test_no_checksum(void)
+{
+  setup();
+  datagram(PARENT, 64);
+  UIP_UDP_BUF->udpchksum = 0;
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  seq++;
+  datagram(PARENT, 64);
+  UIP_UDP_BUF->udpchksum = 0;
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  CHECK_STAT("mcast_in_unique", 2);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_forward(void)
+{
+  struct uip_ip_hdr *out;
+
+  setup();
+  uip_mcast6_route_add(&group);
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  CHECK_STAT("mcast_fwd", 1);
+
+#if SMRF_MIN_FWD_DELAY
+  /* Not before D, not after D * spread */
+  CHECK(mock_out.count == 0);
+  mock_run(SMRF_MIN_FWD_DELAY - 1);
+  CHECK(mock_out.count == 0);
+  mock_run(SMRF_MIN_FWD_DELAY * SMRF_MAX_SPREAD);
+#else
+  /* Straight out, and delivered up the stack as it came in */
+  CHECK(((struct uip_ip_hdr *)uip_buf)->ttl == 64);
+#endif
+  CHECK(mock_out.count == 1);
+
+  out = (struct uip_ip_hdr *)mock_out.buf;
+  CHECK(mock_out.len == UIP_IPUDPH_LEN + sizeof(seq));
+  CHECK(out->ttl == 63);
+  CHECK(uip_ipaddr_cmp(&out->destipaddr, &group));
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_queue_full(void)
+{
+#if SMRF_MIN_FWD_DELAY
+  int i;
+
+  setup();
+  uip_mcast6_route_add(&group);
+  for(i = 0; i <= SMRF_FWD_QUEUE; i++) {
+    seq = i;
+    datagram(PARENT, 64);
+    CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  }
+  CHECK_STAT("fwd_queue_full", 1);
+  CHECK_STAT("fwd_queue_max", SMRF_FWD_QUEUE);
+  CHECK_STAT("mcast_fwd", SMRF_FWD_QUEUE);
+
+  mock_run(CLOCK_SECOND);
+  CHECK(mock_out.count == SMRF_FWD_QUEUE);
+
+  /* Room again */
+  seq++;
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  CHECK_STAT("mcast_fwd", SMRF_FWD_QUEUE + 1);
+#endif
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_parent_switch(void)
+{
+  setup();
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+
+  mock_rpl_join(ROOT, OTHER);
+  smrf_parent_switch(NULL, rpl_get_any_dag()->preferred_parent);
+
+  seq++;
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  datagram(OTHER, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  CHECK_STAT("parent_refresh", 2);
+}
+/*---------------------------------------------------------------------------*/
+/* Nobody told us about the switch: The project took the RPL callback */
+static void
+test_parent_switch_missed(void)
+{
+  setup();
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+
+  /* The first datagram from someone else makes us look */
+  mock_rpl_join(ROOT, OTHER);
+  seq++;
+  datagram(OTHER, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  CHECK_STAT("parent_refresh", 2);
+
+  /* Once caught up, the old parent is just another neighbour */
+  seq++;
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  CHECK_STAT("parent_refresh", 2);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_rpl_instance(void)
+{
+  setup();
+  datagram_rpl(PARENT, MOCK_RPL_INSTANCE_ID);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+
+  /* RPL doesn't know this instance */
+  seq++;
+  datagram_rpl(PARENT, 0x05);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+  CHECK_STAT("mcast_dropped", 1);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * A group with members in two instances: RPL adds the route for the first
+ * DAO and moves it to the other instance's DAG on the second. There is a
+ * single route, which forwards datagrams from both
+ */
+static void
+test_two_instances(void)
+{
+  uip_mcast6_route_t *rt;
+
+  setup();
+  mock_rpl_join_instance(0x05, ROOT, OTHER);
+  rt = uip_mcast6_route_add(&group);
+  rt->dag = rpl_get_instance(MOCK_RPL_INSTANCE_ID)->current_dag;
+  rt = uip_mcast6_route_add(&group);
+  rt->dag = rpl_get_instance(0x05)->current_dag;
+
+  datagram_rpl(PARENT, MOCK_RPL_INSTANCE_ID);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  CHECK_STAT("mcast_fwd", 1);
+  mock_run(CLOCK_SECOND);
+  seq++;
+  datagram_rpl(OTHER, 0x05);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  CHECK_STAT("mcast_fwd", 2);
+
+  /* Each instance has its own parent */
+  seq++;
+  datagram_rpl(OTHER, MOCK_RPL_INSTANCE_ID);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Groups that only differ in bytes 2 to 11 share a hash bucket. Removing one
+ * from the middle of the chain leaves the others reachable
+ */
+static void
+test_route_collision(void)
+{
+  uip_ipaddr_t g[3];
+  uip_mcast6_route_t *rt[3];
+  int i;
+
+  setup();
+  for(i = 0; i < 3; i++) {
+    uip_ip6addr(&g[i], 0xff1e, 0, i, 0, 0, 0, 0x89, 0xabcd);
+    rt[i] = uip_mcast6_route_add(&g[i]);
+    CHECK(rt[i] != NULL);
+  }
+  CHECK(uip_mcast6_route_count() == 3);
+  for(i = 0; i < 3; i++) {
+    CHECK(uip_mcast6_route_lookup(&g[i]) == rt[i]);
+  }
+
+  uip_mcast6_route_rm(rt[1]);
+  CHECK(uip_mcast6_route_lookup(&g[0]) == rt[0]);
+  CHECK(uip_mcast6_route_lookup(&g[1]) == NULL);
+  CHECK(uip_mcast6_route_lookup(&g[2]) == rt[2]);
+
+  /* The chain's head and tail */
+  uip_mcast6_route_rm(rt[2]);
+  CHECK(uip_mcast6_route_lookup(&g[0]) == rt[0]);
+  uip_mcast6_route_rm(rt[0]);
+  CHECK(uip_mcast6_route_lookup(&g[0]) == NULL);
+  CHECK(uip_mcast6_route_count() == 0);
+
+  /* A freed entry goes back into a bucket */
+  rt[1] = uip_mcast6_route_add(&g[1]);
+  CHECK(uip_mcast6_route_lookup(&g[1]) == rt[1]);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Per-group counters: One more datagram than the queue holds, a duplicate
+ * and one for a group without a route, which isn't counted anywhere
+ */
+static void
+test_group_stats(void)
+{
+#if UIP_MCAST6_GROUP_STATS
+  uip_mcast6_route_t *rt;
+  uip_mcast6_group_stats_t snap;
+  uip_ipaddr_t other;
+  int i;
+
+  setup();
+  rt = uip_mcast6_route_add(&group);
+  for(i = 0; i <= SMRF_FWD_QUEUE; i++) {
+    seq = i;
+    datagram(PARENT, 64);
+    CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  }
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_DROP);
+
+  uip_ipaddr_copy(&other, &group);
+  uip_ip6addr(&group, 0xff1e, 0, 0, 0, 0, 0, 0x89, 0x1234);
+  seq++;
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  uip_ipaddr_copy(&group, &other);
+
+  CHECK(rt->stats.in == SMRF_FWD_QUEUE + 1);
+#if SMRF_MIN_FWD_DELAY
+  CHECK(rt->stats.fwd == SMRF_FWD_QUEUE);
+  CHECK(rt->stats.dropped == 2);
+#else
+  CHECK(rt->stats.fwd == SMRF_FWD_QUEUE + 1);
+  CHECK(rt->stats.dropped == 1);
+#endif
+  CHECK(rt->stats.bytes ==
+        (SMRF_FWD_QUEUE + 1) * (UIP_IPUDPH_LEN + sizeof(seq)));
+
+  /* The snapshot has them all, the route starts over */
+  uip_mcast6_route_stats_snapshot(rt, &snap);
+  CHECK(snap.in == SMRF_FWD_QUEUE + 1);
+  CHECK(snap.bytes == (SMRF_FWD_QUEUE + 1) * (UIP_IPUDPH_LEN + sizeof(seq)));
+  CHECK(rt->stats.in == 0 && rt->stats.fwd == 0);
+  CHECK(rt->stats.dropped == 0 && rt->stats.bytes == 0);
+
+  mock_run(CLOCK_SECOND);
+  seq++;
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  CHECK(rt->stats.in == 1 && rt->stats.fwd == 1);
+#endif
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * uip_mcast6_stats_snapshot() resets the core counters. The engine's own
+ * ones are left alone
+ */
+static void
+test_stats_snapshot(void)
+{
+#if UIP_MCAST6_STATS
+  uip_mcast6_stats_t snap;
+  int i;
+
+  setup();
+  uip_mcast6_route_add(&group);
+  for(i = 0; i <= SMRF_FWD_QUEUE; i++) {
+    seq = i;
+    datagram(PARENT, 64);
+    UIP_MCAST6.in();
+  }
+
+  uip_mcast6_stats_snapshot(&snap);
+  CHECK(snap.mcast_in_unique == SMRF_FWD_QUEUE + 1);
+  CHECK(snap.engine_stats == uip_mcast6_stats.engine_stats);
+  CHECK_STAT("mcast_in_unique", 0);
+  CHECK_STAT("mcast_fwd", 0);
+#if SMRF_MIN_FWD_DELAY
+  CHECK_STAT("fwd_queue_full", 1);
+#endif
+  CHECK_STAT("parent_refresh", 1);
+#endif
+}
+/*---------------------------------------------------------------------------*/
+/* The forwarding delay goes into the latency histogram when it expires */
+static void
+test_latency(void)
+{
+#if UIP_MCAST6_STATS && UIP_MCAST6_STATS_LATENCY
+  clock_time_t start;
+
+  setup();
+  uip_mcast6_route_add(&group);
+  datagram(PARENT, 64);
+  start = mock_now;
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  while(mock_out.count == 0 && mock_now - start < CLOCK_SECOND) {
+    CHECK_LATENCY(UIP_MCAST6_LATENCY_FWD, 0, 0);
+    mock_run(1);
+  }
+  CHECK(mock_out.count == 1);
+  CHECK(mock_now - start >= SMRF_MIN_FWD_DELAY);
+  CHECK_LATENCY(UIP_MCAST6_LATENCY_FWD, mock_now - start, 1);
+  CHECK(mock_latency_total(UIP_MCAST6_LATENCY_ON_BEHALF) == 0);
+
+  /* A duplicate isn't forwarded, so there's nothing to record */
+  datagram(PARENT, 64);
+  UIP_MCAST6.in();
+  mock_run(CLOCK_SECOND);
+  CHECK(mock_latency_total(UIP_MCAST6_LATENCY_FWD) == 1);
+#endif
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * A telemetry record after some printf output, saved to MOCK_SERIAL_FILE for
+ * telemetry-check.py to decode. Counters are set to values which take 1, 2
+ * and 3 varint bytes and need SLIP escapes. Keep them in sync with the
+ * script
+ */
+static void
+test_telemetry(void)
+{
+#ifdef MOCK_SERIAL_FILE
+  /* Not from a previous build: The script only checks what we save */
+  remove(MOCK_SERIAL_FILE);
+#endif
+#if UIP_MCAST6_TELEMETRY
+  static const char text[] = "SMRF: Not a group member\n";
+  const char *c;
+  int i;
+
+  setup();
+  uip_mcast6_route_add(&group);
+  datagram(PARENT, 64);
+  CHECK(UIP_MCAST6.in() == UIP_MCAST6_ACCEPT);
+  mock_run(200 * CLOCK_SECOND);
+
+  uip_mcast6_stats.mcast_in_unique = 0;
+  uip_mcast6_stats.mcast_in_all = 127;
+  uip_mcast6_stats.mcast_in_ours = 128;
+  uip_mcast6_stats.mcast_fwd = 300;
+  uip_mcast6_stats.mcast_out = 0xC0;
+  uip_mcast6_stats.mcast_bad = 0xDB;
+  uip_mcast6_stats.mcast_dropped = 0xFFFF;
+#if UIP_MCAST6_STATS_LATENCY
+  for(i = 0; i < UIP_MCAST6_LATENCY_BUCKETS; i++) {
+    uip_mcast6_stats.latency[UIP_MCAST6_LATENCY_FWD][i] = i;
+    uip_mcast6_stats.latency[UIP_MCAST6_LATENCY_ON_BEHALF][i] = 0;
+  }
+#endif
+
+  for(c = text; *c; c++) {
+    mock_serial_writeb(*c);
+  }
+  uip_mcast6_telemetry_send();
+
+  /* A record ends where it starts, with an unescaped END */
+  CHECK(mock_serial.buf[sizeof(text) - 1] == 0xC0);
+  CHECK(mock_serial.buf[mock_serial.len - 1] == 0xC0);
+  for(i = sizeof(text); i < mock_serial.len - 1; i++) {
+    CHECK(mock_serial.buf[i] != 0xC0);
+  }
+  CHECK(mock_serial_save(MOCK_SERIAL_FILE));
+#endif
+}
+/*---------------------------------------------------------------------------*/
+/* Nothing but duplicates: The delay floor backs off up to its bound */
+static void
+test_adaptive(void)
+{
+#if SMRF_ADAPTIVE && UIP_MCAST6_STATS
+  uint32_t backoffs;
+  int i;
+
+  setup();
+  for(i = 0; i < 8 * UIP_MCAST6_ADAPT_WINDOW; i++) {
+    datagram(PARENT, 64);
+    UIP_MCAST6.in();
+  }
+  backoffs = mock_stat("adapt_backoff");
+  CHECK(backoffs > 0);
+
+  /* At the bound: No more backing off, and nothing to count */
+  for(i = 0; i < 2 * UIP_MCAST6_ADAPT_WINDOW; i++) {
+    datagram(PARENT, 64);
+    UIP_MCAST6.in();
+  }
+  CHECK_STAT("adapt_backoff", backoffs);
+#endif
+}
+/*---------------------------------------------------------------------------*/
+/* Benchmarks: A fresh datagram each time, or the same one over and over */
+static void
+bench_unique(void)
+{
+  seq++;
+  datagram(PARENT, 64);
+  UIP_MCAST6.in();
+}
+/*---------------------------------------------------------------------------*/
+static void
+bench_duplicate(void)
+{
+  datagram(PARENT, 64);
+  UIP_MCAST6.in();
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  if(mock_bench_mode(argc, argv)) {
+    mock_init();
+    setup();
+    mock_bench("in, unique", bench_unique, 1000000);
+    mock_bench("in, duplicate", bench_duplicate, 1000000);
+    return 0;
+  }
+
+  mock_test("no DODAG", test_no_dodag);
+  mock_test("accept from parent", test_accept_from_parent);
+  mock_test("drop not parent", test_drop_not_parent);
+  mock_test("drop TTL", test_drop_ttl);
+  mock_test("duplicate", test_duplicate);
+  mock_test("no checksum", test_no_checksum);
+  mock_test("forward", test_forward);
+  mock_test("queue full", test_queue_full);
+  mock_test("parent switch", test_parent_switch);
+  mock_test("parent switch, missed", test_parent_switch_missed);
+  mock_test("RPL instance", test_rpl_instance);
+  mock_test("two instances", test_two_instances);
+  mock_test("route collision", test_route_collision);
+  mock_test("group stats", test_group_stats);
+  mock_test("stats snapshot", test_stats_snapshot);
+  mock_test("latency", test_latency);
+  mock_test("telemetry", test_telemetry);
+  mock_test("adaptive", test_adaptive);
+  return mock_report();
+}
+/*---------------------------------------------------------------------------*/
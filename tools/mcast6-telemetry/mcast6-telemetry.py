@@ -0,0 +1,212 @@
+#!/usr/bin/env python3
+"""Decode binary multicast stats telemetry records.
+
+Reads the serial output of a node running uip_mcast6_telemetry_process
+(core/net/multicast/uip-mcast6-telemetry.h) and prints one JSON object per
+record. Anything between records, such as printf output, is skipped.
+
+Counter names come from the stats descriptor tables in the C sources, so
+point --src at the tree the node was built from if it isn't this one.
+
+    stty -F /dev/ttyUSB0 115200 raw
+    ./mcast6-telemetry.py /dev/ttyUSB0
+    ./mcast6-telemetry.py < serial.log
+"""
+
+import argparse
+import glob
+import json
+import os
+import re
+import sys
+
+VERSION = 2
+
+SLIP_END = 0xC0
+SLIP_ESC = 0xDB
+SLIP_ESC_END = 0xDC
+SLIP_ESC_ESC = 0xDD
+
+SECTION_CORE = 1
+SECTION_LATENCY = 2
+SECTION_ENGINE = 3
+
+# Engine codes, as in uip-mcast6-engines.h
+ENGINES = {0: "none", 1: "smrf", 2: "roll-tm", 3: "esmrf", 4: "mpl"}
+
+# Where the stats descriptor tables are, unless --src says otherwise
+SRC_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                       "..", "..", "core", "net", "multicast")
+
+# UIP_MCAST6_STATS_DESC(struct, field, flags)
+DESC_RE = re.compile(r"UIP_MCAST6_STATS_DESC\(\s*(\w+)\s*,\s*(\w+)\s*,")
+
+LATENCY_KINDS = ["fwd", "on_behalf"]
+
+
+class DecodeError(Exception):
+    pass
+
+
+def crc16_add(b, acc):
+    """Same as crc16_add() in Contiki's lib/crc16.c"""
+    acc ^= b
+    acc = ((acc >> 8) | (acc << 8)) & 0xFFFF
+    acc ^= (acc & 0xFF00) << 4
+    acc &= 0xFFFF
+    acc ^= (acc >> 8) >> 4
+    acc ^= (acc & 0xFF00) >> 5
+    return acc
+
+
+def layout(names):
+    """Same as layout() in uip-mcast6-telemetry.c"""
+    acc = 0
+    for name in names:
+        for b in name.encode() + b"\0":
+            acc = crc16_add(b, acc)
+    return acc
+
+
+def tables(src_dir):
+    """Map the layout of each stats descriptor table to its counter names"""
+    structs = {}
+    for path in sorted(glob.glob(os.path.join(src_dir, "*.c"))):
+        with open(path) as f:
+            for struct, field in DESC_RE.findall(f.read()):
+                structs.setdefault(struct, []).append(field)
+    return {layout(names): names for names in structs.values()}
+
+
+def frames(stream):
+    """Yield the unescaped contents of each SLIP frame in stream"""
+    buf = bytearray()
+    esc = False
+    while True:
+        chunk = stream.read(1)
+        if not chunk:
+            return
+        b = chunk[0]
+        if b == SLIP_END:
+            if buf:
+                yield bytes(buf)
+            buf = bytearray()
+            esc = False
+        elif esc:
+            buf.append({SLIP_ESC_END: SLIP_END,
+                        SLIP_ESC_ESC: SLIP_ESC}.get(b, b))
+            esc = False
+        elif b == SLIP_ESC:
+            esc = True
+        else:
+            buf.append(b)
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def byte(self):
+        if self.pos >= len(self.data):
+            raise DecodeError("truncated record")
+        b = self.data[self.pos]
+        self.pos += 1
+        return b
+
+    def varint(self):
+        v = 0
+        shift = 0
+        while True:
+            b = self.byte()
+            v |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                return v
+
+    def done(self):
+        return self.pos == len(self.data)
+
+
+def decode(frame, names_by_layout):
+    """Turn a frame into a dict. Raises DecodeError if it isn't a record"""
+    if len(frame) < 3:
+        raise DecodeError("short frame")
+    body, rx_crc = frame[:-2], (frame[-2] << 8) | frame[-1]
+    crc = 0
+    for b in body:
+        crc = crc16_add(b, crc)
+    if crc != rx_crc:
+        raise DecodeError("bad CRC")
+
+    r = Reader(body)
+    version = r.byte()
+    if version != VERSION:
+        raise DecodeError("unknown version %u" % version)
+    engine = r.byte()
+    rec = {
+        "engine": ENGINES.get(engine, engine),
+        "seq": r.byte(),
+        "uptime": r.varint(),
+    }
+    while not r.done():
+        section = r.byte()
+        n = r.byte()
+        if section in (SECTION_CORE, SECTION_ENGINE):
+            lay = (r.byte() << 8) | r.byte()
+        values = [r.varint() for _ in range(n)]
+        if section in (SECTION_CORE, SECTION_ENGINE):
+            names = names_by_layout.get(lay, [])
+            if len(names) != n:
+                # Built from sources other than the ones we read
+                rec.setdefault("unknown_layouts", []).append("%04x" % lay)
+                names = ["c%u" % i for i in range(n)]
+            key = "core" if section == SECTION_CORE else "engine_stats"
+            rec[key] = dict(zip(names, values))
+        elif section == SECTION_LATENCY:
+            n = len(values) // len(LATENCY_KINDS)
+            rec["latency"] = {k: values[i * n:(i + 1) * n]
+                              for i, k in enumerate(LATENCY_KINDS)}
+        else:
+            rec["section_%u" % section] = values
+    return rec
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", nargs="?", default="-",
+                        help="serial device or log file (default: stdin)")
+    parser.add_argument("-v", "--verbose", action="store_true",
+                        help="report frames which fail to decode")
+    parser.add_argument("--src", default=SRC_DIR,
+                        help="directory with the multicast engine sources "
+                        "(default: %(default)s)")
+    args = parser.parse_args()
+
+    names_by_layout = tables(args.src)
+    if not names_by_layout:
+        print("no stats descriptors in %s, counters will be unnamed" %
+              args.src, file=sys.stderr)
+
+    if args.input == "-":
+        stream = sys.stdin.buffer
+    else:
+        stream = open(args.input, "rb", buffering=0)
+
+    last = None
+    for frame in frames(stream):
+        try:
+            rec = decode(frame, names_by_layout)
+        except DecodeError as e:
+            if args.verbose:
+                print("skipped %u bytes: %s" % (len(frame), e),
+                      file=sys.stderr)
+            continue
+        if last is not None and rec["seq"] != (last + 1) & 0xFF:
+            rec["lost"] = (rec["seq"] - last - 1) & 0xFF
+        last = rec["seq"]
+        print(json.dumps(rec), flush=True)
+
+
+if __name__ == "__main__":
+    main()